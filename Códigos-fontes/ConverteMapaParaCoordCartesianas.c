@@ -3,33 +3,98 @@
 #include <string.h>
 #include <math.h>
 
-#define MAX_NODES 10000
-#define MAX_WAYS  5000
-#define MAX_WAY_NODES 100
-
-#define MAX_VERTICES 10000
-#define INFINITO 1000000000
 #define PI 3.14159265358979323846
+#define TAM_BLOCO_LEITURA (1 << 20)   // Bytes lidos do .osm por vez (o buffer s cresce se uma tag for maior)
 
 typedef struct {
     long long id_original;
-    double lat;
-    double lon;
     double x;
     double y;
-    int id_interno; // de 0 a n-1
-} Node;
-
-typedef struct {
-    int node_ids[MAX_WAY_NODES]; // ndices internos dos ns
-    int count;
-} Way;
+} Node;   // O id interno (de 0 a n-1)  a posio no vetor 'nodes'
 
-Node nodes[MAX_NODES];
+Node* nodes = NULL;
 int total_nodes = 0;
-
-Way ways[MAX_WAYS];
+int capacidade_nodes = 0;
+
+// Ns de cada via, em ndices internos e em sequncia: a via w ocupa
+// way_nodes[way_inicio[w] .. way_inicio[w + 1] - 1]
+int* way_nodes = NULL;
+int total_way_nodes = 0;
+int capacidade_way_nodes = 0;
+int* way_inicio = NULL;
 int total_ways = 0;
+int capacidade_ways = 0;
+
+// Sentido e velocidade de cada via, decididos ao fechar a via (as tags vm depois dos ns)
+int* way_direcao = NULL;          // 0 = mo dupla, 1 = mo nica no sentido dos ns
+double* way_velocidade = NULL;    // km/h
+int vias_lidas = 0;
+int vias_mao_unica = 0;
+
+// Arestas da sada, em ndices internos (pares origem, destino), e a via de onde cada uma saiu.
+// Com --compactar, a aresta i passa pelos ns edge_pontos[edge_inicio_pontos[i] .. edge_inicio_pontos[i + 1] - 1]
+// (gravados no .geo)
+int* edges = NULL;
+int* edge_via = NULL;
+int total_edges = 0;
+int capacidade_edges = 0;
+int* edge_inicio_pontos = NULL;
+int* edge_pontos = NULL;
+int total_edge_pontos = 0;
+int capacidade_edge_pontos = 0;
+
+// Tabela hash (endereamento aberto, sondagem linear) de id original -> ndice interno.
+// Guarda s o ndice; a chave  lida em nodes[indice].id_original
+int* tabela_ids = NULL;
+int bits_tabela = 0;
+
+// Classes de via (tag highway=*) conhecidas. S as roteveis entram no grafo; --vias troca o conjunto
+// e --velocidades grava a velocidade de cada aresta no .poly (o peso vira comprimento / velocidade)
+typedef struct {
+    const char* nome;
+    double velocidade;   // km/h, quando a via no tem maxspeed
+    int roteavel;        // Entra no grafo
+    int mao_unica;       // Mo nica mesmo sem a tag oneway
+} ClasseVia;
+
+ClasseVia classes[] = {
+    { "motorway",       110, 1, 1 },
+    { "motorway_link",   60, 1, 1 },
+    { "trunk",           90, 1, 0 },
+    { "trunk_link",      50, 1, 0 },
+    { "primary",         60, 1, 0 },
+    { "primary_link",    40, 1, 0 },
+    { "secondary",       50, 1, 0 },
+    { "secondary_link",  40, 1, 0 },
+    { "tertiary",        40, 1, 0 },
+    { "tertiary_link",   30, 1, 0 },
+    { "unclassified",    30, 1, 0 },
+    { "residential",     30, 1, 0 },
+    { "living_street",   10, 1, 0 },
+    { "service",         20, 1, 0 },
+    { "road",            30, 1, 0 },
+    { "track",           15, 0, 0 },
+    { "busway",          40, 0, 0 },
+    { "pedestrian",       5, 0, 0 },
+    { "footway",          5, 0, 0 },
+    { "path",             5, 0, 0 },
+    { "steps",            3, 0, 0 },
+    { "bridleway",        5, 0, 0 },
+    { "cycleway",        15, 0, 0 },
+};
+#define TOTAL_CLASSES ((int) (sizeof(classes) / sizeof(classes[0])))
+#define VELOCIDADE_SEM_CLASSE 30.0   // km/h das vias fora da tabela (s entram com --vias todas)
+
+int todas_as_vias = 0;      // --vias todas: qualquer via entra, com ou sem highway (comportamento antigo)
+int usar_velocidades = 0;   // --velocidades
+
+// Tags da via em leitura
+typedef struct {
+    int classe;        // Posio em 'classes', ou -1 se a via no tem highway ou a classe no est na tabela
+    int oneway;        // 1 = yes, -1 = sentido contrrio ao dos ns, 0 = no, 2 = sem a tag
+    int rotatoria;     // junction=roundabout/circular (mo nica implcita)
+    double maxspeed;   // km/h, 0 se ausente ou no numrico
+} TagsVia;
 
 
 // Parmetros da zona UTM 23S
@@ -41,111 +106,275 @@ const double k0 = 0.9996;
 const double lon0_deg = -45.0; // longitude central da zona 23S
 
 
+// realloc que encerra o programa se faltar memria
+void* realocar(void* p, size_t bytes)
+{
+    void* novo = realloc(p, bytes);
+    if (novo == NULL) {
+        printf("Memoria insuficiente para alocacao dinamica!\n");
+        exit(1);
+    }
+    return novo;
+}
+
+// Posio inicial de um id na tabela (hash multiplicativo de Fibonacci)
+static unsigned int posicao_hash(long long id)
+{
+    return (unsigned int) (((unsigned long long) id * 0x9E3779B97F4A7C15ULL) >> (64 - bits_tabela));
+}
+
+// Recria a tabela com o dobro de posies e reinsere todos os ns
+void crescer_tabela(void)
+{
+    bits_tabela = bits_tabela ? bits_tabela + 1 : 16;
+    unsigned int mascara = (1u << bits_tabela) - 1;
+    tabela_ids = realocar(tabela_ids, sizeof(int) << bits_tabela);
+    memset(tabela_ids, 0xff, sizeof(int) << bits_tabela);   // -1 em todas as posies
+    for (int i = 0; i < total_nodes; i++) {
+        unsigned int p = posicao_hash(nodes[i].id_original);
+        while (tabela_ids[p] != -1) p = (p + 1) & mascara;
+        tabela_ids[p] = i;
+    }
+}
+
 // Procura o ndice interno de um id original
 int get_node_index(long long id) {
-    for (int i = 0; i < total_nodes; i++) {
-        if (nodes[i].id_original == id)
-            return nodes[i].id_interno;
+    if (tabela_ids == NULL) return -1;
+    unsigned int mascara = (1u << bits_tabela) - 1;
+    for (unsigned int p = posicao_hash(id); tabela_ids[p] != -1; p = (p + 1) & mascara) {
+        if (nodes[tabela_ids[p]].id_original == id)
+            return tabela_ids[p];
     }
     return -1; // no encontrado
 }
 
-// Extrai valor de atributo entre aspas, ex: lat="..." ? retorna ...
-void extract_attr(const char* line, const char* key, char* value) {
-    char* p = strstr(line, key);
-    if (p) {
-        p = strchr(p, '\"');
-        if (p) {
-            p++;
-            char* q = strchr(p, '\"');
-            if (q) {
-                strncpy(value, p, q - p);
-                value[q - p] = '\0';
-            }
+// Acrescenta um n (ids repetidos so ignorados; vale o primeiro)
+void add_node(long long id, double x, double y)
+{
+    if (get_node_index(id) != -1) return;
+    if (total_nodes == capacidade_nodes) {
+        capacidade_nodes = capacidade_nodes ? 2 * capacidade_nodes : 4096;
+        nodes = realocar(nodes, sizeof(Node) * capacidade_nodes);
+    }
+    nodes[total_nodes].id_original = id;
+    nodes[total_nodes].x = x;
+    nodes[total_nodes].y = y;
+    total_nodes++;
+
+    // Carga mxima de 70%: cresce (e j insere o novo n) ou s insere
+    if ((long long) total_nodes * 10 > (7LL << bits_tabela)) {
+        crescer_tabela();
+    } else {
+        unsigned int mascara = (1u << bits_tabela) - 1;
+        unsigned int p = posicao_hash(id);
+        while (tabela_ids[p] != -1) p = (p + 1) & mascara;
+        tabela_ids[p] = total_nodes - 1;
+    }
+}
+
+// Acrescenta um n  via em leitura (aberta com begin_way)
+void add_way_node(int index)
+{
+    if (total_way_nodes == capacidade_way_nodes) {
+        capacidade_way_nodes = capacidade_way_nodes ? 2 * capacidade_way_nodes : 4096;
+        way_nodes = realocar(way_nodes, sizeof(int) * capacidade_way_nodes);
+    }
+    way_nodes[total_way_nodes++] = index;
+}
+
+void begin_way(void)
+{
+    if (total_ways + 1 >= capacidade_ways) {
+        capacidade_ways = capacidade_ways ? 2 * capacidade_ways : 1024;
+        way_inicio = realocar(way_inicio, sizeof(int) * capacidade_ways);
+        way_direcao = realocar(way_direcao, sizeof(int) * capacidade_ways);
+        way_velocidade = realocar(way_velocidade, sizeof(double) * capacidade_ways);
+    }
+    way_inicio[total_ways] = total_way_nodes;
+    vias_lidas++;
+}
+
+// Fecha a via em leitura. Vias com menos de dois ns encontrados ou fora das classes roteveis so
+// descartadas; as de oneway=-1 tm os ns invertidos, para que a mo nica siga a ordem dos ns
+void end_way(const TagsVia* tags)
+{
+    int inicio = way_inicio[total_ways];
+    int roteavel = todas_as_vias || (tags->classe != -1 && classes[tags->classe].roteavel);
+    if (total_way_nodes - inicio < 2 || !roteavel) {
+        total_way_nodes = inicio;
+        return;
+    }
+    int oneway = tags->oneway;
+    if (oneway == 2) oneway = tags->rotatoria || (tags->classe != -1 && classes[tags->classe].mao_unica);
+    if (oneway == -1) {
+        for (int i = inicio, j = total_way_nodes - 1; i < j; i++, j--) {
+            int t = way_nodes[i];
+            way_nodes[i] = way_nodes[j];
+            way_nodes[j] = t;
         }
     }
+    way_direcao[total_ways] = oneway != 0;
+    vias_mao_unica += oneway != 0;
+    way_velocidade[total_ways] = tags->maxspeed > 0 ? tags->maxspeed
+                               : tags->classe != -1 ? classes[tags->classe].velocidade : VELOCIDADE_SEM_CLASSE;
+    total_ways++;
+    way_inicio[total_ways] = total_way_nodes;
 }
 
-char *Left(char *str, int n)
+// Acrescenta uma aresta da via 'via'; os pontos intermedirios dela devem ter sido postos antes com add_edge_ponto
+void add_edge(int from, int to, int via)
 {
-	int i;
-	char *substr;
-	//substr = (char*) malloc(sizeof(char) * (strlen(str)+1));
-	
-	if ((substr = (char*) malloc(sizeof(char) * (strlen(str)+1))) == NULL) {
-		printf("Funcao Left: Memoria insuficiente para alocacao dinamica!\n");
-		system("pause > nul");
-		exit(1);  /* terminate program if out of memory */
-	}	
-	
-	for (i=0; i<n; i++)
-		substr[i] = str[i];
-	
-	substr[i] = '\0';
-	return(substr);
+    if (total_edges + 1 >= capacidade_edges) {
+        capacidade_edges = capacidade_edges ? 2 * capacidade_edges : 4096;
+        edges = realocar(edges, sizeof(int) * 2 * capacidade_edges);
+        edge_via = realocar(edge_via, sizeof(int) * capacidade_edges);
+        edge_inicio_pontos = realocar(edge_inicio_pontos, sizeof(int) * capacidade_edges);
+        if (total_edges == 0) edge_inicio_pontos[0] = 0;
+    }
+    edges[2 * total_edges] = from;
+    edges[2 * total_edges + 1] = to;
+    edge_via[total_edges] = via;
+    total_edges++;
+    edge_inicio_pontos[total_edges] = total_edge_pontos;
+}
+
+void add_edge_ponto(int index)
+{
+    if (total_edge_pontos == capacidade_edge_pontos) {
+        capacidade_edge_pontos = capacidade_edge_pontos ? 2 * capacidade_edge_pontos : 4096;
+        edge_pontos = realocar(edge_pontos, sizeof(int) * capacidade_edge_pontos);
+    }
+    edge_pontos[total_edge_pontos++] = index;
 }
 
 
-// Retorna uma substring de determinado tamanho a partir de uma posi��o
-char *Substr(char *s, int pos, int n)
+// ---- LEITURA DO XML ----
+// O .osm  lido em blocos e percorrido tag a tag, sem copiar nem alocar nada por linha ou por
+// atributo: cada tag  devolvida no prprio buffer, com o '>' trocado por '\0'.
+
+typedef struct {
+    FILE* arquivo;
+    char* buffer;
+    size_t capacidade;
+    size_t inicio, fim;   // Trecho ainda no percorrido: buffer[inicio..fim)
+    int terminou;         // Fim do arquivo alcanado
+} LeitorXml;
+
+// Traz mais dados do arquivo, preservando o trecho no percorrido (movido para o incio do buffer).
+// Retorna 0 no fim do arquivo
+int encher_buffer(LeitorXml* l)
 {
-  char *str;
-  int i;
+    size_t pendente = l->fim - l->inicio;
+    if (l->terminou) return 0;
+    memmove(l->buffer, l->buffer + l->inicio, pendente);
+    l->inicio = 0;
+    l->fim = pendente;
+    if (l->fim == l->capacidade) {   // Uma s tag maior que o buffer
+        l->capacidade *= 2;
+        l->buffer = realocar(l->buffer, l->capacidade);
+    }
+    size_t lidos = fread(l->buffer + l->fim, 1, l->capacidade - l->fim, l->arquivo);
+    l->fim += lidos;
+    if (lidos == 0) l->terminou = 1;
+    return lidos > 0;
+}
 
-	if ((str = (char *) malloc(strlen(s)+1)) == NULL) {
-    printf("Funcao Substr: Memoria insuficiente para alocacao dinamica!\n");
-    system("pause > nul");
-    exit(1);  /* terminate program if out of memory */
-  }
+// Prxima tag do arquivo: o texto entre '<' e '>' (ex.: "node id=\"1\" lat=..."), terminado em '\0'
+// e vlido at a prxima chamada. Retorna NULL no fim do arquivo
+char* proxima_tag(LeitorXml* l)
+{
+    for (;;) {
+        char* abre = memchr(l->buffer + l->inicio, '<', l->fim - l->inicio);
+        if (abre == NULL) {
+            l->inicio = l->fim;   // Texto entre tags: descarta
+            if (!encher_buffer(l)) return NULL;
+            continue;
+        }
+        l->inicio = abre - l->buffer;
+        char* fecha = memchr(abre + 1, '>', l->fim - l->inicio - 1);
+        if (fecha == NULL) {
+            if (!encher_buffer(l)) return NULL;   // Tag incompleta no fim do arquivo
+            continue;
+        }
+        *fecha = '\0';
+        l->inicio = fecha - l->buffer + 1;
+        return abre + 1;
+    }
+}
 
-  for (i=0; i<n; i++)
-    str[i] = s[pos+i];
+// Verifica se a tag tem o nome dado (ex.: "way" casa com "way id=..." e com "way", mas no com "wayx")
+int tag_e(const char* tag, const char* nome)
+{
+    size_t n = strlen(nome);
+    return strncmp(tag, nome, n) == 0 &&
+           (tag[n] == '\0' || tag[n] == ' ' || tag[n] == '\t' || tag[n] == '\r' || tag[n] == '\n' || tag[n] == '/');
+}
 
-  str[i] = '\0';
+// Valor do atributo 'nome' da tag (aspas simples ou duplas), apontando para dentro da prpria tag
+// e terminando na aspa de fechamento; NULL se a tag no tem o atributo
+const char* valor_atributo(const char* tag, const char* nome)
+{
+    size_t n = strlen(nome);
+    const char* p = tag;
+    while (*p && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;   // Pula o nome da tag
+    for (;;) {
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+        const char* inicioNome = p;
+        while (*p && *p != '=' && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+        size_t tamNome = p - inicioNome;
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+        if (*p != '=') return NULL;
+        p++;
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+        if (*p != '"' && *p != '\'') return NULL;
+        char aspa = *p++;
+        if (tamNome == n && strncmp(inicioNome, nome, n) == 0) return p;
+        p = strchr(p, aspa);
+        if (p == NULL) return NULL;
+        p++;
+    }
+}
 
-  return str;
+// Verifica se o valor de atributo (como devolvido por valor_atributo)  exatamente 'texto'
+int valor_e(const char* valor, const char* texto)
+{
+    size_t n = strlen(texto);
+    return strncmp(valor, texto, n) == 0 && (valor[n] == '"' || valor[n] == '\'');
 }
 
-// Retorna a posicao da ultima ocorrencia de uma substring
-int RAt(char *sub, char *string)
+// Posio da classe de via de nome 'nome' (terminado em 'fim') na tabela, ou -1
+int procurar_classe(const char* nome, const char* fim)
 {
-	int j;
- 	int pos = -1;
- 	int tamString, tamSub = strlen(sub);
-
- 	if (strstr(string, sub) != NULL) {
-		tamString = strlen(string);
-  	for (j=tamString-1; j >= 0; j--) {
-	 		if (stricmp(Substr(string, j, tamSub), sub) == 0) {
-				pos = j;
-    		break;
-   		}
-   		else
-  			pos = -1;
-		}
-	}
- 	return(pos);
+    for (int c = 0; c < TOTAL_CLASSES; c++) {
+        if (strlen(classes[c].nome) == (size_t) (fim - nome) && strncmp(classes[c].nome, nome, fim - nome) == 0)
+            return c;
+    }
+    return -1;
 }
 
-// Retorna a posicao da primeira ocorrencia de uma substring
-int At(char sub[], char string[])
+// Interpreta uma tag "<tag k=... v=...>" dentro de uma via
+void ler_tag_via(const char* tag, TagsVia* tags)
 {
-	int j;
-	int pos = -1;
-	int tamString, tamSub = strlen(sub);
-	
-	if (strstr(string, sub) != NULL) {
-		tamString = strlen(string);
-	  for (j=0; j<tamString; j++) {
-			if (strcmp(Substr(string, j, tamSub), sub) == 0) {
-		    pos = j;
-		    break;
-		  }
-		  else
-		    pos = -1;
-		}
-	}
- 	return(pos);
+    const char* k = valor_atributo(tag, "k");
+    const char* v = valor_atributo(tag, "v");
+    if (!k || !v) return;
+    if (valor_e(k, "highway")) {
+        const char* fim = v;
+        while (*fim && *fim != '"' && *fim != '\'') fim++;
+        tags->classe = procurar_classe(v, fim);
+    } else if (valor_e(k, "oneway")) {
+        if (valor_e(v, "yes") || valor_e(v, "true") || valor_e(v, "1")) tags->oneway = 1;
+        else if (valor_e(v, "-1") || valor_e(v, "reverse")) tags->oneway = -1;
+        else if (valor_e(v, "no") || valor_e(v, "false") || valor_e(v, "0")) tags->oneway = 0;
+    } else if (valor_e(k, "junction")) {
+        tags->rotatoria = valor_e(v, "roundabout") || valor_e(v, "circular");
+    } else if (valor_e(k, "maxspeed")) {
+        char* fim;
+        double kmh = strtod(v, &fim);
+        while (*fim == ' ') fim++;
+        if (strncmp(fim, "mph", 3) == 0) kmh *= 1.609344;
+        tags->maxspeed = kmh > 0 ? kmh : 0;
+    }
 }
 
 
@@ -196,73 +425,151 @@ void reduzirEscala(Node pontos[], int n, int redutor)
 
 
 
-void parse_osm(const char* filename) 
+// Nome do arquivo de sada: o do .osm com a extenso trocada por 'extensao' (ex.: ".poly")
+char* nome_saida(const char* filename, const char* extensao)
 {
-	char arqSaida[100];
-	int posPonto = RAt(".", filename);
+    const char* ponto = strrchr(filename, '.');
+    const char* barra = strrchr(filename, '/');
+    const char* contraBarra = strrchr(filename, '\\');
+    if (contraBarra > barra) barra = contraBarra;
+    size_t tamBase = (ponto && (!barra || ponto > barra)) ? (size_t) (ponto - filename) : strlen(filename);
+    char* arqSaida = realocar(NULL, tamBase + strlen(extensao) + 1);
+    memcpy(arqSaida, filename, tamBase);
+    strcpy(arqSaida + tamBase, extensao);
+    return arqSaida;
+}
 
-	strcpy(arqSaida, Left(filename, posPonto));
-	strcat(arqSaida, ".poly");
-	
-    FILE* f = fopen(filename, "r");
+// Uma aresta por par de ns consecutivos de cada via (todos os ns viram vrtices)
+void arestas_sem_compactar(int* numero)
+{
+    for (int i = 0; i < total_nodes; i++) numero[i] = i;
+    for (int w = 0; w < total_ways; w++) {
+        for (int j = way_inicio[w]; j < way_inicio[w + 1] - 1; j++) {
+            add_edge(way_nodes[j], way_nodes[j + 1], w);
+        }
+    }
+}
+
+// Compactao (--compactar): descarta os ns que nenhuma via usa e deixa como vrtices s os que
+// aparecem mais de uma vez nas vias (cruzamentos) e as pontas das vias. Cada trecho de via entre dois
+// vrtices vira uma aresta, e os ns do meio viram os seus pontos intermedirios (gravados no .geo),
+// de modo que a busca no precisa fechar um a um os pontos que s do forma  via.
+// numero[i] recebe o nmero do n i na sada, ou -1 se ele no  vrtice
+void arestas_compactadas(int* numero)
+{
+    int* usos = realocar(NULL, sizeof(int) * (total_nodes + 1));
+    memset(usos, 0, sizeof(int) * (total_nodes + 1));
+    for (int j = 0; j < total_way_nodes; j++) usos[way_nodes[j]]++;
+
+    // S os ns usados pelas vias continuam (na mesma ordem); a escala e a rotao abaixo consideram s eles
+    int usados = 0;
+    for (int i = 0; i < total_nodes; i++) {
+        if (usos[i] == 0) continue;
+        nodes[usados] = nodes[i];
+        usos[usados] = usos[i];
+        numero[i] = usados++;
+    }
+    for (int j = 0; j < total_way_nodes; j++) way_nodes[j] = numero[way_nodes[j]];
+    total_nodes = usados;
+
+    for (int w = 0; w < total_ways; w++) {
+        usos[way_nodes[way_inicio[w]]] = 2;
+        usos[way_nodes[way_inicio[w + 1] - 1]] = 2;
+    }
+    int vertices = 0;
+    for (int i = 0; i < total_nodes; i++) numero[i] = usos[i] >= 2 ? vertices++ : -1;
+
+    for (int w = 0; w < total_ways; w++) {
+        int inicio = way_nodes[way_inicio[w]];
+        for (int j = way_inicio[w] + 1; j < way_inicio[w + 1]; j++) {
+            int v = way_nodes[j];
+            if (v == way_nodes[j - 1]) continue;   // N repetido em sequncia na via
+            if (numero[v] == -1) {
+                add_edge_ponto(v);
+            } else {
+                add_edge(inicio, v, w);
+                inicio = v;
+            }
+        }
+    }
+    printf("Compactacao: %d nos usados pelas vias, %d vertices, %d arestas (%d pontos intermediarios).\n",
+           total_nodes, vertices, total_edges, total_edge_pontos);
+    free(usos);
+}
+
+void parse_osm(const char* filename, int compactar) 
+{
+    FILE* f = fopen(filename, "rb");
     if (!f) {
         perror("Erro ao abrir o arquivo");
         return;
     }
-    FILE* outFile = fopen(arqSaida, "w");
 
-    char line[1024];
+    LeitorXml leitor = { f, realocar(NULL, TAM_BLOCO_LEITURA), TAM_BLOCO_LEITURA, 0, 0, 0 };
     int inside_way = 0;
-    Way current_way;
-    current_way.count = 0;
+    TagsVia tags_via;
+    char* tag;
 
-    while (fgets(line, sizeof(line), f)) {
+    crescer_tabela();
+    while ((tag = proxima_tag(&leitor)) != NULL) {
         // Verifica se  um n
-        if (strstr(line, "<node") && strstr(line, "lat=") && strstr(line, "lon=")) {
-            char id_str[64], lat_str[64], lon_str[64];
-            extract_attr(line, "id=", id_str);
-            extract_attr(line, "lat=", lat_str);
-            extract_attr(line, "lon=", lon_str);
-
-            if (total_nodes < MAX_NODES) {
-                nodes[total_nodes].id_original = atoll(id_str);
-                nodes[total_nodes].lat = atof(lat_str);
-                nodes[total_nodes].lon = atof(lon_str);
-                
-                converter_para_utm(nodes[total_nodes].lat, nodes[total_nodes].lon, &nodes[total_nodes].x, &nodes[total_nodes].y);
-                
-                nodes[total_nodes].id_interno = total_nodes;
-                total_nodes++;
+        if (tag_e(tag, "node")) {
+            const char* id = valor_atributo(tag, "id");
+            const char* lat = valor_atributo(tag, "lat");
+            const char* lon = valor_atributo(tag, "lon");
+            if (id && lat && lon) {
+                double x, y;
+                converter_para_utm(strtod(lat, NULL), strtod(lon, NULL), &x, &y);
+                add_node(strtoll(id, NULL, 10), x, y);
             }
         }
 
-        // Verifica se  o incio de uma via
-        else if (strstr(line, "<way")) {
-            inside_way = 1;
-            current_way.count = 0;
+        // Verifica se  o incio de uma via (uma via vazia "<way .../>" no tem ns)
+        else if (tag_e(tag, "way")) {
+            inside_way = tag[strlen(tag) - 1] != '/';
+            if (inside_way) {
+                begin_way();
+                tags_via.classe = -1;
+                tags_via.oneway = 2;
+                tags_via.rotatoria = 0;
+                tags_via.maxspeed = 0;
+            }
         }
 
-        // Verifica se  um n dentro de uma via
-        else if (inside_way && strstr(line, "<nd")) {
-            char ref_str[64];
-            extract_attr(line, "ref=", ref_str);
-            long long ref_id = atoll(ref_str);
-            int index = get_node_index(ref_id);
-            if (index != -1 && current_way.count < MAX_WAY_NODES) {
-                current_way.node_ids[current_way.count++] = index;
-            }
+        // Tags da via (highway, oneway, junction, maxspeed)
+        else if (inside_way && tag_e(tag, "tag")) {
+            ler_tag_via(tag, &tags_via);
+        }
+
+        // Verifica se  um n dentro de uma via (refs a ns ausentes do arquivo so ignoradas)
+        else if (inside_way && tag_e(tag, "nd")) {
+            const char* ref = valor_atributo(tag, "ref");
+            int index = ref ? get_node_index(strtoll(ref, NULL, 10)) : -1;
+            if (index != -1) add_way_node(index);
         }
 
         // Fim de uma via
-        else if (inside_way && strstr(line, "</way>")) {
+        else if (inside_way && tag_e(tag, "/way")) {
             inside_way = 0;
-            if (current_way.count > 1 && total_ways < MAX_WAYS) {
-                ways[total_ways++] = current_way;
-            }
+            end_way(&tags_via);
         }
     }
-
     fclose(f);
+    free(leitor.buffer);
+    free(tabela_ids);
+    tabela_ids = NULL;
+    printf("Vias: %d lidas, %d no grafo (%d de mao unica).\n", vias_lidas, total_ways, vias_mao_unica);
+
+    if (total_nodes == 0) {
+        fprintf(stderr, "Nenhum no encontrado em \"%s\".\n", filename);
+        return;
+    }
+
+    int* numero = realocar(NULL, sizeof(int) * (total_nodes + 1));
+    if (compactar) arestas_compactadas(numero);
+    else arestas_sem_compactar(numero);
+    free(way_nodes);
+    way_nodes = NULL;
 
 	 //reduzirEscala(nodes, total_nodes, 5);
 	 reduzirEscala(nodes, total_nodes, 2);
@@ -281,52 +588,145 @@ void parse_osm(const char* filename)
 		nodes[i].y = maxY - nodes[i].y;	
 	}
 
-	 	  
-    // Imprime ns
-    //printf("Vrtices (ID interno, latitude, longitude):\n");
-    fprintf(outFile, "%d\t%d\t%d\t%d\n", total_nodes, 2, 0, 1);
+    char* arqSaida = nome_saida(filename, ".poly");
+    char* arqGeometria = nome_saida(filename, ".geo");
+    FILE* outFile = fopen(arqSaida, "w");
+    if (!outFile) {
+        perror("Erro ao criar o arquivo de saida");
+        free(arqSaida);
+        free(arqGeometria);
+        free(numero);
+        return;
+    }
+    setvbuf(outFile, NULL, _IOFBF, TAM_BLOCO_LEITURA);
+
+    // Imprime os vrtices, numerados de 0 a n-1
+    int total_vertices = 0;
     for (int i = 0; i < total_nodes; i++) {
-        fprintf(outFile, "%d\t%f\t%f\n", nodes[i].id_interno, nodes[i].x, nodes[i].y);
-        
+        if (numero[i] != -1) total_vertices++;
+    }
+    fprintf(outFile, "%d\t%d\t%d\t%d\n", total_vertices, 2, 0, 1);
+    for (int i = 0; i < total_nodes; i++) {
+        if (numero[i] != -1) fprintf(outFile, "%d\t%f\t%f\n", numero[i], nodes[i].x, nodes[i].y);
     }
 
-    // Imprime arestas
-    //printf("\nArestas (pares de vrtices consecutivos por via):\n");
-    int numID = 0;
-    for (int i = 0; i < total_ways; i++) {
-        for (int j = 0; j < ways[i].count - 1; j++) {
-				numID++;
-		  }
-	}
-    //printf("%d\t%d\n", numID, 1);
-    fprintf(outFile, "%d\t%d\n", numID, 1);
-    
-    numID = 0;
-    for (int i = 0; i < total_ways; i++) {
-        for (int j = 0; j < ways[i].count - 1; j++) {
-            int from = ways[i].node_ids[j];
-            int to = ways[i].node_ids[j + 1];
-            //printf("%d\t%d\t%d\t%d\n", numID++, from, to, 0);
-            fprintf(outFile, "%d\t%d\t%d\t%d\n", numID++, from, to, 0);
-            
-        }
+    // Imprime arestas: direo 1 nas vias de mo nica e, com --velocidades, a velocidade da via em km/h
+    fprintf(outFile, "%d\t%d\n", total_edges, 1);
+    for (int i = 0; i < total_edges; i++) {
+        int via = edge_via[i];
+        fprintf(outFile, "%d\t%d\t%d\t%d", i, numero[edges[2 * i]], numero[edges[2 * i + 1]], way_direcao[via]);
+        if (usar_velocidades) fprintf(outFile, "\t%g", way_velocidade[via]);
+        fprintf(outFile, "\n");
     }
-    //printf("%d\n", 0);
     fprintf(outFile, "%d\n", 0);
+    fclose(outFile); 
+
+    // Geometria das arestas compactadas: "<aresta> <k> <x1> <y1> ... <xk> <yk>" para as que tm
+    // pontos intermedirios. Sem compactar, um .geo antigo com o mesmo nome no vale mais para o .poly
+    if (compactar) {
+        FILE* geoFile = fopen(arqGeometria, "w");
+        if (!geoFile) {
+            perror("Erro ao criar o arquivo de geometria");
+        } else {
+            setvbuf(geoFile, NULL, _IOFBF, TAM_BLOCO_LEITURA);
+            int com_pontos = 0;
+            for (int i = 0; i < total_edges; i++) {
+                if (edge_inicio_pontos[i + 1] > edge_inicio_pontos[i]) com_pontos++;
+            }
+            fprintf(geoFile, "%d\n", com_pontos);
+            for (int i = 0; i < total_edges; i++) {
+                int k = edge_inicio_pontos[i + 1] - edge_inicio_pontos[i];
+                if (k == 0) continue;
+                fprintf(geoFile, "%d\t%d", i, k);
+                for (int j = edge_inicio_pontos[i]; j < edge_inicio_pontos[i + 1]; j++) {
+                    fprintf(geoFile, "\t%f\t%f", nodes[edge_pontos[j]].x, nodes[edge_pontos[j]].y);
+                }
+                fprintf(geoFile, "\n");
+            }
+            fclose(geoFile);
+        }
+    } else {
+        remove(arqGeometria);
+    }
     
     printf("Arquivo \"%s\" criado com sucesso.", arqSaida);
-    fclose(outFile); 
+    free(arqSaida);
+    free(arqGeometria);
+    free(numero);
 }
 
   
+// L a lista de --vias ("classe,classe,..." ou "todas"), que passa a ser o conjunto de classes roteveis
+int ler_vias(const char* lista)
+{
+    if (strcmp(lista, "todas") == 0) {
+        todas_as_vias = 1;
+        return 1;
+    }
+    for (int c = 0; c < TOTAL_CLASSES; c++) classes[c].roteavel = 0;
+    while (*lista) {
+        const char* fim = strchr(lista, ',');
+        if (fim == NULL) fim = lista + strlen(lista);
+        int c = procurar_classe(lista, fim);
+        if (c == -1) {
+            fprintf(stderr, "Classe de via desconhecida: \"%.*s\"\n", (int) (fim - lista), lista);
+            return 0;
+        }
+        classes[c].roteavel = 1;
+        lista = *fim ? fim + 1 : fim;
+    }
+    return 1;
+}
+
+// L a lista de --velocidades ("classe=km/h,..."), que troca a velocidade padro das classes dadas
+int ler_velocidades(const char* lista)
+{
+    while (*lista) {
+        const char* igual = strchr(lista, '=');
+        const char* fim = strchr(lista, ',');
+        if (fim == NULL) fim = lista + strlen(lista);
+        int c = (igual && igual < fim) ? procurar_classe(lista, igual) : -1;
+        char* fimNumero;
+        double kmh = c != -1 ? strtod(igual + 1, &fimNumero) : 0;
+        if (c == -1 || fimNumero != fim || !(kmh > 0)) {
+            fprintf(stderr, "Velocidade invalida: \"%.*s\" (use classe=km/h)\n", (int) (fim - lista), lista);
+            return 0;
+        }
+        classes[c].velocidade = kmh;
+        lista = *fim ? fim + 1 : fim;
+    }
+    return 1;
+}
+
 int main(int argc, char* argv[]) 
 {
-    if (argc != 2) {
-        fprintf(stderr, "Uso: %s arquivo.osm\n", argv[0]);
+    int compactar = 0;
+    int ok = argc >= 2;
+    for (int i = 2; ok && i < argc; i++) {
+        if (strcmp(argv[i], "--compactar") == 0) {
+            compactar = 1;
+        } else if (strcmp(argv[i], "--vias") == 0 && i + 1 < argc) {
+            ok = ler_vias(argv[++i]);
+        } else if (strcmp(argv[i], "--velocidades") == 0) {
+            usar_velocidades = 1;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) ok = ler_velocidades(argv[++i]);
+        } else {
+            ok = 0;
+        }
+    }
+    if (!ok) {
+        fprintf(stderr, "Uso: %s arquivo.osm [--compactar] [--vias classe,...|todas] [--velocidades [classe=km/h,...]]\n", argv[0]);
         return 1;
     }
-    parse_osm(argv[1]);
+    parse_osm(argv[1], compactar);
+    free(nodes);
+    free(way_inicio);
+    free(way_direcao);
+    free(way_velocidade);
+    free(edges);
+    free(edge_via);
+    free(edge_inicio_pontos);
+    free(edge_pontos);
     
     return 0;
 }
-
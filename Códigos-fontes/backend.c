@@ -1,274 +1,953 @@
 /*
     Projeto Final - AED2 - INF/UFG 2025-1
     Tema: Sistema de Navegao Primitivo
-    Back-end com Fila de Prioridade (Heap Mnima) e Lista de Adjacncia
+    Back-end de linha de comando sobre a biblioteca de rotas (nav.h / nav.c)
     Autores: Ana Luisa, Isadora, Lucas e Vernica
     Professor: Andr Luiz Moura
+
+    Compilao: gcc -O2 backend.c nav.c -o backend -lm   (com -fopenmp, o modo matriz usa todos os ncleos;
+                com -DNAV_METRICAS, saida.json e o comando METRICAS trazem os contadores das buscas)
 */
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
 #include <string.h>
-#include <time.h>
+#include "nav.h"
 
-#define MAX_VERTICES 10000   // Limite mximo de vrtices do grafo, para suportar grafos grandes
-#define INF 1e9             // Valor usado para representar distncia "infinita" (inacessvel)
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>      // _setmode, para a sada binria do modo servidor
+#endif
 
-// ------------------------ ESTRUTURAS ------------------------ //
-// Representa uma aresta na lista encadeada de adjacncia
-typedef struct Aresta {
-    int destino;           // ndice do vrtice destino da aresta
-    double peso;           // Peso da aresta, aqui calculado pela distncia Euclidiana
-    struct Aresta* prox;   // Ponteiro para a prxima aresta na lista encadeada
-} Aresta;
+#define CACHE_PADRAO_MB 64   // Memria do cache de rvores por origem no modo servidor (comando CACHE)
+#define ALTERNATIVAS_PADRAO 3        // Rotas do comando ALTERNATIVAS, contando a de menor custo
+#define SOBREPOSICAO_PADRAO 0.8      // Frao mxima do custo de uma alternativa em trechos das anteriores
+#define ESTICAMENTO_PADRAO 1.25      // Custo mximo de uma alternativa em relao  rota de menor custo
 
-// Representa um vrtice do grafo
-typedef struct {
-    int id;                // ID original do vrtice conforme o arquivo .poly
-    double x, y;           // Coordenadas do vrtice no plano cartesiano
-    Aresta* lista;         // Ponteiro para a lista encadeada de arestas adjacentes (lista de adjacncia)
-} Vertice;
+// ------------------------ SADA EM TEXTO ------------------------ //
+// Escreve o resultado de uma consulta no formato texto de saida.txt
+void escreverSaida(FILE* saida, const NavGrafo* g, NavId origemId, NavId destinoId, int modo, const NavResultado* r) {
+    // Se custo for infinito, no existe caminho
+    if (r->custo >= NAV_INF) {
+        fprintf(saida, "No existe caminho entre %lld e %lld\n", origemId, destinoId);
+    } else {
+        // Escreve custo total, ns explorados e caminho detalhado no arquivo
+        fprintf(saida, "Custo total do caminho: %.2lf unidades\n", r->custo);
+        fprintf(saida, "Ns explorados: %d\n", r->nosExplorados);
+        fprintf(saida, "Algoritmo: %s\n", navNomeModo(modo));
+        fprintf(saida, "\nCaminho (do incio ao fim):\n");
+        for (int i = 0; i < r->tamCaminho; i++) {
+            double x, y;
+            navCoordenadas(g, r->caminho[i], &x, &y);
+            fprintf(saida, "%lld (x=%.3lf, y=%.3lf)\n", r->caminho[i], x, y);
+        }
+    }
+    fprintf(saida, "\nTempo de execuo: %.4lf segundos\n", r->tempo);
+}
 
-// Nodo para a heap mnima utilizada no algoritmo de Dijkstra
-typedef struct {
-    int id;                // ndice do vrtice no grafo
-    double dist;           // Distncia acumulada do vrtice origem at este vrtice
-} NodoHeap;
-
-// ------------------------ VARIVEIS GLOBAIS ------------------------ //
-Vertice grafo[MAX_VERTICES];  // Vetor que armazena todos os vrtices do grafo
-int totalVertices = 0;        // Quantidade atual de vrtices carregados no grafo
-int totalArestas = 0;         // Quantidade atual de arestas carregadas no grafo
-
-// Mapeamento do ID original dos vrtices (do arquivo .poly) para ndice interno no vetor 'grafo'
-// Inicializado com -1 para detectar IDs invlidos ou no mapeados
-int idParaIndice[MAX_VERTICES];
-
-// ------------------------ FUNES AUXILIARES ------------------------ //
-// Calcula a distncia Euclidiana entre dois vrtices dados pelos seus ndices internos
-double distancia(int a, int b) {
-    double dx = grafo[a].x - grafo[b].x;  // Diferena em x
-    double dy = grafo[a].y - grafo[b].y;  // Diferena em y
-    return sqrt(dx*dx + dy*dy);            // Distncia Euclidiana (hipotenusa)
+// Escreve o mesmo resultado em JSON (saida.json), com a diviso dos tempos entre carga, busca e
+// montagem do caminho e os contadores da busca. Os contadores s tm valores com a biblioteca
+// compilada com -DNAV_METRICAS ("coletados": false caso contrrio)
+void escreverSaidaJson(FILE* saida, const NavGrafo* g, NavId origemId, NavId destinoId, int modo,
+                       const NavResultado* r, const NavMetricas* m) {
+    NavInfo info;
+    navInfo(g, &info);
+    int existe = r->custo < NAV_INF;
+    fprintf(saida, "{\n");
+    fprintf(saida, "  \"origem\": %lld,\n  \"destino\": %lld,\n  \"algoritmo\": \"%s\",\n", origemId, destinoId,
+            navNomeModo(modo));
+    fprintf(saida, "  \"existe_caminho\": %s,\n", existe ? "true" : "false");
+    if (existe) fprintf(saida, "  \"custo\": %.6lf,\n", r->custo);
+    else fprintf(saida, "  \"custo\": null,\n");
+    fprintf(saida, "  \"nos_explorados\": %d,\n  \"caminho\": [", r->nosExplorados);
+    for (int i = 0; i < r->tamCaminho; i++) fprintf(saida, i ? ", %lld" : "%lld", r->caminho[i]);
+    fprintf(saida, "],\n");
+    fprintf(saida, "  \"tempos_s\": {\"leitura\": %.9lf, \"construcao_csr\": %.9lf, \"busca\": %.9lf, "
+                   "\"caminho\": %.9lf, \"consulta\": %.9lf},\n",
+            info.tempoLeitura, info.tempoConstrucaoCSR, m->tempoBusca, m->tempoCaminho, r->tempo);
+    fprintf(saida, "  \"contadores\": {\"coletados\": %s, \"arestas_relaxadas\": %ld, \"insercoes\": %ld, "
+                   "\"diminuicoes\": %ld, \"extracoes\": %ld, \"extracoes_obsoletas\": %ld, \"maior_fila\": %ld},\n",
+            m->coletadas ? "true" : "false", m->arestasRelaxadas, m->insercoes, m->diminuicoes, m->extracoes,
+            m->extracoesObsoletas, m->maiorFila);
+    fprintf(saida, "  \"memoria_bytes\": {\"grafo\": %lld, \"espaco_busca\": %lld}\n}\n",
+            info.bytesAlocados, m->bytesEspaco);
 }
 
-// Adiciona uma aresta no grafo, criando uma lista de adjacncia para o vrtice origem
-// Se direcao == 0, a aresta  bidirecional, ento adiciona tambm a aresta inversa no destino
-void adicionarAresta(int origem, int destino, int direcao) {
-    // Cria nova aresta para o vrtice origem
-    Aresta* nova = malloc(sizeof(Aresta));
-    nova->destino = destino;
-    nova->peso = distancia(origem, destino);  // Peso  a distncia Euclidiana calculada
-    nova->prox = grafo[origem].lista;         // Insere no incio da lista encadeada
-    grafo[origem].lista = nova;
-
-    if (direcao == 0) {
-        // Cria a aresta inversa para grafo no direcionado (bidirecional)
-        Aresta* inversa = malloc(sizeof(Aresta));
-        inversa->destino = origem;
-        inversa->peso = nova->peso;            // Peso igual  aresta original
-        inversa->prox = grafo[destino].lista;
-        grafo[destino].lista = inversa;
+// Escreve a matriz no formato texto de matriz.txt: uma linha por origem, "-" quando no h caminho
+void escreverMatriz(FILE* saida, const NavId* origensIds, const NavId* destinosIds, const NavMatriz* md) {
+    fprintf(saida, "Matriz de distncias: %d origens x %d destinos\n", md->totalOrigens, md->totalDestinos);
+    fprintf(saida, "\norigem\\destino");
+    for (int j = 0; j < md->totalDestinos; j++) fprintf(saida, "\t%lld", destinosIds[j]);
+    fprintf(saida, "\n");
+    for (int i = 0; i < md->totalOrigens; i++) {
+        fprintf(saida, "%lld", origensIds[i]);
+        for (int j = 0; j < md->totalDestinos; j++) {
+            double c = md->custos[(long)i * md->totalDestinos + j];
+            if (c >= NAV_INF) fprintf(saida, "\t-");
+            else fprintf(saida, "\t%.2lf", c);
+        }
+        fprintf(saida, "\n");
+    }
+
+    if (md->caminhos) {
+        fprintf(saida, "\nCaminhos (IDs do incio ao fim):\n");
+        for (int i = 0; i < md->totalOrigens; i++) {
+            for (int j = 0; j < md->totalDestinos; j++) {
+                long c = (long)i * md->totalDestinos + j;
+                fprintf(saida, "%lld -> %lld:", origensIds[i], destinosIds[j]);
+                if (md->tamCaminhos[c] == 0) fprintf(saida, " sem caminho");
+                for (int k = 0; k < md->tamCaminhos[c]; k++) fprintf(saida, " %lld", md->caminhos[c][k]);
+                fprintf(saida, "\n");
+            }
+        }
     }
+    fprintf(saida, "\nNs explorados: %ld\n", md->nosExplorados);
+    fprintf(saida, "Tempo de execuo: %.4lf segundos (%d threads)\n", md->tempo, md->threads);
 }
 
-// ------------------------ HEAP MNIMA ------------------------ //
-// Array que representa a heap mnima para organizar os vrtices conforme distncia acumulada
-NodoHeap heap[MAX_VERTICES];
+// ------------------------ SADA BINRIA ------------------------ //
+// Quadro de resposta do comando ROTA no formato binrio do servidor (comando FORMATO binario): o
+// cabealho abaixo, na ordem de bytes da mquina, seguido de tamCaminho IDs de 8 bytes, de tamCaminho
+// pares x, y em double (se coordenadas == 1) e, em QUADRO_ERRO, de tamMensagem bytes de texto.
+// O cliente l os IDs de uma vez, sem converter texto vrtice a vrtice
+#define ASSINATURA_QUADRO "NAVR"
+enum { QUADRO_OK = 0, QUADRO_SEM_CAMINHO = 1, QUADRO_ERRO = 2 };
+
+typedef struct {
+    char assinatura[4];
+    int status;          // QUADRO_OK, QUADRO_SEM_CAMINHO ou QUADRO_ERRO
+    int nosExplorados;
+    int tamCaminho;
+    int coordenadas;
+    int tamMensagem;
+    double custo;
+    double tempo;
+} QuadroRota;
 
-// posHeap mapeia o ndice do vrtice para sua posio atual dentro da heap
-// usado para encontrar a posio rpida de um vrtice e atualizar sua distncia
-int posHeap[MAX_VERTICES];
+// Escreve o quadro binrio de uma consulta; com erro != NULL, o quadro s traz a mensagem.
+// Os IDs saem direto do vetor do resultado, sem cpia
+void escreverQuadroRota(FILE* saida, const NavGrafo* g, const NavResultado* r, int coordenadas, const char* erro) {
+    QuadroRota q;
+    memset(&q, 0, sizeof(q));
+    memcpy(q.assinatura, ASSINATURA_QUADRO, 4);
+    if (erro) {
+        q.status = QUADRO_ERRO;
+        q.tamMensagem = (int)strlen(erro);
+    } else {
+        q.status = r->custo >= NAV_INF ? QUADRO_SEM_CAMINHO : QUADRO_OK;
+        q.nosExplorados = r->nosExplorados;
+        q.tamCaminho = q.status == QUADRO_OK ? r->tamCaminho : 0;
+        q.coordenadas = coordenadas;
+        q.custo = r->custo;
+        q.tempo = r->tempo;
+    }
+    fwrite(&q, sizeof(q), 1, saida);
+    if (q.tamCaminho) fwrite(r->caminho, sizeof(NavId), q.tamCaminho, saida);
+    if (q.tamCaminho && coordenadas) {
+        double pontos[512];   // Pares x, y em blocos, para no alocar por consulta
+        for (int i = 0; i < q.tamCaminho; i += 256) {
+            int bloco = q.tamCaminho - i < 256 ? q.tamCaminho - i : 256;
+            for (int j = 0; j < bloco; j++) navCoordenadas(g, r->caminho[i + j], &pontos[2 * j], &pontos[2 * j + 1]);
+            fwrite(pontos, sizeof(double), 2 * bloco, saida);
+        }
+    }
+    if (q.tamMensagem) fwrite(erro, 1, q.tamMensagem, saida);
+}
 
-// Tamanho atual da heap
-int tamHeap = 0;
+// Imprime o consumo de memria da adjacncia e os tempos de leitura/construo do grafo carregado
+// Para comparao, estima tambm o custo da antiga lista encadeada (um malloc por aresta dirigida)
+void imprimirEstatisticas(const NavGrafo* g, const char* nome) {
+    NavInfo info;
+    navInfo(g, &info);
+    size_t bytesCSR = (size_t)(info.totalVertices + 1) * sizeof(int)
+                    + (size_t)info.totalArestasDirigidas * (sizeof(int) + sizeof(double));
+    size_t bytesNodoLista = sizeof(int) + sizeof(double) + sizeof(void*);   // destino, peso e prox
+    bytesNodoLista = (bytesNodoLista + 7) & ~(size_t)7;                    // alinhamento da struct
+    size_t bytesLista = (size_t)info.totalVertices * sizeof(void*)
+                      + (size_t)info.totalArestasDirigidas * (bytesNodoLista + 8); // + cabealho do malloc
 
-// Troca os elementos na heap nas posies i e j, e atualiza posHeap para manter coerncia
-void trocar(int i, int j) {
-    NodoHeap tmp = heap[i];
-    heap[i] = heap[j];
-    heap[j] = tmp;
-    posHeap[heap[i].id] = i;
-    posHeap[heap[j].id] = j;
+    printf("Arquivo: %s\n", nome);
+    printf("Vrtices: %d | Arestas no .poly: %d | Arestas dirigidas: %d\n",
+           info.totalVertices, info.totalArestas, info.totalArestasDirigidas);
+    printf("Memria da adjacncia CSR: %zu bytes (%.1f bytes/aresta), mais o mesmo para a reversa\n", bytesCSR,
+           info.totalArestasDirigidas ? (double)bytesCSR / info.totalArestasDirigidas : 0.0);
+    printf("Memria estimada da lista encadeada: %zu bytes (%.1f bytes/aresta)\n", bytesLista,
+           info.totalArestasDirigidas ? (double)bytesLista / info.totalArestasDirigidas : 0.0);
+    printf("Tempo de leitura do arquivo: %.6lf s | Tempo de construo CSR: %.6lf s\n",
+           info.tempoLeitura, info.tempoConstrucaoCSR);
+    printf("Componentes fortemente conexas: %d | Componentes fracamente conexas: %d\n",
+           info.totalComponentesFortes, info.totalComponentesFracas);
+    printf("Ordem dos vrtices na memria: %s\n", navNomeOrdem(info.ordemVertices));
+    if (info.pontosGeometria > 0)
+        printf("Pontos intermedirios das arestas (.geo): %d\n", info.pontosGeometria);
+    if (info.fatorHeuristica < 1)
+        printf("Fator da heurstica (pesos por velocidade): %g\n", info.fatorHeuristica);
+    if (info.bytesAlocados > 0)
+        printf("Bytes alocados na carga (com os temporrios): %lld\n", info.bytesAlocados);
 }
 
-// Sobe um elemento na heap para garantir a propriedade de heap mnima
-// enquanto o elemento estiver menor que o seu pai, troca com o pai
-void subir(int i) {
-    while (i > 0 && heap[i].dist < heap[(i - 1) / 2].dist) {
-        trocar(i, (i - 1) / 2);
-        i = (i - 1) / 2;
+// Converte uma lista de IDs separados por vrgula (ex.: "10,25,31") em um vetor de IDs
+// Retorna a quantidade de IDs lidos, ou -1 se algum ID no pertencer ao grafo ou faltar memria
+// O vetor *ids  alocado aqui e deve ser liberado por quem chamou
+int lerListaIds(const NavGrafo* g, const char* texto, NavId** ids) {
+    int capacidade = 1;
+    for (const char* c = texto; *c; c++) if (*c == ',') capacidade++;
+    *ids = malloc(capacidade * sizeof(NavId));
+    if (!*ids) return -1;
+
+    int total = 0;
+    const char* c = texto;
+    while (*c) {
+        char* fim;
+        long long id = strtoll(c, &fim, 10);
+        if (fim == c || !navContemId(g, id) || (*fim != ',' && *fim != '\0')) {
+            free(*ids);
+            *ids = NULL;
+            return -1;
+        }
+        (*ids)[total++] = id;
+        c = *fim == ',' ? fim + 1 : fim;
     }
+    return total;
 }
 
-// Desce um elemento na heap para garantir a propriedade de heap mnima
-// compara com filhos e troca com o menor deles se necessrio
-void descer(int i) {
-    int menor = i;
-    int esq = 2 * i + 1, dir = 2 * i + 2;
-    if (esq < tamHeap && heap[esq].dist < heap[menor].dist) menor = esq;
-    if (dir < tamHeap && heap[dir].dist < heap[menor].dist) menor = dir;
-    if (menor != i) {
-        trocar(i, menor);
-        descer(menor);
+// Converte uma lista de pares aresta:fator separados por vrgula (ex.: "7:1.5,12:inf") nos vetores de
+// IDs de arestas e de fatores do comando PESOS. Retorna a quantidade de pares, ou -1 se a lista estiver
+// mal formada ou faltar memria. Os vetores so alocados aqui e devem ser liberados por quem chamou
+int lerListaPesos(const char* texto, NavId** arestas, double** fatores) {
+    int capacidade = 1;
+    for (const char* c = texto; *c; c++) if (*c == ',') capacidade++;
+    *arestas = malloc(capacidade * sizeof(NavId));
+    *fatores = malloc(capacidade * sizeof(double));
+    int total = 0, completa = 0;
+    const char* c = texto;
+    // Cada vrgula exige outro par depois dela: "7:1.5,"  recusada
+    while (*arestas && *fatores && !completa) {
+        char* fim;
+        long long id = strtoll(c, &fim, 10);
+        if (fim == c || *fim != ':') break;
+        const char* inicioFator = fim + 1;
+        double fator = strtod(inicioFator, &fim);
+        if (fim == inicioFator || (*fim != ',' && *fim != '\0')) break;
+        (*arestas)[total] = id;
+        (*fatores)[total++] = fator;
+        completa = *fim == '\0';
+        c = completa ? fim : fim + 1;
     }
+    if (!*arestas || !*fatores || !completa) {
+        free(*arestas);
+        free(*fatores);
+        *arestas = NULL;
+        *fatores = NULL;
+        return -1;
+    }
+    return total;
 }
 
-// Insere um novo vrtice na heap, colocando-o no final e subindo para a posio correta
-void inserirHeap(int id, double dist) {
-    heap[tamHeap].id = id;
-    heap[tamHeap].dist = dist;
-    posHeap[id] = tamHeap;
-    subir(tamHeap);
-    tamHeap++;
+// Sorteia um ndice em [0, n) com um gerador congruente linear de 64 bits, para que os pares
+// sorteados sejam os mesmos em qualquer plataforma (o RAND_MAX do Windows  s 32767)
+int sortearIndice(unsigned long long* estado, int n) {
+    *estado = *estado * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (int)((*estado >> 33) % (unsigned long long)n);
 }
 
-// Remove e retorna o vrtice com menor distncia acumulada da heap (raiz da heap)
-int extrairMin() {
-    int min = heap[0].id;         // Vrtice da raiz da heap (menor distncia)
-    heap[0] = heap[--tamHeap];    // Move ltimo elemento para a raiz
-    posHeap[heap[0].id] = 0;      // Atualiza posio do elemento que foi para a raiz
-    descer(0);                    // Ajusta a heap descendo o elemento
-    return min;                   // Retorna o vrtice removido (menor distncia)
+// Roda as mesmas consultas (pares sorteados com semente fixa) com cada tipo de fila e imprime o
+// tempo e os contadores de operaes de cada um, para escolher a fila mais rpida para o mapa
+void compararFilas(const NavGrafo* g, int consultas, int modo) {
+    NavInfo info;
+    navInfo(g, &info);
+    printf("%d consultas no modo %s, %d vrtices\n", consultas, navNomeModo(modo), info.totalVertices);
+    for (int tipo = 0; tipo < TOTAL_TIPOS_FILA; tipo++) {
+        NavEspaco* e = navCriarEspaco(g);
+        if (!e || navDefinirFila(e, tipo) != NAV_OK) {
+            printf("%-12s: memria insuficiente\n", navNomeTipoFila(tipo));
+            navLiberarEspaco(e);
+            continue;
+        }
+        unsigned long long estado = 42;
+        double tempo = 0, custoTotal = 0;
+        long nos = 0;
+        int semCaminho = 0;
+        for (int i = 0; i < consultas; i++) {
+            NavId origem, destino;
+            NavResultado r;
+            navIdVertice(g, sortearIndice(&estado, info.totalVertices), &origem);
+            navIdVertice(g, sortearIndice(&estado, info.totalVertices), &destino);
+            if (navRota(g, e, origem, destino, modo, &r) != NAV_OK) {
+                printf("%-12s: pr-processamento do modo %s no carregado\n", navNomeTipoFila(tipo), navNomeModo(modo));
+                break;
+            }
+            tempo += r.tempo;
+            nos += r.nosExplorados;
+            if (r.custo >= NAV_INF) semCaminho++;
+            else custoTotal += r.custo;
+        }
+        NavContadoresFila c;
+        navContadoresFila(e, &c);
+        printf("%-12s: %.4lf s | ns %ld | custo total %.3lf (%d sem caminho) | inseres %ld | "
+               "diminuies %ld | extraes %ld | maior fila %ld\n", navNomeTipoFila(tipo), tempo, nos,
+               custoTotal, semCaminho, c.insercoes, c.diminuicoes, c.extracoes, c.maiorTamanho);
+        navLiberarEspaco(e);
+    }
 }
 
-// Atualiza a distncia de um vrtice na heap e sobe ele para a posio correta
-void diminuirChave(int id, double novaDist) {
-    int i = posHeap[id];
-    heap[i].dist = novaDist;
-    subir(i);
+// ------------------------ MODO SERVIDOR ------------------------ //
+// Mantm o grafo carregado e responde consultas lidas da entrada padro, uma por linha.
+// Protocolo (respostas em ASCII, exceto os quadros de ROTA com FORMATO binario; sempre terminadas com fflush):
+//   CARREGAR <arquivo.poly>  -> OK <vertices> <arestas> | ERRO <mensagem>
+//                               (a hierarquia <arquivo>.ch e os landmarks <arquivo>.alt tambm so
+//                               carregados, se existirem)
+//   ROTA <origem> <destino> [modo]
+//                            -> OK <custo> <nos> <tempo> <tam> seguido de uma linha com os <tam> IDs do caminho
+//                               SEM_CAMINHO <nos> <tempo> | ERRO <mensagem>
+//                               modo: dijkstra (padro), parada, astar, bidirecional, astar_bidirecional, ch ou alt
+//   ALTERNATIVAS <origem> <destino> [k] [sobreposicao] [esticamento]
+//                            -> OK <total> <nos> <tempo> seguido de uma linha por rota, a de menor custo
+//                               primeiro e as demais em ordem de custo, no formato
+//                               <custo> <sobreposicao> <tam> <id1> ... <idtam>
+//                               SEM_CAMINHO <nos> <tempo> | ERRO <mensagem>
+//                               at k rotas (padro ALTERNATIVAS_PADRAO) que custam no mximo esticamento
+//                               vezes a menor (ESTICAMENTO_PADRAO) e tm no mximo a frao sobreposicao
+//                               do custo em trechos das anteriores (SOBREPOSICAO_PADRAO); na resposta,
+//                               sobreposicao  a frao do custo em trechos da primeira rota
+//   MATRIZ <o1,o2,...> <d1,d2,...> [caminhos]
+//                            -> OK <origens> <destinos> <nos> <tempo> seguido de uma linha de custos por origem
+//                               ("inf" se no h caminho) e, com "caminhos", de uma linha por par (origem a origem)
+//                               no formato <tam> <id1> ... <idtam> | ERRO <mensagem>
+//   FORMATO <texto|binario> [coordenadas]
+//                            -> OK | ERRO <mensagem>
+//                               formato das respostas de ROTA: texto (padro, para depurao) ou um quadro
+//                               binrio por consulta (QuadroRota, veja SADA BINRIA), com os IDs do caminho
+//                               em 8 bytes cada e, com "coordenadas", os pares x, y em double; as respostas
+//                               dos demais comandos continuam em texto
+//   FILA <tipo>              -> OK | ERRO <mensagem>
+//                               fila de prioridade das prximas consultas: binaria (padro), quaternaria ou radix
+//   COMPONENTES              -> OK <fortes> <fracas> seguido de uma linha com a componente forte e outra com
+//                               a componente fraca de cada vrtice, na ordem do arquivo | ERRO <mensagem>
+//   ARVORE <origem> <limite> [contorno]
+//                            -> OK <total> <nos> <tempo> <contorno> seguido de uma linha com os IDs alcanados
+//                               (custo <= limite, em ordem de custo), uma com os custos, uma com a posio do
+//                               predecessor de cada um na lista (-1 na origem) e, com "contorno", uma com os
+//                               pares <x> <y> do contorno da iscrona | ERRO <mensagem>
+//   PROXIMO <x> <y>          -> OK <id> <distancia> | ERRO <mensagem>
+//                               vrtice mais prximo da coordenada (ndice espacial em grade)
+//   ARESTA <x> <y>           -> OK <origem> <destino> <x> <y> <fracao> <distancia> | ERRO <mensagem>
+//                               ponto mais prximo da coordenada sobre uma aresta; fracao vai de 0 (origem) a 1
+//   REGIAO <x1> <y1> <x2> <y2>
+//                            -> OK <vertices> <arestas> seguido de uma linha com os IDs dos vrtices do
+//                               retngulo e outra com os pares <origem> <destino> das arestas que passam
+//                               por ele | ERRO <mensagem>
+//   GEOMETRIA <id1,id2,...>  -> OK <pontos> seguido de uma linha com os pares <x> <y> do desenho do caminho:
+//                               os vrtices e os pontos intermedirios das arestas entre eles (arquivo .geo
+//                               do conversor com --compactar) | ERRO <mensagem>
+//   PESOS <a1:f1,a2:f2,...>  -> OK <arestas> <tempo> | ERRO <mensagem>
+//                               multiplica o peso original das arestas (IDs do .poly) pelos fatores (>= 1;
+//                               1 restaura e "inf" interdita a aresta), todos ou nenhum; a hierarquia do
+//                               modo ch  recustomizada no mesmo comando, includa no tempo
+//   CACHE <megabytes>        -> OK | ERRO <mensagem>
+//                               memria do cache de rvores por origem dos modos dijkstra e parada
+//                               (padro CACHE_PADRAO_MB; 0 desliga)
+//   METRICAS                 -> OK <coletadas> <arestas_relaxadas> <insercoes> <diminuicoes> <extracoes>
+//                                  <extracoes_obsoletas> <maior_fila> <bytes_espaco> <bytes_grafo>
+//                                  <tempo_leitura> <tempo_csr> <tempo_busca> <tempo_caminho> <uso_cache>
+//                                  <acertos_cache> <retomadas_cache> <faltas_cache> <arvores_cache>
+//                                  <bytes_cache> | ERRO <mensagem>
+//                               mtricas da ltima ROTA; os contadores so 0 se o back-end no foi
+//                               compilado com -DNAV_METRICAS (coletadas == 0). uso_cache: 0 no usado,
+//                               1 acerto, 2 busca retomada, 3 falta; os demais contadores do cache so
+//                               acumulados desde a carga do mapa
+//   SAIR                     -> encerra o servidor
+// Troca o mapa do servidor: libera o anterior e carrega o novo (com .ch/.alt ao lado, vrtices na
+// ordem dada) e o espao de busca das consultas, com a fila e o cache escolhidos. Retorna 1 se bem
+// sucedido; se falhar, *g e *e ficam NULL
+int trocarMapa(const char* arquivo, int ordem, NavGrafo** g, NavEspaco** e, int tipoFila, long long bytesCache) {
+    navLiberarEspaco(*e);
+    navLiberarGrafo(*g);
+    *e = NULL;
+    *g = navCarregarMapaComOrdem(arquivo, ordem);
+    if (*g) *e = navCriarEspaco(*g);
+    if (*e && (navDefinirFila(*e, tipoFila) != NAV_OK || navDefinirCache(*e, bytesCache) != NAV_OK)) {
+        navLiberarEspaco(*e);
+        *e = NULL;
+    }
+    if (*g && !*e) {
+        navLiberarGrafo(*g);
+        *g = NULL;
+    }
+    return *g != NULL;
 }
 
-// ------------------------ LEITURA DO ARQUIVO .POLY ------------------------ //
-// L o arquivo .poly com formato esperado e popula o grafo com vrtices e arestas
-// Retorna 1 se leitura bem sucedida, 0 se erro
-int lerArquivoPoly(char* nome) {
-    FILE* f = fopen(nome, "r");
-    if (!f) return 0;
+int modoServidor(const char* arquivoInicial, int ordem) {
+    static char linha[1 << 20];   // Comporta listas longas de IDs no comando MATRIZ
+    NavGrafo* g = NULL;
+    NavEspaco* espaco = NULL;
+    NavResultado r;
+    int tipoFila = FILA_BINARIA;
+    long long bytesCache = CACHE_PADRAO_MB * 1024LL * 1024LL;
+    int formatoBinario = 0, comCoordenadas = 0;   // Formato das respostas de ROTA (comando FORMATO)
+
+#ifdef _WIN32
+    _setmode(_fileno(stdout), _O_BINARY);   // Sem converso de \n nos quadros binrios
+#endif
+
+    if (arquivoInicial) trocarMapa(arquivoInicial, ordem, &g, &espaco, tipoFila, bytesCache);
+
+    while (fgets(linha, sizeof(linha), stdin)) {
+        linha[strcspn(linha, "\r\n")] = '\0';
 
-    // Inicializa o mapeamento dos IDs com -1 (no mapeados)
-    for (int i = 0; i < MAX_VERTICES; i++) {
-        idParaIndice[i] = -1;
+        if (strncmp(linha, "CARREGAR ", 9) == 0) {
+            if (trocarMapa(linha + 9, ordem, &g, &espaco, tipoFila, bytesCache)) {
+                NavInfo info;
+                navInfo(g, &info);
+                printf("OK %d %d\n", info.totalVertices, info.totalArestas);
+            } else {
+                printf("ERRO falha ao ler o arquivo\n");
+            }
+        } else if (strncmp(linha, "ROTA ", 5) == 0) {
+            NavId origemId, destinoId;
+            char nomeModo[32] = "dijkstra", mensagem[96];
+            const char* erro = NULL;
+            int lidos = sscanf(linha + 5, "%lld %lld %31s", &origemId, &destinoId, nomeModo);
+            int modo = navModoDoNome(nomeModo);
+            if (!g) {
+                erro = "nenhum grafo carregado";
+            } else if (lidos < 2) {
+                erro = "origem ou destino invalidos";
+            } else if (modo < 0) {
+                erro = "modo de busca desconhecido";
+            } else {
+                int status = navRota(g, espaco, origemId, destinoId, modo, &r);
+                if (status == NAV_ERRO_ID) {
+                    erro = "origem ou destino nao encontrados no grafo";
+                } else if (status == NAV_ERRO_PRE_PROCESSAMENTO) {
+                    snprintf(mensagem, sizeof(mensagem), "pre-processamento nao carregado (gere com --gerar-%s)",
+                             navNomeModo(modo));
+                    erro = mensagem;
+                } else if (status == NAV_ERRO_MEMORIA) {
+                    erro = "memoria insuficiente";
+                } else if (status != NAV_OK) {
+                    // Cdigos que a consulta no devolve hoje: nunca tratar como resposta vlida
+                    snprintf(mensagem, sizeof(mensagem), "falha na consulta (codigo %d)", status);
+                    erro = mensagem;
+                }
+            }
+            if (formatoBinario) {
+                escreverQuadroRota(stdout, g, &r, comCoordenadas, erro);
+            } else if (erro) {
+                printf("ERRO %s\n", erro);
+            } else if (r.custo >= NAV_INF) {
+                printf("SEM_CAMINHO %d %.6lf\n", r.nosExplorados, r.tempo);
+            } else {
+                printf("OK %.6lf %d %.6lf %d\n", r.custo, r.nosExplorados, r.tempo, r.tamCaminho);
+                for (int i = 0; i < r.tamCaminho; i++)
+                    printf(i ? " %lld" : "%lld", r.caminho[i]);
+                printf("\n");
+            }
+        } else if (strncmp(linha, "ALTERNATIVAS ", 13) == 0) {
+            NavId origemId, destinoId;
+            int k = ALTERNATIVAS_PADRAO;
+            double sobreposicao = SOBREPOSICAO_PADRAO, esticamento = ESTICAMENTO_PADRAO;
+            int lidos = sscanf(linha + 13, "%lld %lld %d %lf %lf", &origemId, &destinoId, &k, &sobreposicao, &esticamento);
+            NavAlternativas alt;
+            int status = g && lidos >= 2 ? navAlternativas(g, espaco, origemId, destinoId, k, sobreposicao, esticamento, &alt)
+                                         : NAV_ERRO_PARAMETRO;
+            if (!g) {
+                printf("ERRO nenhum grafo carregado\n");
+            } else if (lidos < 2) {
+                printf("ERRO uso: ALTERNATIVAS <origem> <destino> [k] [sobreposicao] [esticamento]\n");
+            } else if (status == NAV_ERRO_ID) {
+                printf("ERRO origem ou destino nao encontrados no grafo\n");
+            } else if (status == NAV_ERRO_PARAMETRO) {
+                printf("ERRO k deve ser >= 1, sobreposicao de 0 a 1 e esticamento >= 1\n");
+            } else if (status != NAV_OK) {
+                printf("ERRO memoria insuficiente\n");
+            } else if (alt.total == 0) {
+                printf("SEM_CAMINHO %d %.6lf\n", alt.nosExplorados, alt.tempo);
+            } else {
+                printf("OK %d %d %.6lf\n", alt.total, alt.nosExplorados, alt.tempo);
+                for (int i = 0; i < alt.total; i++) {
+                    printf("%.6lf %.6lf %d", alt.custos[i], alt.sobreposicao[i], alt.inicio[i + 1] - alt.inicio[i]);
+                    for (int j = alt.inicio[i]; j < alt.inicio[i + 1]; j++) printf(" %lld", alt.ids[j]);
+                    printf("\n");
+                }
+            }
+            if (status == NAV_OK) navLiberarAlternativas(&alt);
+        } else if (strncmp(linha, "MATRIZ ", 7) == 0) {
+            static char textoOrigens[1 << 20], textoDestinos[1 << 20];
+            char opcao[16] = "";
+            int lidos = sscanf(linha + 7, "%s %s %15s", textoOrigens, textoDestinos, opcao);
+            NavId *origens = NULL, *destinos = NULL;
+            int totalOrigens = -1, totalDestinos = -1;
+            if (g && lidos >= 2) {
+                totalOrigens = lerListaIds(g, textoOrigens, &origens);
+                totalDestinos = lerListaIds(g, textoDestinos, &destinos);
+            }
+            NavMatriz md;
+            if (!g) {
+                printf("ERRO nenhum grafo carregado\n");
+            } else if (lidos < 2 || (lidos == 3 && strcmp(opcao, "caminhos") != 0)) {
+                printf("ERRO uso: MATRIZ <o1,o2,...> <d1,d2,...> [caminhos]\n");
+            } else if (totalOrigens <= 0 || totalDestinos <= 0) {
+                printf("ERRO origem ou destino nao encontrados no grafo\n");
+            } else if (navMatriz(g, origens, totalOrigens, destinos, totalDestinos, lidos == 3, &md) != NAV_OK) {
+                printf("ERRO memoria insuficiente\n");
+            } else {
+                printf("OK %d %d %ld %.6lf\n", totalOrigens, totalDestinos, md.nosExplorados, md.tempo);
+                for (int i = 0; i < totalOrigens; i++) {
+                    for (int j = 0; j < totalDestinos; j++) {
+                        double c = md.custos[(long)i * totalDestinos + j];
+                        if (j) printf(" ");
+                        if (c >= NAV_INF) printf("inf");
+                        else printf("%.6lf", c);
+                    }
+                    printf("\n");
+                }
+                if (md.caminhos) {
+                    for (long c = 0; c < (long)totalOrigens * totalDestinos; c++) {
+                        printf("%d", md.tamCaminhos[c]);
+                        for (int k = 0; k < md.tamCaminhos[c]; k++) printf(" %lld", md.caminhos[c][k]);
+                        printf("\n");
+                    }
+                }
+                navLiberarMatriz(&md);
+            }
+            free(origens);
+            free(destinos);
+        } else if (strncmp(linha, "GEOMETRIA ", 10) == 0) {
+            NavId* ids = NULL;
+            double *x = NULL, *y = NULL;
+            int tamanho = g ? lerListaIds(g, linha + 10, &ids) : -1;
+            int total = tamanho > 0 ? navGeometriaCaminho(g, ids, tamanho, NULL, NULL, 0) : 0;
+            if (total > 0) {
+                x = malloc(total * sizeof(double));
+                y = malloc(total * sizeof(double));
+            }
+            if (!g) {
+                printf("ERRO nenhum grafo carregado\n");
+            } else if (tamanho <= 0) {
+                printf("ERRO vertice nao encontrado no grafo\n");
+            } else if (total == NAV_ERRO_PARAMETRO) {
+                printf("ERRO vertices consecutivos sem aresta entre eles\n");
+            } else if (!x || !y) {
+                printf("ERRO memoria insuficiente\n");
+            } else {
+                navGeometriaCaminho(g, ids, tamanho, x, y, total);
+                printf("OK %d\n", total);
+                for (int i = 0; i < total; i++) printf(i ? " %.6lf %.6lf" : "%.6lf %.6lf", x[i], y[i]);
+                printf("\n");
+            }
+            free(ids);
+            free(x);
+            free(y);
+        } else if (strncmp(linha, "FORMATO ", 8) == 0) {
+            char nome[16] = "", opcao[16] = "";
+            int lidos = sscanf(linha + 8, "%15s %15s", nome, opcao);
+            if (strcmp(nome, "texto") == 0 && lidos == 1) {
+                formatoBinario = 0;
+                printf("OK\n");
+            } else if (strcmp(nome, "binario") == 0 && (lidos == 1 || strcmp(opcao, "coordenadas") == 0)) {
+                formatoBinario = 1;
+                comCoordenadas = lidos == 2;
+                printf("OK\n");
+            } else {
+                printf("ERRO uso: FORMATO <texto|binario> [coordenadas]\n");
+            }
+        } else if (strncmp(linha, "FILA ", 5) == 0) {
+            int tipo = navTipoFilaDoNome(linha + 5);
+            if (tipo < 0) {
+                printf("ERRO tipo de fila desconhecido\n");
+            } else if (espaco && navDefinirFila(espaco, tipo) != NAV_OK) {
+                printf("ERRO memoria insuficiente\n");
+            } else {
+                tipoFila = tipo;
+                printf("OK\n");
+            }
+        } else if (strncmp(linha, "CACHE ", 6) == 0) {
+            double megabytes;
+            if (sscanf(linha + 6, "%lf", &megabytes) != 1 || megabytes < 0) {
+                printf("ERRO uso: CACHE <megabytes>\n");
+            } else if (espaco && navDefinirCache(espaco, (long long)(megabytes * 1024 * 1024)) != NAV_OK) {
+                printf("ERRO memoria insuficiente\n");
+            } else {
+                bytesCache = (long long)(megabytes * 1024 * 1024);
+                printf("OK\n");
+            }
+        } else if (strcmp(linha, "COMPONENTES") == 0) {
+            NavInfo info;
+            int *fortes = NULL, *fracas = NULL;
+            if (g) {
+                navInfo(g, &info);
+                fortes = malloc((info.totalVertices + 1) * sizeof(int));
+                fracas = malloc((info.totalVertices + 1) * sizeof(int));
+            }
+            if (!g) {
+                printf("ERRO nenhum grafo carregado\n");
+            } else if (!fortes || !fracas) {
+                printf("ERRO memoria insuficiente\n");
+            } else {
+                navComponentesVertices(g, fortes, fracas);
+                printf("OK %d %d\n", info.totalComponentesFortes, info.totalComponentesFracas);
+                for (int v = 0; v < info.totalVertices; v++) printf(v ? " %d" : "%d", fortes[v]);
+                printf("\n");
+                for (int v = 0; v < info.totalVertices; v++) printf(v ? " %d" : "%d", fracas[v]);
+                printf("\n");
+            }
+            free(fortes);
+            free(fracas);
+        } else if (strncmp(linha, "ARVORE ", 7) == 0) {
+            NavId origemId;
+            double limite;
+            char opcao[16] = "";
+            int lidos = sscanf(linha + 7, "%lld %lf %15s", &origemId, &limite, opcao);
+            NavArvore a;
+            int status = 0;
+            if (!g) {
+                printf("ERRO nenhum grafo carregado\n");
+            } else if (lidos < 2 || (lidos == 3 && strcmp(opcao, "contorno") != 0)) {
+                printf("ERRO uso: ARVORE <origem> <limite> [contorno]\n");
+            } else if ((status = navArvore(g, espaco, origemId, limite, lidos == 3, &a)) == NAV_ERRO_ID) {
+                printf("ERRO origem nao encontrada no grafo\n");
+            } else if (status == NAV_ERRO_PARAMETRO) {
+                printf("ERRO limite invalido\n");
+            } else if (status != NAV_OK) {
+                printf("ERRO memoria insuficiente\n");
+            } else {
+                printf("OK %d %d %.6lf %d\n", a.total, a.nosExplorados, a.tempo, a.totalContorno);
+                for (int i = 0; i < a.total; i++) printf(i ? " %lld" : "%lld", a.ids[i]);
+                printf("\n");
+                for (int i = 0; i < a.total; i++) printf(i ? " %.6lf" : "%.6lf", a.custos[i]);
+                printf("\n");
+                for (int i = 0; i < a.total; i++) printf(i ? " %d" : "%d", a.anterior[i]);
+                printf("\n");
+                if (lidos == 3) {
+                    for (int i = 0; i < a.totalContorno; i++)
+                        printf(i ? " %.6lf %.6lf" : "%.6lf %.6lf", a.contornoX[i], a.contornoY[i]);
+                    printf("\n");
+                }
+                navLiberarArvore(&a);
+            }
+        } else if (strncmp(linha, "PROXIMO ", 8) == 0 || strncmp(linha, "ARESTA ", 7) == 0) {
+            int aresta = linha[0] == 'A';
+            double x, y, distancia;
+            NavId id;
+            NavPontoAresta p;
+            if (!g) {
+                printf("ERRO nenhum grafo carregado\n");
+            } else if (sscanf(linha + (aresta ? 7 : 8), "%lf %lf", &x, &y) != 2) {
+                printf("ERRO coordenadas invalidas\n");
+            } else if (!aresta) {
+                if (navVerticeProximo(g, x, y, &id, &distancia)) printf("OK %lld %.6lf\n", id, distancia);
+                else printf("ERRO nenhum vertice encontrado\n");
+            } else {
+                if (navArestaProxima(g, x, y, &p))
+                    printf("OK %lld %lld %.6lf %.6lf %.6lf %.6lf\n", p.origem, p.destino, p.x, p.y, p.fracao, p.distancia);
+                else printf("ERRO nenhuma aresta encontrada\n");
+            }
+        } else if (strncmp(linha, "REGIAO ", 7) == 0) {
+            double x1, y1, x2, y2;
+            NavId *vertices = NULL, *origens = NULL, *destinos = NULL;
+            int totalVertices = 0, totalArestas = 0;
+            int lidos = sscanf(linha + 7, "%lf %lf %lf %lf", &x1, &y1, &x2, &y2);
+            if (g && lidos == 4) {
+                // Primeiro s conta, para alocar os vetores do tamanho exato
+                totalVertices = navVerticesNaRegiao(g, x1, y1, x2, y2, NULL, 0);
+                totalArestas = navArestasNaRegiao(g, x1, y1, x2, y2, NULL, NULL, 0);
+                vertices = malloc((totalVertices + 1) * sizeof(NavId));
+                origens = malloc((totalArestas + 1) * sizeof(NavId));
+                destinos = malloc((totalArestas + 1) * sizeof(NavId));
+            }
+            if (!g) {
+                printf("ERRO nenhum grafo carregado\n");
+            } else if (lidos != 4) {
+                printf("ERRO uso: REGIAO <x1> <y1> <x2> <y2>\n");
+            } else if (!vertices || !origens || !destinos) {
+                printf("ERRO memoria insuficiente\n");
+            } else {
+                navVerticesNaRegiao(g, x1, y1, x2, y2, vertices, totalVertices);
+                navArestasNaRegiao(g, x1, y1, x2, y2, origens, destinos, totalArestas);
+                printf("OK %d %d\n", totalVertices, totalArestas);
+                for (int i = 0; i < totalVertices; i++) printf(i ? " %lld" : "%lld", vertices[i]);
+                printf("\n");
+                for (int i = 0; i < totalArestas; i++) printf(i ? " %lld %lld" : "%lld %lld", origens[i], destinos[i]);
+                printf("\n");
+            }
+            free(vertices);
+            free(origens);
+            free(destinos);
+        } else if (strncmp(linha, "PESOS ", 6) == 0) {
+            NavId* arestas = NULL;
+            double* fatores = NULL;
+            int total = lerListaPesos(linha + 6, &arestas, &fatores);
+            if (!g) {
+                printf("ERRO nenhum grafo carregado\n");
+            } else if (total < 0) {
+                printf("ERRO uso: PESOS <aresta:fator,...>\n");
+            } else {
+                double ini = navRelogio();
+                int status = navAtualizarPesos(g, arestas, fatores, total);
+                double tempo = navRelogio() - ini;
+                if (status == NAV_ERRO_ID) printf("ERRO aresta nao encontrada no grafo\n");
+                else if (status == NAV_ERRO_PARAMETRO) printf("ERRO fator menor que 1\n");
+                else if (status != NAV_OK) printf("ERRO memoria insuficiente\n");
+                else printf("OK %d %.6lf\n", total, tempo);
+            }
+            free(arestas);
+            free(fatores);
+        } else if (strcmp(linha, "METRICAS") == 0) {
+            if (!g) {
+                printf("ERRO nenhum grafo carregado\n");
+            } else {
+                NavInfo info;
+                NavMetricas m;
+                NavContadoresCache c;
+                navInfo(g, &info);
+                navMetricas(espaco, &m);
+                navContadoresCache(espaco, &c);
+                printf("OK %d %ld %ld %ld %ld %ld %ld %lld %lld %.9lf %.9lf %.9lf %.9lf %d %ld %ld %ld %d %lld\n",
+                       m.coletadas, m.arestasRelaxadas, m.insercoes, m.diminuicoes, m.extracoes, m.extracoesObsoletas,
+                       m.maiorFila, m.bytesEspaco, info.bytesAlocados, info.tempoLeitura, info.tempoConstrucaoCSR,
+                       m.tempoBusca, m.tempoCaminho, m.cache, c.acertos, c.retomadas, c.faltas, c.arvores, c.bytes);
+            }
+        } else if (strcmp(linha, "SAIR") == 0) {
+            break;
+        } else if (linha[0] != '\0') {
+            printf("ERRO comando desconhecido\n");
+        }
+        fflush(stdout);
     }
 
-    // L o cabealho do arquivo .poly (nmero de vrtices e alguns parmetros no usados)
-    int lixo1, lixo2, lixo3;
-    if (fscanf(f, "%d %d %d %d", &totalVertices, &lixo1, &lixo2, &lixo3) != 4) {
-        fclose(f);
-        return 0;
+    navLiberarEspaco(espaco);
+    navLiberarGrafo(g);
+    return 0;
+}
+
+// ------------------------ FUNO PRINCIPAL ------------------------ //
+int main(int argc, char* argv[]) {
+    // Ordem dos vrtices na memria, antes de qualquer modo: backend --ordem arquivo|hilbert|bfs ...
+    // (padro arquivo; os .ch/.alt gerados numa ordem no valem para outra)
+    int ordem = ORDEM_ARQUIVO;
+    if (argc >= 3 && strcmp(argv[1], "--ordem") == 0) {
+        ordem = navOrdemDoNome(argv[2]);
+        if (ordem < 0) {
+            printf("Erro: ordem de vrtices desconhecida: %s (use arquivo, hilbert ou bfs)\n", argv[2]);
+            return 1;
+        }
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
     }
-    if (totalVertices > MAX_VERTICES) {
-        printf("Erro: nmero de vrtices excede limite mximo (%d)\n", MAX_VERTICES);
-        fclose(f);
+
+    // Modo servidor: backend --servidor [arquivo.poly]
+    if (argc >= 2 && strcmp(argv[1], "--servidor") == 0) {
+        return modoServidor(argc >= 3 ? argv[2] : NULL, ordem);
+    }
+
+    // Converso para o formato binrio: backend --converter arquivo.poly [saida.navg]
+    if (argc >= 3 && strcmp(argv[1], "--converter") == 0) {
+        char nomeBinario[4096];
+        if (argc >= 4) snprintf(nomeBinario, sizeof(nomeBinario), "%s", argv[3]);
+        else navNomeArquivoAuxiliar(argv[2], ".navg", nomeBinario, sizeof(nomeBinario));
+        NavGrafo* g = navCarregarGrafoComOrdem(argv[2], ordem);
+        if (!g) {
+            printf("Erro ao ler o arquivo.\n");
+            return 1;
+        }
+        if (!navSalvarBinario(g, nomeBinario)) {
+            printf("Erro: no foi possvel gravar %s\n", nomeBinario);
+            navLiberarGrafo(g);
+            return 1;
+        }
+        NavInfo info;
+        navInfo(g, &info);
+        printf("Grafo binrio gravado em %s: %d vrtices, %d arestas dirigidas\n",
+               nomeBinario, info.totalVertices, info.totalArestasDirigidas);
+        navLiberarGrafo(g);
         return 0;
     }
 
-    // L os vrtices: id, coordenadas x e y
-    for (int i = 0; i < totalVertices; i++) {
-        int id; 
-        double x, y;
-        if (fscanf(f, "%d %lf %lf", &id, &x, &y) != 3) {
-            fclose(f);
-            return 0;
+    // Pr-processamento da Contraction Hierarchy: backend --gerar-ch arquivo.poly [saida.ch]
+    if (argc >= 3 && strcmp(argv[1], "--gerar-ch") == 0) {
+        char nomeCH[4096];
+        if (argc >= 4) snprintf(nomeCH, sizeof(nomeCH), "%s", argv[3]);
+        else navNomeArquivoAuxiliar(argv[2], ".ch", nomeCH, sizeof(nomeCH));
+        NavGrafo* g = navCarregarGrafoComOrdem(argv[2], ordem);
+        if (!g) {
+            printf("Erro ao ler o arquivo.\n");
+            return 1;
         }
-        grafo[i].id = id;
-        grafo[i].x = x;
-        grafo[i].y = y;
-        grafo[i].lista = NULL;  // Inicializa lista de adjacncia vazia
-
-        // Valida ID para evitar ndice invlido no array
-        if (id < 0 || id >= MAX_VERTICES) {
-            printf("Erro: ID de vrtice invlido: %d\n", id);
-            fclose(f);
-            return 0;
+        double ini = navRelogio();
+        int atalhos = navGerarHierarquia(g);
+        double tempo = navRelogio() - ini;
+        if (atalhos < 0 || !navSalvarHierarquia(g, nomeCH)) {
+            printf("Erro: no foi possvel gerar %s\n", nomeCH);
+            navLiberarGrafo(g);
+            return 1;
         }
-        idParaIndice[id] = i;  // Mapeia ID para ndice interno
+        NavInfo info;
+        navInfo(g, &info);
+        printf("Hierarquia gravada em %s: %d atalhos, %d arestas de subida, %d de descida (%.3lf s)\n",
+               nomeCH, atalhos, info.arestasSubida, info.arestasDescida, tempo);
+        navLiberarGrafo(g);
+        return 0;
     }
 
-    // L nmero de arestas (e outro parmetro no usado)
-    if (fscanf(f, "%d %d", &totalArestas, &lixo1) != 2) {
-        fclose(f);
+    // Pr-processamento dos landmarks do ALT: backend --gerar-alt arquivo.poly [K] [saida.alt]
+    if (argc >= 3 && strcmp(argv[1], "--gerar-alt") == 0) {
+        char nomeALT[4096];
+        int k = argc >= 4 ? atoi(argv[3]) : 0;   // 0 usa a quantidade padro da biblioteca
+        if (argc >= 5) snprintf(nomeALT, sizeof(nomeALT), "%s", argv[4]);
+        else navNomeArquivoAuxiliar(argv[2], ".alt", nomeALT, sizeof(nomeALT));
+        NavGrafo* g = navCarregarGrafoComOrdem(argv[2], ordem);
+        if (!g) {
+            printf("Erro ao ler o arquivo.\n");
+            return 1;
+        }
+        double ini = navRelogio();
+        int ok = navGerarLandmarks(g, k);
+        double tempo = navRelogio() - ini;
+        if (!ok || !navSalvarLandmarks(g, nomeALT)) {
+            printf("Erro: no foi possvel gerar %s\n", nomeALT);
+            navLiberarGrafo(g);
+            return 1;
+        }
+        NavInfo info;
+        navInfo(g, &info);
+        printf("Landmarks gravados em %s: %d landmarks (%.3lf s)\n", nomeALT, info.totalLandmarks, tempo);
+        navLiberarGrafo(g);
         return 0;
     }
 
-    // L as arestas: id da aresta, origem, destino, direo (0 = bidirecional, 1 = direcionado)
-    for (int i = 0; i < totalArestas; i++) {
-        int id, o, d, dir;
-        if (fscanf(f, "%d %d %d %d", &id, &o, &d, &dir) != 4) {
-            fclose(f);
-            return 0;
+    // Matriz de distncias em lote: backend --matriz arquivo.poly lista.txt [--caminhos]
+    // lista.txt: quantidade de origens seguida dos IDs, depois quantidade de destinos seguida dos IDs
+    if (argc >= 4 && strcmp(argv[1], "--matriz") == 0) {
+        int comCaminhos = argc >= 5 && strcmp(argv[4], "--caminhos") == 0;
+        NavGrafo* g = navCarregarGrafoComOrdem(argv[2], ordem);
+        if (!g) {
+            printf("Erro ao ler o arquivo.\n");
+            return 1;
+        }
+        FILE* lista = fopen(argv[3], "r");
+        if (!lista) {
+            printf("Erro: arquivo %s no encontrado\n", argv[3]);
+            return 1;
+        }
+        int total[2] = {0, 0};
+        NavId* ids[2] = {NULL, NULL};
+        int ok = 1;
+        for (int l = 0; l < 2 && ok; l++) {
+            ok = fscanf(lista, "%d", &total[l]) == 1 && total[l] > 0
+              && (ids[l] = malloc(total[l] * sizeof(NavId))) != NULL;
+            for (int i = 0; ok && i < total[l]; i++)
+                ok = fscanf(lista, "%lld", &ids[l][i]) == 1 && navContemId(g, ids[l][i]);
+        }
+        fclose(lista);
+        if (!ok) {
+            printf("Erro: lista de origens e destinos invlida em %s\n", argv[3]);
+            return 1;
         }
 
-        // Converte os IDs de vrtices para ndices internos do vetor grafo
-        int o_idx = (o >= 0 && o < MAX_VERTICES) ? idParaIndice[o] : -1;
-        int d_idx = (d >= 0 && d < MAX_VERTICES) ? idParaIndice[d] : -1;
+        NavMatriz md;
+        if (navMatriz(g, ids[0], total[0], ids[1], total[1], comCaminhos, &md) != NAV_OK) {
+            printf("Erro: memria insuficiente para a matriz\n");
+            return 1;
+        }
+        FILE* saida = fopen("matriz.txt", "w");
+        if (!saida) {
+            printf("Erro: no foi possvel criar matriz.txt\n");
+            return 1;
+        }
+        escreverMatriz(saida, ids[0], ids[1], &md);
+        fclose(saida);
+        printf("Matriz %d x %d gravada em matriz.txt (%.4lf s, %d threads)\n",
+               total[0], total[1], md.tempo, md.threads);
+        navLiberarMatriz(&md);
+        free(ids[0]);
+        free(ids[1]);
+        navLiberarGrafo(g);
+        return 0;
+    }
 
-        // Verifica se os vrtices de origem e destino existem no grafo
-        if (o_idx == -1 || d_idx == -1) {
-            printf("Erro: aresta com vrtice inexistente (origem %d, destino %d)\n", o, d);
-            fclose(f);
-            return 0;
+    // rvore de caminhos mnimos limitada por custo:
+    // backend --arvore arquivo.poly origem limite [saida.arv] [--contorno]
+    if (argc >= 5 && strcmp(argv[1], "--arvore") == 0) {
+        int comContorno = strcmp(argv[argc - 1], "--contorno") == 0;
+        const char* nomeArvore = argc - comContorno >= 6 ? argv[5] : "arvore.arv";
+        NavGrafo* g = navCarregarGrafoComOrdem(argv[2], ordem);
+        if (!g) {
+            printf("Erro ao ler o arquivo.\n");
+            return 1;
+        }
+        NavEspaco* espaco = navCriarEspaco(g);
+        NavArvore a;
+        int status = espaco ? navArvore(g, espaco, atoll(argv[3]), atof(argv[4]), comContorno, &a) : NAV_ERRO_MEMORIA;
+        if (status != NAV_OK) {
+            printf(status == NAV_ERRO_ID ? "Erro: origem no encontrada no grafo\n"
+                   : status == NAV_ERRO_PARAMETRO ? "Erro: limite invlido\n" : "Erro: memria insuficiente\n");
+            navLiberarEspaco(espaco);
+            navLiberarGrafo(g);
+            return 1;
         }
-        adicionarAresta(o_idx, d_idx, dir);  // Adiciona a aresta no grafo
+        int ok = navSalvarArvore(&a, nomeArvore);
+        if (ok) printf("rvore gravada em %s: %d vrtices com custo <= %.2lf, contorno com %d pontos (%.4lf s)\n",
+                       nomeArvore, a.total, a.limite, a.totalContorno, a.tempo);
+        else printf("Erro: no foi possvel gravar %s\n", nomeArvore);
+        navLiberarArvore(&a);
+        navLiberarEspaco(espaco);
+        navLiberarGrafo(g);
+        return ok ? 0 : 1;
     }
 
-    fclose(f);
-    return 1;  // Sucesso na leitura do arquivo
-}
+    // Comparao das filas de prioridade: backend --comparar-filas arquivo.poly [consultas] [modo]
+    if (argc >= 3 && strcmp(argv[1], "--comparar-filas") == 0) {
+        int consultas = argc >= 4 ? atoi(argv[3]) : 1000;
+        int modo = navModoDoNome(argc >= 5 ? argv[4] : "dijkstra");
+        NavGrafo* g = navCarregarMapaComOrdem(argv[2], ordem);
+        if (!g) {
+            printf("Erro ao ler o arquivo.\n");
+            return 1;
+        }
+        if (modo < 0 || consultas <= 0) {
+            printf("Erro: modo de busca ou quantidade de consultas invlidos\n");
+            navLiberarGrafo(g);
+            return 1;
+        }
+        compararFilas(g, consultas, modo);
+        navLiberarGrafo(g);
+        return 0;
+    }
 
-// ------------------------ ALGORITMO DE DIJKSTRA ------------------------ //
-// Implementa o algoritmo para encontrar o caminho mnimo entre vrtices
-// origem e destino so ndices internos dos vrtices no grafo
-// nosExplorados armazena a quantidade de ns visitados
-// custoFinal recebe o custo total do caminho encontrado
-// anterior  vetor que armazena o vrtice predecessor para reconstruo do caminho
-void dijkstra(int origem, int destino, int* nosExplorados, double* custoFinal, int* anterior) {
-    double dist[MAX_VERTICES];         // Distncias mnimas acumuladas da origem
-    int visitado[MAX_VERTICES] = {0}; // Marca se o vrtice j foi visitado
-    *nosExplorados = 0;                // Inicializa contador de ns explorados
-
-    // Inicializa distncias com infinito e predecessores invlidos (-1)
-    for (int i = 0; i < totalVertices; i++) {
-        dist[i] = INF;
-        anterior[i] = -1;
-    }
-    dist[origem] = 0;  // Distncia do vrtice origem para ele mesmo  zero
-
-    tamHeap = 0;       // Inicializa heap vazia
-    inserirHeap(origem, 0);  // Insere vrtice origem na heap
-
-    while (tamHeap > 0) {
-        int u = extrairMin();  // Remove vrtice com menor distncia acumulada
-        if (visitado[u]) continue;  // Se j visitado, ignora
-        visitado[u] = 1;
-        (*nosExplorados)++;  // Incrementa contador de ns explorados
-
-        // Relaxa todas as arestas adjacentes a u
-        for (Aresta* a = grafo[u].lista; a != NULL; a = a->prox) {
-            int v = a->destino;
-            // Se no visitado e novo caminho menor, atualiza distncia e predecessor
-            if (!visitado[v] && dist[u] + a->peso < dist[v]) {
-                dist[v] = dist[u] + a->peso;
-                anterior[v] = u;
-                inserirHeap(v, dist[v]);  // Insere ou atualiza heap com nova distncia
+    // Relatrio de memria e tempo de carga: backend --estatisticas arquivo.poly [...]
+    if (argc >= 2 && strcmp(argv[1], "--estatisticas") == 0) {
+        for (int i = 2; i < argc; i++) {
+            NavGrafo* g = navCarregarGrafoComOrdem(argv[i], ordem);
+            if (!g) {
+                printf("Erro ao ler o arquivo %s.\n", argv[i]);
+                continue;
             }
+            imprimirEstatisticas(g, argv[i]);
+            navLiberarGrafo(g);
         }
+        return 0;
     }
 
-    *custoFinal = dist[destino];  // Define o custo final encontrado para o destino
-}
-
-// ------------------------ FUNO PRINCIPAL ------------------------ //
-int main(int argc, char* argv[]) {
     // Verifica se arquivo .poly foi passado como argumento
     if (argc < 2) {
         printf("Informe o nome do arquivo .poly como argumento\n");
+        printf("Uso: %s arquivo.poly | %s --servidor [arquivo.poly] | %s --estatisticas arquivo.poly...\n",
+               argv[0], argv[0], argv[0]);
+        printf("     %s --gerar-ch arquivo.poly [saida.ch] | %s --gerar-alt arquivo.poly [K] [saida.alt]\n",
+               argv[0], argv[0]);
+        printf("     %s --matriz arquivo.poly lista.txt [--caminhos] | %s --converter arquivo.poly [saida.navg]\n",
+               argv[0], argv[0]);
+        printf("     %s --comparar-filas arquivo.poly [consultas] [modo]\n", argv[0]);
+        printf("     %s --arvore arquivo.poly origem limite [saida.arv] [--contorno]\n", argv[0]);
+        printf("     %s --ordem arquivo|hilbert|bfs <qualquer uma das formas acima>\n", argv[0]);
         return 1;
     }
 
     // Tenta ler o arquivo .poly, caso falhe termina o programa
-    if (!lerArquivoPoly(argv[1])) {
+    NavGrafo* g = navCarregarGrafoComOrdem(argv[1], ordem);
+    if (!g) {
         printf("Erro ao ler o arquivo.\n");
         return 1;
     }
@@ -280,30 +959,59 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    int origemId, destinoId;
+    NavId origemId, destinoId;
     // L os IDs de origem e destino
-    if (fscanf(entrada, "%d", &origemId) != 1 || fscanf(entrada, "%d", &destinoId) != 1) {
+    if (fscanf(entrada, "%lld", &origemId) != 1 || fscanf(entrada, "%lld", &destinoId) != 1) {
         fclose(entrada);
         printf("Erro: origem ou destino invlidos em entrada.txt\n");
         return 1;
     }
+
+    // Terceira linha opcional: modo de busca (dijkstra, parada, astar, bidirecional, astar_bidirecional, ch ou alt)
+    char nomeModo[32] = "dijkstra";
+    if (fscanf(entrada, "%31s", nomeModo) != 1) strcpy(nomeModo, "dijkstra");
     fclose(entrada);
+    int modo = navModoDoNome(nomeModo);
+    if (modo < 0) {
+        printf("Erro: modo de busca desconhecido em entrada.txt: %s\n", nomeModo);
+        return 1;
+    }
 
-    // Converte IDs originais para ndices internos do vetor grafo
-    int origem = idParaIndice[origemId];
-    int destino = idParaIndice[destinoId];
-    if (origem == -1 || destino == -1) {
+    // Verifica se os IDs originais pertencem ao grafo
+    if (!navContemId(g, origemId) || !navContemId(g, destinoId)) {
         printf("Erro: origem ou destino no encontrados no grafo\n");
         return 1;
     }
 
-    // Executa Dijkstra e mede tempo de execuo
-    clock_t ini = clock();
-    int nos = 0, anterior[MAX_VERTICES];
-    double custo;
-    dijkstra(origem, destino, &nos, &custo, anterior);
-    clock_t fim = clock();
-    double tempo = (double)(fim - ini) / CLOCKS_PER_SEC;
+    // Os modos ch e alt usam os arquivos gerados previamente com --gerar-ch e --gerar-alt
+    char nomeAuxiliar[4096];
+    if (modo == BUSCA_CH) {
+        navNomeArquivoAuxiliar(argv[1], ".ch", nomeAuxiliar, sizeof(nomeAuxiliar));
+        navCarregarHierarquia(g, nomeAuxiliar);
+    } else if (modo == BUSCA_ALT) {
+        navNomeArquivoAuxiliar(argv[1], ".alt", nomeAuxiliar, sizeof(nomeAuxiliar));
+        navCarregarLandmarks(g, nomeAuxiliar);
+    }
+
+    // Executa a busca escolhida e mede tempo de execuo
+    NavEspaco* espaco = navCriarEspaco(g);
+    if (!espaco) {
+        printf("Erro: memria insuficiente\n");
+        return 1;
+    }
+    NavResultado r;
+    int status = navRota(g, espaco, origemId, destinoId, modo, &r);
+    if (status != NAV_OK) {
+        if (status == NAV_ERRO_PRE_PROCESSAMENTO)
+            printf("Erro: pr-processamento no encontrado; gere-o com --gerar-%s\n", navNomeModo(modo));
+        else if (status == NAV_ERRO_ID)
+            printf("Erro: origem ou destino no encontrados no grafo\n");
+        else if (status == NAV_ERRO_MEMORIA)
+            printf("Erro: memria insuficiente\n");
+        else
+            printf("Erro: falha na consulta (cdigo %d)\n", status);
+        return 1;
+    }
 
     // Abre arquivo saida.txt para salvar resultados do caminho encontrado
     FILE* saida = fopen("saida.txt", "w");
@@ -311,30 +1019,21 @@ int main(int argc, char* argv[]) {
         printf("Erro: no foi possvel criar saida.txt\n");
         return 1;
     }
+    escreverSaida(saida, g, origemId, destinoId, modo, &r);
+    fclose(saida);
 
-    // Se custo for infinito, no existe caminho
-    if (custo >= INF) {
-        fprintf(saida, "No existe caminho entre %d e %d\n", origemId, destinoId);
-    } else {
-        // Escreve custo total, ns explorados e caminho detalhado no arquivo
-        fprintf(saida, "Custo total do caminho: %.2lf unidades\n", custo);
-        fprintf(saida, "Ns explorados: %d\n", nos);
-        fprintf(saida, "\nCaminho (do incio ao fim):\n");
-
-        int caminho[MAX_VERTICES], tam = 0;
-        // Reconstri o caminho de destino at a origem usando o vetor anterior
-        for (int v = destino; v != -1; v = anterior[v])
-            caminho[tam++] = v;
-
-        // Imprime o caminho na ordem correta: origem at destino
-        for (int i = tam - 1; i >= 0; i--) {
-            int idx = caminho[i];
-            fprintf(saida, "%d (x=%.3lf, y=%.3lf)\n", grafo[idx].id, grafo[idx].x, grafo[idx].y);
-        }
+    // A mesma consulta em JSON, com os tempos separados e os contadores da busca
+    NavMetricas metricas;
+    navMetricas(espaco, &metricas);
+    saida = fopen("saida.json", "w");
+    if (!saida) {
+        printf("Erro: no foi possvel criar saida.json\n");
+        return 1;
     }
-    fprintf(saida, "\nTempo de execuo: %.4lf segundos\n", tempo);
+    escreverSaidaJson(saida, g, origemId, destinoId, modo, &r, &metricas);
     fclose(saida);
 
+    navLiberarEspaco(espaco);
+    navLiberarGrafo(g);
     return 0;
 }
-
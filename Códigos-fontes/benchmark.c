@@ -0,0 +1,478 @@
+/*
+    Projeto Final - AED2 - INF/UFG 2025-1
+    Tema: Sistema de Navegao Primitivo
+    Benchmark reprodutvel das buscas, sobre a biblioteca de rotas (nav.h / nav.c)
+    Autores: Ana Luisa, Isadora, Lucas e Vernica
+    Professor: Andr Luiz Moura
+
+    Para cada grafo, sorteia pares origem/destino com semente fixa e mede cada modo de busca com os
+    mesmos pares: latncia p50/p95/p99 (relgio monotnico de alta resoluo), vazo, ns explorados,
+    faltas de cache por consulta (contadores de hardware do Linux, quando disponveis) e pico de
+    memria do processo. Alm dos mapas, gera grades e malhas virias sintticas de 10^4
+    vrtices at o tamanho pedido, para ver como os tempos crescem. O relatrio sai em CSV (ou JSON)
+    na sada padro, para comparar execues de verses diferentes; o progresso vai para stderr.
+
+    Compilao:
+      gcc -O2 benchmark.c nav.c -o benchmark -lm
+      (com -DNAV_METRICAS tambm preenche as colunas de arestas relaxadas e extraes obsoletas)
+
+    Uso:
+      benchmark [opes] [mapa.poly|mapa.navg ...]
+        --consultas N    pares sorteados por grafo (padro 1000; nos sintticos diminui com o tamanho)
+        --semente S      semente do sorteio dos pares (padro 42)
+        --fila TIPO      fila de prioridade: binaria (padro), quaternaria ou radix
+        --ordem ORDEM    ordem dos vrtices na memria: arquivo (padro), hilbert ou bfs
+        --modos a,b,...  modos medidos (padro: todos; ch e alt s se o pr-processamento existir)
+        --sinteticos MAX gera grafos sintticos de 10^4 at MAX vrtices (padro 10^6; 0 desliga)
+        --gerar-pre      gera a hierarquia (ch) e os landmarks (alt) dos grafos que no os tm
+        --json           relatrio em JSON em vez de CSV
+      Sem mapas na linha de comando, usa os mapas de "../Arquivos .poly".
+*/
+
+#define _DEFAULT_SOURCE           // syscall (perf_event_open) mesmo com -std=c99
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "nav.h"
+
+#ifdef _WIN32
+#define PSAPI_VERSION 2           // GetProcessMemoryInfo do kernel32, sem precisar de -lpsapi
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Mapas do projeto, usados quando nenhum arquivo  passado na linha de comando
+static const char* mapasPadrao[] = {
+    "../Arquivos .poly/Anicums.poly",
+    "../Arquivos .poly/SetorGoiania2.poly",
+    "../Arquivos .poly/SetorPedro.poly",
+    "../Arquivos .poly/flores.poly"
+};
+
+// Uma linha do relatrio: um modo de busca medido em um grafo
+typedef struct {
+    const char* grafo;
+    int vertices;
+    int arestas;
+    const char* modo;
+    const char* fila;
+    const char* ordem;     // Ordem dos vrtices na memria
+    int consultas;
+    int semCaminho;
+    int divergencias;      // Custos diferentes do primeiro modo medido nos mesmos pares
+    double p50, p95, p99;  // Latncias em microssegundos
+    double media;
+    double vazao;          // Consultas por segundo
+    double nosMedios;
+    double caminhoMedio;   // Microssegundos montando o caminho, parte de 'media'
+    double arestasMedias;  // Arestas relaxadas por consulta (-1 sem NAV_METRICAS)
+    double obsoletasMedias; // Extraes obsoletas por consulta (-1 sem NAV_METRICAS)
+    double faltasCacheMedias; // Faltas no ltimo nvel de cache por consulta (-1 sem contadores de hardware)
+    long picoMemoriaKB;    // Pico de memria residente do processo at aqui
+    double tempoCarga;     // Segundos para ler (ou gerar) o grafo
+    double tempoPre;       // Segundos gastos com --gerar-pre neste grafo
+} LinhaRelatorio;
+
+// Opes da linha de comando
+typedef struct {
+    int consultas;
+    unsigned long long semente;
+    int tipoFila;
+    int ordem;
+    int modoAtivo[TOTAL_MODOS_BUSCA];
+    long maxSinteticos;
+    int gerarPre;
+    int json;
+} Opcoes;
+
+// ------------------------ MEDIO ------------------------ //
+// Pico de memria residente do processo em KB, ou -1 se no for possvel medir
+static long picoMemoriaKB(void) {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return -1;
+    return (long)(pmc.PeakWorkingSetSize / 1024);
+#else
+    struct rusage uso;
+    if (getrusage(RUSAGE_SELF, &uso) != 0) return -1;
+#ifdef __APPLE__
+    return uso.ru_maxrss / 1024;   // No macOS ru_maxrss vem em bytes
+#else
+    return uso.ru_maxrss;
+#endif
+#endif
+}
+
+// Contador de faltas no ltimo nvel de cache das consultas, em modo usurio (perf_event_open).
+// Retorna o descritor, ou -1 fora do Linux ou sem contadores de hardware (mquinas virtuais sem PMU,
+// perf_event_paranoid alto)
+static int abrirContadorCache(void) {
+#ifdef __linux__
+    struct perf_event_attr atributos;
+    memset(&atributos, 0, sizeof(atributos));
+    atributos.type = PERF_TYPE_HARDWARE;
+    atributos.size = sizeof(atributos);
+    atributos.config = PERF_COUNT_HW_CACHE_MISSES;
+    atributos.disabled = 1;
+    atributos.exclude_kernel = 1;
+    atributos.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &atributos, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+// Zera e liga (ligar != 0) ou desliga o contador
+static void ligarContadorCache(int fd, int ligar) {
+#ifdef __linux__
+    if (fd < 0) return;
+    if (ligar) ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, ligar ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, 0);
+#else
+    (void)fd; (void)ligar;
+#endif
+}
+
+// Faltas contadas desde o ltimo ligarContadorCache, ou -1 se no h contador
+static long long lerContadorCache(int fd) {
+#ifdef __linux__
+    long long valor;
+    if (fd >= 0 && read(fd, &valor, sizeof(valor)) == (ssize_t)sizeof(valor)) return valor;
+#else
+    (void)fd;
+#endif
+    return -1;
+}
+
+// Gerador congruente linear de 64 bits: a mesma semente d os mesmos pares em qualquer plataforma
+static unsigned long long proximoAleatorio(unsigned long long* estado) {
+    *estado = *estado * 6364136223846793005ULL + 1442695040888963407ULL;
+    return *estado >> 33;
+}
+
+static double aleatorioUnitario(unsigned long long* estado) {
+    return (double)proximoAleatorio(estado) / 2147483648.0;   // [0, 1)
+}
+
+static int compararDouble(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Percentil pelo mtodo do posto mais prximo; o vetor deve estar ordenado
+static double percentil(const double* ordenado, int n, double p) {
+    int posicao = (int)ceil(p * n) - 1;
+    if (posicao < 0) posicao = 0;
+    if (posicao >= n) posicao = n - 1;
+    return ordenado[posicao];
+}
+
+// ------------------------ RELATRIO ------------------------ //
+static void escreverCabecalho(const Opcoes* op) {
+    if (op->json) printf("[\n");
+    else printf("grafo,vertices,arestas,modo,fila,ordem,consultas,sem_caminho,divergencias,p50_us,p95_us,p99_us,"
+                "media_us,caminho_us,consultas_por_s,nos_medios,arestas_medias,obsoletas_medias,faltas_cache_medias,"
+                "pico_memoria_kb,tempo_carga_s,tempo_pre_s\n");
+}
+
+static void escreverLinha(const Opcoes* op, const LinhaRelatorio* l, int primeira) {
+    if (op->json) {
+        printf("%s  {\"grafo\": \"%s\", \"vertices\": %d, \"arestas\": %d, \"modo\": \"%s\", \"fila\": \"%s\", "
+               "\"ordem\": \"%s\", \"consultas\": %d, \"sem_caminho\": %d, \"divergencias\": %d, \"p50_us\": %.3f, "
+               "\"p95_us\": %.3f, \"p99_us\": %.3f, \"media_us\": %.3f, \"caminho_us\": %.3f, \"consultas_por_s\": %.1f, "
+               "\"nos_medios\": %.1f, \"arestas_medias\": %.1f, \"obsoletas_medias\": %.1f, \"faltas_cache_medias\": %.1f, "
+               "\"pico_memoria_kb\": %ld, \"tempo_carga_s\": %.6f, \"tempo_pre_s\": %.6f}",
+               primeira ? "" : ",\n", l->grafo, l->vertices, l->arestas, l->modo, l->fila, l->ordem, l->consultas,
+               l->semCaminho, l->divergencias, l->p50, l->p95, l->p99, l->media, l->caminhoMedio, l->vazao,
+               l->nosMedios, l->arestasMedias, l->obsoletasMedias, l->faltasCacheMedias, l->picoMemoriaKB,
+               l->tempoCarga, l->tempoPre);
+    } else {
+        printf("%s,%d,%d,%s,%s,%s,%d,%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.1f,%.1f,%.1f,%.1f,%.1f,%ld,%.6f,%.6f\n",
+               l->grafo, l->vertices, l->arestas, l->modo, l->fila, l->ordem, l->consultas, l->semCaminho,
+               l->divergencias, l->p50, l->p95, l->p99, l->media, l->caminhoMedio, l->vazao, l->nosMedios,
+               l->arestasMedias, l->obsoletasMedias, l->faltasCacheMedias, l->picoMemoriaKB, l->tempoCarga,
+               l->tempoPre);
+    }
+    fflush(stdout);
+}
+
+static void escreverRodape(const Opcoes* op) {
+    if (op->json) printf("\n]\n");
+}
+
+// ------------------------ EXECUO ------------------------ //
+// Mede todos os modos ativos no grafo com os mesmos pares sorteados. Retorna as linhas escritas
+static int medirGrafo(NavGrafo* g, const char* nome, double tempoCarga, const Opcoes* op, int consultas,
+                      int linhasAnteriores) {
+    NavInfo info;
+    double tempoPre = 0;
+    navInfo(g, &info);
+    if (info.totalVertices == 0) return 0;
+
+    if (op->gerarPre && (op->modoAtivo[BUSCA_CH] || op->modoAtivo[BUSCA_ALT])) {
+        double ini = navRelogio();
+        if (op->modoAtivo[BUSCA_CH] && !info.temHierarquia) {
+            fprintf(stderr, "%s: gerando a hierarquia...\n", nome);
+            navGerarHierarquia(g);
+        }
+        if (op->modoAtivo[BUSCA_ALT] && info.totalLandmarks == 0) {
+            fprintf(stderr, "%s: gerando os landmarks...\n", nome);
+            navGerarLandmarks(g, 0);
+        }
+        tempoPre = navRelogio() - ini;
+        navInfo(g, &info);
+    }
+
+    NavEspaco* e = navCriarEspaco(g);
+    int contadorCache = abrirContadorCache();
+    NavId* origens = malloc(consultas * sizeof(NavId));
+    NavId* destinos = malloc(consultas * sizeof(NavId));
+    double* latencias = malloc(consultas * sizeof(double));
+    double* custoReferencia = malloc(consultas * sizeof(double));
+    if (!e || !origens || !destinos || !latencias || !custoReferencia || navDefinirFila(e, op->tipoFila) != NAV_OK) {
+        fprintf(stderr, "%s: memria insuficiente para o benchmark\n", nome);
+        navLiberarEspaco(e);
+        free(origens); free(destinos); free(latencias); free(custoReferencia);
+#ifdef __linux__
+        if (contadorCache >= 0) close(contadorCache);
+#endif
+        return 0;
+    }
+    unsigned long long estado = op->semente;
+    for (int i = 0; i < consultas; i++) {
+        navIdVertice(g, (int)(proximoAleatorio(&estado) % (unsigned long long)info.totalVertices), &origens[i]);
+        navIdVertice(g, (int)(proximoAleatorio(&estado) % (unsigned long long)info.totalVertices), &destinos[i]);
+    }
+
+    int linhas = 0;
+    for (int modo = 0; modo < TOTAL_MODOS_BUSCA; modo++) {
+        if (!op->modoAtivo[modo]) continue;
+        if ((modo == BUSCA_CH && !info.temHierarquia) || (modo == BUSCA_ALT && info.totalLandmarks == 0)) {
+            fprintf(stderr, "%s: modo %s ignorado (sem pr-processamento; use --gerar-pre)\n", nome, navNomeModo(modo));
+            continue;
+        }
+        fprintf(stderr, "%s: %d consultas no modo %s...\n", nome, consultas, navNomeModo(modo));
+
+        LinhaRelatorio l;
+        memset(&l, 0, sizeof(l));
+        long nos = 0, arestas = 0, obsoletas = 0;
+        double total = 0, caminho = 0;
+        NavMetricas m;
+        int status = NAV_OK;
+        ligarContadorCache(contadorCache, 1);
+        for (int i = 0; i < consultas; i++) {
+            NavResultado r;
+            double ini = navRelogio();
+            status = navRota(g, e, origens[i], destinos[i], modo, &r);
+            if (status != NAV_OK) break;   // r no foi preenchido
+            latencias[i] = (navRelogio() - ini) * 1e6;
+            total += latencias[i];
+            nos += r.nosExplorados;
+            navMetricas(e, &m);
+            caminho += m.tempoCaminho * 1e6;
+            arestas += m.arestasRelaxadas;
+            obsoletas += m.extracoesObsoletas;
+            if (r.custo >= NAV_INF) l.semCaminho++;
+            // O primeiro modo medido vira a referncia dos custos dos demais
+            if (linhas == 0) custoReferencia[i] = r.custo;
+            else if (fabs(r.custo - custoReferencia[i]) > 1e-3) l.divergencias++;
+        }
+        ligarContadorCache(contadorCache, 0);
+        long long faltasCache = lerContadorCache(contadorCache);
+        if (status != NAV_OK) {
+            fprintf(stderr, "%s: modo %s interrompido (navRota retornou %d)\n", nome, navNomeModo(modo), status);
+            continue;
+        }
+        qsort(latencias, consultas, sizeof(double), compararDouble);
+
+        l.grafo = nome;
+        l.vertices = info.totalVertices;
+        l.arestas = info.totalArestasDirigidas;
+        l.modo = navNomeModo(modo);
+        l.fila = navNomeTipoFila(op->tipoFila);
+        l.ordem = navNomeOrdem(info.ordemVertices);
+        l.consultas = consultas;
+        l.p50 = percentil(latencias, consultas, 0.50);
+        l.p95 = percentil(latencias, consultas, 0.95);
+        l.p99 = percentil(latencias, consultas, 0.99);
+        l.media = total / consultas;
+        l.vazao = total > 0 ? consultas / (total * 1e-6) : 0;
+        l.nosMedios = (double)nos / consultas;
+        l.caminhoMedio = caminho / consultas;
+        l.arestasMedias = m.coletadas ? (double)arestas / consultas : -1;
+        l.obsoletasMedias = m.coletadas ? (double)obsoletas / consultas : -1;
+        l.faltasCacheMedias = faltasCache >= 0 ? (double)faltasCache / consultas : -1;
+        l.picoMemoriaKB = picoMemoriaKB();
+        l.tempoCarga = tempoCarga;
+        l.tempoPre = tempoPre;
+        escreverLinha(op, &l, linhasAnteriores + linhas == 0);
+        linhas++;
+    }
+
+    navLiberarEspaco(e);
+    free(origens); free(destinos); free(latencias); free(custoReferencia);
+#ifdef __linux__
+    if (contadorCache >= 0) close(contadorCache);
+#endif
+    return linhas;
+}
+
+// ------------------------ GRAFOS SINTTICOS ------------------------ //
+// Gera uma grade lado x lado com aproximadamente n vrtices. Com 'viaria' == 0,  uma grade regular
+// de mo dupla e pesos inteiros; com 1, imita uma malha urbana: coordenadas deslocadas, 20% das
+// ruas removidas e 10% de mo nica, mas mantendo uma avenida de mo dupla a cada 8 quadras.
+// Os vrtices ficam na ordem dada
+static NavGrafo* gerarSintetico(long n, int viaria, unsigned long long semente, int ordem) {
+    int lado = (int)ceil(sqrt((double)n));
+    long total = (long)lado * lado;
+    long maxArestas = 2 * total;
+    NavId* ids = malloc(total * sizeof(NavId));
+    double* x = malloc(total * sizeof(double));
+    double* y = malloc(total * sizeof(double));
+    NavId* origens = malloc(maxArestas * sizeof(NavId));
+    NavId* destinos = malloc(maxArestas * sizeof(NavId));
+    int* direcoes = malloc(maxArestas * sizeof(int));
+    NavGrafo* g = NULL;
+    if (ids && x && y && origens && destinos && direcoes) {
+        unsigned long long estado = semente;
+        for (long v = 0; v < total; v++) {
+            ids[v] = v;
+            x[v] = (double)(v % lado);
+            y[v] = (double)(v / lado);
+            if (viaria) {
+                x[v] += 0.7 * aleatorioUnitario(&estado) - 0.35;
+                y[v] += 0.7 * aleatorioUnitario(&estado) - 0.35;
+            }
+        }
+        long m = 0;
+        for (long v = 0; v < total; v++) {
+            long linha = v / lado, coluna = v % lado;
+            for (int sentido = 0; sentido < 2; sentido++) {
+                long w = sentido == 0 ? v + 1 : v + lado;
+                if ((sentido == 0 && coluna == lado - 1) || (sentido == 1 && linha == lado - 1)) continue;
+                int direcao = 0;
+                int avenida = sentido == 0 ? linha % 8 == 0 : coluna % 8 == 0;
+                if (viaria && !avenida) {
+                    double sorteio = aleatorioUnitario(&estado);
+                    if (sorteio < 0.2) continue;                  // Rua removida
+                    if (sorteio < 0.3) direcao = 1;               // Mo nica, em sentido sorteado
+                }
+                int inverter = direcao == 1 && aleatorioUnitario(&estado) < 0.5;
+                origens[m] = inverter ? w : v;
+                destinos[m] = inverter ? v : w;
+                direcoes[m] = direcao;
+                m++;
+            }
+        }
+        g = navCriarGrafo((int)total, ids, x, y, (int)m, origens, destinos, direcoes, ordem);
+    }
+    free(ids); free(x); free(y);
+    free(origens); free(destinos); free(direcoes);
+    return g;
+}
+
+// ------------------------ FUNO PRINCIPAL ------------------------ //
+int main(int argc, char* argv[]) {
+    Opcoes op;
+    memset(&op, 0, sizeof(op));
+    op.consultas = 1000;
+    op.semente = 42;
+    op.tipoFila = FILA_BINARIA;
+    op.ordem = ORDEM_ARQUIVO;
+    op.maxSinteticos = 1000000;
+    for (int m = 0; m < TOTAL_MODOS_BUSCA; m++) op.modoAtivo[m] = 1;
+
+    const char** mapas = malloc((argc + 1) * sizeof(char*));
+    int totalMapas = 0;
+    if (!mapas) return 1;
+    for (int i = 1; i < argc; i++) {
+        int temValor = i + 1 < argc;
+        if (strcmp(argv[i], "--consultas") == 0 && temValor) {
+            op.consultas = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--semente") == 0 && temValor) {
+            op.semente = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--fila") == 0 && temValor) {
+            op.tipoFila = navTipoFilaDoNome(argv[++i]);
+        } else if (strcmp(argv[i], "--ordem") == 0 && temValor) {
+            op.ordem = navOrdemDoNome(argv[++i]);
+        } else if (strcmp(argv[i], "--sinteticos") == 0 && temValor) {
+            op.maxSinteticos = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--modos") == 0 && temValor) {
+            // Lista separada por vrgulas: desativa todos e ativa s os citados
+            char lista[256];
+            snprintf(lista, sizeof(lista), "%s", argv[++i]);
+            for (int m = 0; m < TOTAL_MODOS_BUSCA; m++) op.modoAtivo[m] = 0;
+            for (char* nome = strtok(lista, ","); nome; nome = strtok(NULL, ",")) {
+                int modo = navModoDoNome(nome);
+                if (modo < 0) {
+                    fprintf(stderr, "Erro: modo de busca desconhecido: %s\n", nome);
+                    return 1;
+                }
+                op.modoAtivo[modo] = 1;
+            }
+        } else if (strcmp(argv[i], "--gerar-pre") == 0) {
+            op.gerarPre = 1;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            op.json = 1;
+        } else if (argv[i][0] == '-' && argv[i][1] == '-') {
+            fprintf(stderr, "Erro: opo desconhecida ou sem valor: %s\n", argv[i]);
+            return 1;
+        } else {
+            mapas[totalMapas++] = argv[i];
+        }
+    }
+    if (op.consultas <= 0 || op.tipoFila < 0 || navNomeOrdem(op.ordem) == NULL) {
+        fprintf(stderr, "Erro: quantidade de consultas, tipo de fila ou ordem dos vrtices invlidos\n");
+        return 1;
+    }
+    if (totalMapas == 0) {
+        for (int i = 0; i < (int)(sizeof(mapasPadrao) / sizeof(mapasPadrao[0])); i++) mapas[totalMapas++] = mapasPadrao[i];
+    }
+
+    escreverCabecalho(&op);
+    int linhas = 0;
+    for (int i = 0; i < totalMapas; i++) {
+        double ini = navRelogio();
+        NavGrafo* g = navCarregarMapaComOrdem(mapas[i], op.ordem);
+        double tempoCarga = navRelogio() - ini;
+        if (!g) {
+            fprintf(stderr, "Erro ao ler o arquivo %s\n", mapas[i]);
+            continue;
+        }
+        linhas += medirGrafo(g, mapas[i], tempoCarga, &op, op.consultas, linhas);
+        navLiberarGrafo(g);
+    }
+
+    // Grafos sintticos de 10^4, 10^5, ... vrtices. As consultas diminuem com o tamanho (no mnimo
+    // 20), j que o modo dijkstra percorre o grafo inteiro a cada consulta
+    for (long n = 10000; op.maxSinteticos > 0 && n <= op.maxSinteticos; n *= 10) {
+        for (int viaria = 0; viaria < 2; viaria++) {
+            char nome[64];
+            snprintf(nome, sizeof(nome), "%s-%ld", viaria ? "viaria" : "grade", n);
+            fprintf(stderr, "%s: gerando...\n", nome);
+            double ini = navRelogio();
+            NavGrafo* g = gerarSintetico(n, viaria, op.semente, op.ordem);
+            double tempoCarga = navRelogio() - ini;
+            if (!g) {
+                fprintf(stderr, "%s: memria insuficiente\n", nome);
+                continue;
+            }
+            long consultas = (long)op.consultas * 10000 / n;
+            if (consultas < 20) consultas = 20;
+            linhas += medirGrafo(g, nome, tempoCarga, &op, (int)consultas, linhas);
+            navLiberarGrafo(g);
+        }
+    }
+    escreverRodape(&op);
+    free(mapas);
+    return 0;
+}
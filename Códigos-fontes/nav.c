@@ -0,0 +1,4635 @@
+/*
+    Projeto Final - AED2 - INF/UFG 2025-1
+    Tema: Sistema de Navegao Primitivo
+    Biblioteca de rotas (libnav): Fila de Prioridade (Heap Mnima) e Grafo em formato CSR
+    Autores: Ana Luisa, Isadora, Lucas e Vernica
+    Professor: Andr Luiz Moura
+
+    Todo o estado fica em duas estruturas: NavGrafo (grafo e pr-processamentos, s lido pelas
+    consultas) e NavEspaco (vetores e heaps de uma busca). No h variveis globais mutveis,
+    ento threads com espaos de busca diferentes podem consultar o mesmo grafo ao mesmo tempo.
+    A exceo so os pesos dinmicos, publicados por navAtualizarPesos sem parar as consultas (veja
+    PUBLICAO DOS PESOS)
+*/
+
+#define _POSIX_C_SOURCE 200809L   // clock_gettime e mmap mesmo com -std=c99
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <limits.h>
+#include <string.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>    // Compilado com -fopenmp, o modo matriz usa todos os ncleos
+#endif
+#ifdef _WIN32
+#include <windows.h>    // MapViewOfFile, para abrir o formato binrio .navg
+#else
+#include <fcntl.h>
+#include <sched.h>      // sched_yield, na espera pelas consultas antigas (veja PUBLICAO DOS PESOS)
+#include <sys/mman.h>   // mmap, para abrir o formato binrio .navg
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "nav.h"
+
+#define FILA_PADRAO FILA_BINARIA   // Fila das buscas em espaos criados sem escolher o tipo
+
+// Instruo de medio: s  compilada com -DNAV_METRICAS, de modo que, sem a opo, as buscas
+// ficam exatamente como sem os contadores
+#ifdef NAV_METRICAS
+#define METRICA(instrucao) instrucao
+#else
+#define METRICA(instrucao)
+#endif
+
+// Soma 'bytes' ao total alocado pelo grafo na carga e nos pr-processamentos (s com NAV_METRICAS)
+#define CONTAR_BYTES(g, bytes) METRICA((g)->bytesAlocados += (long long)(bytes))
+
+// ------------------------ ESTRUTURAS ------------------------ //
+// Representa um vrtice do grafo
+typedef struct {
+    NavId id;              // ID original do vrtice conforme o arquivo .poly
+    double x, y;           // Coordenadas do vrtice no plano cartesiano
+} Vertice;
+
+// Nodo para a heap mnima utilizada no algoritmo de Dijkstra
+typedef struct {
+    int id;                // ndice do vrtice no grafo
+    double dist;           // Distncia acumulada do vrtice origem at este vrtice
+} NodoHeap;
+
+// Tabelas de distncias dos landmarks, usadas no modo "alt"
+typedef struct {
+    int carregada;             // 1 se o arquivo .alt do grafo atual foi lido
+    int total;                 // Quantidade de landmarks (K)
+    int* landmark;             // ndices internos dos K landmarks
+    double* distDe;            // distDe[k * totalVertices + v] = d(landmark k, v)
+    double* distPara;          // distPara[k * totalVertices + v] = d(v, landmark k)
+} TabelasALT;
+
+// Grafo de atalhos em CSR: arestas de v em inicio[v] .. inicio[v+1]-1
+typedef struct {
+    int* inicio;
+    int* alvo;
+    double* peso;
+    int* meio;
+    int total;
+} CSRAtalhos;
+
+// Hierarquia carregada para consultas no modo "ch"
+typedef struct {
+    int carregada;         // 1 se o arquivo .ch do grafo atual foi lido
+    int* nivel;            // Posio de cada vrtice na ordem de contrao
+    CSRAtalhos subida;     // Arestas v -> x com nivel[x] > nivel[v]
+    CSRAtalhos descida;    // Arestas u -> v com nivel[u] > nivel[v], guardadas em v (alvo = u)
+    int cordal;            // 1 se subida e descida j tm a topologia fixa da recustomizao
+} HierarquiaCH;
+
+// Tabela de disperso do ID original (64 bits, possivelmente esparso, como os do OpenStreetMap)
+// para o ndice interno. Endereamento aberto com sondagem linear; capacidade potncia de 2
+typedef struct {
+    NavId* chaves;
+    int* indices;              // ndice interno de cada posio, -1 se a posio est livre
+    unsigned long long mascara; // Capacidade - 1
+} TabelaIds;
+
+// ndice espacial em grade uniforme sobre as coordenadas dos vrtices (veja construirGrade). A clula
+// (coluna, linha) cobre [minX + coluna * lado, minX + (coluna + 1) * lado) x [minY + linha * lado, ...)
+// e tem nmero linha * colunas + coluna; pontos fora da grade pertencem  clula da borda mais prxima
+typedef struct {
+    int colunas, linhas;
+    double minX, minY, lado;
+    int* inicioVertices;       // Vrtices da clula c em verticeCelula[inicioVertices[c] .. inicioVertices[c+1]-1]
+    int* verticeCelula;
+    int* inicioArestas;        // Arestas que passam pelo retngulo envolvente da clula c, do mesmo modo
+    int* arestaCelula;         // Pares (origem, destino) em ndices internos: arestaCelula[2 * k], [2 * k + 1]
+    int totalEntradasArestas;  // Quantidade de pares em arestaCelula (uma aresta entra em vrias clulas)
+} GradeEspacial;
+
+// Publicao dos pesos dinmicos (veja PUBLICAO DOS PESOS). Alocada com o grafo, fora dele, porque
+// as consultas recebem o grafo como const e ainda assim precisam se registrar nos contadores
+typedef struct {
+    NavGrafo* vista;           // Cpia do grafo com os pesos da ltima atualizao; NULL usa o prprio grafo
+    unsigned int epoca;        // As consultas que comeam agora se registram em leitores[epoca & 1]
+    int leitores[2];           // Consultas em andamento em cada paridade de poca
+    int escrevendo;            // 1 enquanto uma chamada de navAtualizarPesos est em andamento
+} PublicacaoPesos;
+
+// Grafo carregado: vrtices, adjacncias e pr-processamentos
+struct NavGrafo {
+    Vertice* vertices;         // Vetor que armazena todos os vrtices do grafo
+    int totalVertices;         // Quantidade de vrtices carregados no grafo
+    int totalArestas;          // Quantidade de arestas carregadas no grafo
+
+    // Mapeamento do ID original dos vrtices (do arquivo .poly) para ndice interno em 'vertices'
+    TabelaIds idParaIndice;
+
+    // Ordem dos vrtices na memria (veja ORDEM DOS VRTICES): indiceDoArquivo[i]  o ndice interno
+    // do i-simo vrtice do arquivo, ou NULL se a ordem interna  a do arquivo
+    int ordemVertices;
+    int* indiceDoArquivo;
+
+    // Adjacncia em formato CSR (compressed sparse row), organizada como estrutura de vetores:
+    // as arestas que saem do vrtice v ocupam as posies inicioAresta[v] .. inicioAresta[v+1]-1
+    // de destinoAresta e pesoAresta, de modo que o Dijkstra percorre memria contgua
+    int* inicioAresta;         // totalVertices + 1 deslocamentos
+    int* destinoAresta;        // ndice interno do vrtice destino de cada aresta dirigida
+    double* pesoAresta;        // Peso (distncia Euclidiana) de cada aresta dirigida
+    int totalArestasDirigidas; // Arestas bidirecionais do .poly contam duas vezes
+
+    // Adjacncia reversa, tambm em CSR: as arestas que CHEGAM ao vrtice v ocupam as posies
+    // inicioArestaReversa[v] .. inicioArestaReversa[v+1]-1, com a origem de cada uma em origemArestaReversa
+    // Necessria para a busca reversa das buscas bidirecionais, j que vias de mo nica (direcao == 1)
+    // tornam o grafo direcionado
+    int* inicioArestaReversa;
+    int* origemArestaReversa;
+    double* pesoArestaReversa;
+
+    // Componentes do grafo direcionado, calculadas na carga (veja calcularComponentes). Tarjan numera
+    // as componentes fortes em ordem topolgica reversa: uma aresta de C1 para C2 implica C1 > C2
+    int* componenteForte;      // Componente fortemente conexa de cada vrtice
+    int* componenteFraca;      // Componente fracamente conexa (ignorando o sentido das arestas)
+    int totalComponentesFortes;
+    int totalComponentesFracas;
+
+    GradeEspacial grade;       // Vrtice/aresta mais prximos de um ponto e elementos de um retngulo
+
+    // Geometria das arestas compactadas (arquivo .geo; veja GEOMETRIA DAS ARESTAS): a aresta dirigida e
+    // passa pelos pontos k = inicioGeometria[e] .. inicioGeometria[e+1]-1, (pontosGeometria[2 * k],
+    // pontosGeometria[2 * k + 1]), da origem para o destino. NULL se o mapa no tem .geo
+    int* inicioGeometria;
+    double* pontosGeometria;
+    int totalPontosGeometria;
+
+    // Maior f <= 1 tal que peso(u, v) >= f * distncia Euclidiana(u, v) em todas as arestas (veja
+    // calcularFatorHeuristica): com pesos em tempo (velocidades do .poly), a distncia Euclidiana
+    // multiplicada por f continua sendo um limite inferior para o A* e a busca bidirecional
+    double fatorHeuristica;
+
+    // Pesos dinmicos (veja PESOS DINMICOS): idArestaParaIndice leva o ID de cada aresta do .poly 
+    // sua posio i no arquivo; a aresta i ocupa as posies dirigidaDaAresta[2 * i] (origem -> destino)
+    // e dirigidaDaAresta[2 * i + 1] (destino -> origem, -1 nas de mo nica) do CSR direto, e a aresta
+    // dirigida e ocupa a posio reversaDaDirigida[e] do CSR reverso. pesoOriginal[i]  o peso da carga
+    TabelaIds idArestaParaIndice;
+    int* dirigidaDaAresta;
+    int* reversaDaDirigida;
+    double* pesoOriginal;
+    int pesosAlterados;        // 1 depois do primeiro navAtualizarPesos
+    int pesosCopiados;         // 1 se pesoAresta e pesoArestaReversa foram copiados do mapeamento
+    PublicacaoPesos* publicacao;
+
+    // Verso dos pesos: faz parte da chave do cache de rvores dos espaos de busca, de modo que
+    // rvores calculadas com pesos antigos nunca so reaproveitadas
+    unsigned int versao;
+
+    // Tempos (em segundos) medidos na leitura, usados pelo relatrio de --estatisticas
+    double tempoLeitura;
+    double tempoConstrucaoCSR;
+    long long bytesAlocados;   // Contado com CONTAR_BYTES (s com NAV_METRICAS)
+
+    HierarquiaCH ch;           // Contraction Hierarchy (modo "ch")
+    TabelasALT alt;            // Landmarks (modo "alt")
+
+    // Arquivo .navg mapeado em memria (NULL se o grafo veio de um .poly). Nesse caso os vetores
+    // de vrtices, adjacncias e IDs apontam para dentro do mapeamento, que  somente leitura
+    void* mapeamento;
+    size_t tamanhoMapeamento;
+};
+
+// Nomes dos modos usados em entrada.txt e no protocolo do modo servidor, na ordem do enum
+static const char* nomesModoBusca[TOTAL_MODOS_BUSCA] = {
+    "dijkstra", "parada", "astar", "bidirecional", "astar_bidirecional", "ch", "alt"
+};
+
+// Nomes dos tipos de fila de prioridade, na ordem do enum
+static const char* nomesTipoFila[TOTAL_TIPOS_FILA] = { "binaria", "quaternaria", "radix" };
+
+// Nomes das ordens de vrtices, na ordem do enum
+static const char* nomesOrdem[TOTAL_ORDENS_VERTICES] = { "arquivo", "hilbert", "bfs" };
+
+// ------------------------ FUNES AUXILIARES ------------------------ //
+// Relgio monotnico em segundos, com resoluo de nanossegundos. clock() mede tempo de CPU (somado
+// entre as threads) e, em algumas plataformas, s avana de milissegundo em milissegundo
+static double relogio(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequencia, contador;
+    QueryPerformanceFrequency(&frequencia);
+    QueryPerformanceCounter(&contador);
+    return (double)contador.QuadPart / (double)frequencia.QuadPart;
+#else
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+#endif
+}
+
+// Calcula a distncia Euclidiana entre dois vrtices dados pelos seus ndices internos
+static double distancia(const NavGrafo* g, int a, int b) {
+    double dx = g->vertices[a].x - g->vertices[b].x;  // Diferena em x
+    double dy = g->vertices[a].y - g->vertices[b].y;  // Diferena em y
+    return sqrt(dx*dx + dy*dy);            // Distncia Euclidiana (hipotenusa)
+}
+
+// Limite inferior do custo de a at b usado pelas buscas guiadas (A*, ALT e bidirecional A*)
+static double heuristica(const NavGrafo* g, int a, int b) {
+    return g->fatorHeuristica * distancia(g, a, b);
+}
+
+// Calcula g->fatorHeuristica a partir dos pesos finais das arestas. Em mapas com pesos de
+// distncia (reta ou poligonal) o fator  1 e as heursticas ficam como a distncia Euclidiana
+static void calcularFatorHeuristica(NavGrafo* g) {
+    g->fatorHeuristica = 1;
+    for (int u = 0; u < g->totalVertices; u++) {
+        for (int e = g->inicioAresta[u]; e < g->inicioAresta[u + 1]; e++) {
+            double d = distancia(g, u, g->destinoAresta[e]);
+            if (d > 0 && g->pesoAresta[e] < g->fatorHeuristica * d) g->fatorHeuristica = g->pesoAresta[e] / d;
+        }
+    }
+}
+
+// Monta a adjacncia CSR a partir das arestas lidas do .poly (ndices internos)
+// Se dir[i] == 0, a aresta  bidirecional e gera tambm a aresta inversa no destino
+// O peso  a distncia Euclidiana entre as pontas, dividida por velocidades[i] se o vetor foi dado
+// Faz duas passadas: conta o grau de sada de cada vrtice e depois preenche as posies, anotando
+// em g->dirigidaDaAresta onde cada aresta do .poly foi parar
+// Retorna 1 se bem sucedido, 0 se faltar memria
+static int construirCSR(NavGrafo* g, const int* origens, const int* destinos, const int* dir,
+                        const double* velocidades, int m) {
+    g->totalArestasDirigidas = 0;
+    for (int i = 0; i < m; i++)
+        g->totalArestasDirigidas += (dir[i] == 0) ? 2 : 1;
+
+    g->inicioAresta = calloc(g->totalVertices + 1, sizeof(int));
+    g->destinoAresta = malloc((g->totalArestasDirigidas + 1) * sizeof(int));
+    g->pesoAresta = malloc((g->totalArestasDirigidas + 1) * sizeof(double));
+    g->dirigidaDaAresta = malloc((2 * (size_t)m + 1) * sizeof(int));
+    if (!g->inicioAresta || !g->destinoAresta || !g->pesoAresta || !g->dirigidaDaAresta) return 0;
+    CONTAR_BYTES(g, (g->totalVertices + 1) * sizeof(int) + (g->totalArestasDirigidas + 1) * (sizeof(int) + sizeof(double))
+                    + (2 * (size_t)m + 1) * sizeof(int));
+
+    // Conta o grau de sada, deslocado de uma posio para virar soma de prefixos
+    for (int i = 0; i < m; i++) {
+        g->inicioAresta[origens[i] + 1]++;
+        if (dir[i] == 0) g->inicioAresta[destinos[i] + 1]++;
+    }
+    for (int v = 0; v < g->totalVertices; v++)
+        g->inicioAresta[v + 1] += g->inicioAresta[v];
+
+    // Preenche usando um cursor por vrtice (cpia dos deslocamentos iniciais)
+    int* cursor = malloc((g->totalVertices + 1) * sizeof(int));
+    if (!cursor) return 0;
+    CONTAR_BYTES(g, (g->totalVertices + 1) * sizeof(int));
+    memcpy(cursor, g->inicioAresta, (g->totalVertices + 1) * sizeof(int));
+    for (int i = 0; i < m; i++) {
+        int o = origens[i], d = destinos[i];
+        double peso = distancia(g, o, d);  // Peso  a distncia Euclidiana calculada
+        if (velocidades) peso /= velocidades[i];
+        g->dirigidaDaAresta[2 * i] = cursor[o];
+        g->destinoAresta[cursor[o]] = d;
+        g->pesoAresta[cursor[o]++] = peso;
+        g->dirigidaDaAresta[2 * i + 1] = -1;
+        if (dir[i] == 0) {
+            // Aresta inversa para via de mo dupla, com o mesmo peso
+            g->dirigidaDaAresta[2 * i + 1] = cursor[d];
+            g->destinoAresta[cursor[d]] = o;
+            g->pesoAresta[cursor[d]++] = peso;
+        }
+    }
+    free(cursor);
+    return 1;
+}
+
+// Monta a adjacncia reversa transpondo o CSR direto (deve ser chamada depois de construirCSR),
+// anotando em g->reversaDaDirigida a posio reversa de cada aresta dirigida
+// Retorna 1 se bem sucedido, 0 se faltar memria
+static int construirCSRReverso(NavGrafo* g) {
+    g->inicioArestaReversa = calloc(g->totalVertices + 1, sizeof(int));
+    g->origemArestaReversa = malloc((g->totalArestasDirigidas + 1) * sizeof(int));
+    g->pesoArestaReversa = malloc((g->totalArestasDirigidas + 1) * sizeof(double));
+    g->reversaDaDirigida = malloc((g->totalArestasDirigidas + 1) * sizeof(int));
+    if (!g->inicioArestaReversa || !g->origemArestaReversa || !g->pesoArestaReversa || !g->reversaDaDirigida) return 0;
+    CONTAR_BYTES(g, (g->totalVertices + 1) * sizeof(int) + (g->totalArestasDirigidas + 1) * (2 * sizeof(int) + sizeof(double)));
+
+    // Conta o grau de entrada e transforma em soma de prefixos
+    for (int e = 0; e < g->totalArestasDirigidas; e++)
+        g->inicioArestaReversa[g->destinoAresta[e] + 1]++;
+    for (int v = 0; v < g->totalVertices; v++)
+        g->inicioArestaReversa[v + 1] += g->inicioArestaReversa[v];
+
+    int* cursor = malloc((g->totalVertices + 1) * sizeof(int));
+    if (!cursor) return 0;
+    CONTAR_BYTES(g, (g->totalVertices + 1) * sizeof(int));
+    memcpy(cursor, g->inicioArestaReversa, (g->totalVertices + 1) * sizeof(int));
+    for (int u = 0; u < g->totalVertices; u++) {
+        for (int e = g->inicioAresta[u]; e < g->inicioAresta[u + 1]; e++) {
+            int v = g->destinoAresta[e];
+            g->reversaDaDirigida[e] = cursor[v];
+            g->origemArestaReversa[cursor[v]] = u;
+            g->pesoArestaReversa[cursor[v]++] = g->pesoAresta[e];
+        }
+    }
+    free(cursor);
+    return 1;
+}
+
+// ------------------------ TABELA DE IDS ------------------------ //
+// Espalha os bits do ID (mistura do splitmix64), para que IDs sequenciais ou com padres
+// no se concentrem em poucas posies da tabela
+static unsigned long long dispersarId(NavId id) {
+    unsigned long long h = (unsigned long long)id;
+    h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27; h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+// Aloca a tabela para 'total' IDs, mantendo a ocupao em no mximo 50%
+static int alocarTabelaIds(TabelaIds* t, int total) {
+    unsigned long long capacidade = 16;
+    while (capacidade < 2ULL * (unsigned long long)total) capacidade <<= 1;
+    t->chaves = malloc(capacidade * sizeof(NavId));
+    t->indices = malloc(capacidade * sizeof(int));
+    if (!t->chaves || !t->indices) return 0;
+    for (unsigned long long i = 0; i < capacidade; i++) t->indices[i] = -1;
+    t->mascara = capacidade - 1;
+    return 1;
+}
+
+static void liberarTabelaIds(TabelaIds* t) {
+    free(t->chaves);
+    free(t->indices);
+    memset(t, 0, sizeof(TabelaIds));
+}
+
+// Retorna o ndice interno do ID, ou -1 se o ID no est na tabela
+static int buscarId(const TabelaIds* t, NavId id) {
+    if (!t->indices) return -1;
+    for (unsigned long long i = dispersarId(id) & t->mascara; t->indices[i] != -1; i = (i + 1) & t->mascara)
+        if (t->chaves[i] == id) return t->indices[i];
+    return -1;
+}
+
+// Insere o par ID -> ndice. Retorna 0 se o ID j estava na tabela (vrtice duplicado no .poly)
+static int inserirId(TabelaIds* t, NavId id, int indice) {
+    unsigned long long i = dispersarId(id) & t->mascara;
+    for (; t->indices[i] != -1; i = (i + 1) & t->mascara)
+        if (t->chaves[i] == id) return 0;
+    t->chaves[i] = id;
+    t->indices[i] = indice;
+    return 1;
+}
+
+// Prepara os pesos dinmicos depois de montados o CSR direto (com a geometria) e o reverso: a tabela
+// dos IDs das arestas e os pesos originais. Com ids == NULL as arestas so identificadas pela posio
+// (0 = primeira); um ID repetido fica com a primeira aresta que o usa. Retorna 1 se bem sucedido,
+// 0 se faltar memria
+static int registrarArestas(NavGrafo* g, const NavId* ids) {
+    int m = g->totalArestas;
+    g->pesoOriginal = malloc((m + 1) * sizeof(double));
+    if (!g->pesoOriginal || !alocarTabelaIds(&g->idArestaParaIndice, m)) return 0;
+    CONTAR_BYTES(g, (m + 1) * sizeof(double) + (g->idArestaParaIndice.mascara + 1) * (sizeof(NavId) + sizeof(int)));
+    for (int i = 0; i < m; i++) {
+        g->pesoOriginal[i] = g->pesoAresta[g->dirigidaDaAresta[2 * i]];
+        inserirId(&g->idArestaParaIndice, ids ? ids[i] : i, i);
+    }
+    return 1;
+}
+
+// ------------------------ ORDEM DOS VRTICES ------------------------ //
+// Os vrtices chegam na ordem do arquivo, que no OpenStreetMap segue os IDs dos ns e no a posio
+// deles no mapa. Vizinhos no grafo acabam longe na memria, e cada vrtice fechado pela busca l
+// dist, visitado e a adjacncia em linhas de cache diferentes das do anterior. Na carga, os ndices
+// internos so renumerados para que vrtices prximos fiquem em posies prximas: ao longo de uma
+// curva de Hilbert sobre as coordenadas ou na ordem de uma busca em largura pelas arestas. Os IDs do
+// arquivo no mudam, e g->indiceDoArquivo guarda o caminho de volta para a ordem do arquivo. A ordem
+// vem de quem pede a carga (navCarregarGrafoComOrdem), no de um estado do processo
+
+#define BITS_HILBERT 16   // Coordenadas quantizadas em uma grade de 2^16 x 2^16
+
+typedef struct {
+    unsigned long long chave;
+    int indice;
+} ChaveVertice;
+
+static int compararChaveVertice(const void* a, const void* b) {
+    const ChaveVertice* x = (const ChaveVertice*)a;
+    const ChaveVertice* y = (const ChaveVertice*)b;
+    if (x->chave != y->chave) return x->chave < y->chave ? -1 : 1;
+    return (x->indice > y->indice) - (x->indice < y->indice);
+}
+
+// Posio do ponto (x, y) da grade ao longo da curva de Hilbert
+static unsigned long long chaveHilbert(unsigned int x, unsigned int y) {
+    const unsigned int n = 1u << BITS_HILBERT;
+    unsigned long long d = 0;
+    for (unsigned int s = n / 2; s > 0; s /= 2) {
+        unsigned int rx = (x & s) > 0, ry = (y & s) > 0;
+        d += (unsigned long long)s * s * ((3 * rx) ^ ry);
+        if (ry == 0) {   // Gira o quadrante para que a curva siga contnua dentro dele
+            if (rx == 1) {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            unsigned int t = x;
+            x = y;
+            y = t;
+        }
+    }
+    return d;
+}
+
+// novo[i] recebe a posio do vrtice i ao longo da curva de Hilbert (empates na ordem do arquivo)
+static int numerarHilbert(const NavGrafo* g, int* novo) {
+    int n = g->totalVertices;
+    ChaveVertice* chaves = malloc((n + 1) * sizeof(ChaveVertice));
+    if (!chaves) return 0;
+    double minX = g->vertices[0].x, maxX = minX, minY = g->vertices[0].y, maxY = minY;
+    for (int i = 1; i < n; i++) {
+        if (g->vertices[i].x < minX) minX = g->vertices[i].x;
+        if (g->vertices[i].x > maxX) maxX = g->vertices[i].x;
+        if (g->vertices[i].y < minY) minY = g->vertices[i].y;
+        if (g->vertices[i].y > maxY) maxY = g->vertices[i].y;
+    }
+    double lado = fmax(maxX - minX, maxY - minY);
+    double escala = lado > 0 ? ((1 << BITS_HILBERT) - 1) / lado : 0;
+    for (int i = 0; i < n; i++) {
+        double cx = (g->vertices[i].x - minX) * escala, cy = (g->vertices[i].y - minY) * escala;
+        // Coordenadas no finitas ficam no incio da curva
+        chaves[i].chave = (cx >= 0 && cy >= 0) ? chaveHilbert((unsigned int)fmin(cx, (1 << BITS_HILBERT) - 1),
+                                                               (unsigned int)fmin(cy, (1 << BITS_HILBERT) - 1)) : 0;
+        chaves[i].indice = i;
+    }
+    qsort(chaves, n, sizeof(ChaveVertice), compararChaveVertice);
+    for (int p = 0; p < n; p++) novo[chaves[p].indice] = p;
+    free(chaves);
+    return 1;
+}
+
+// novo[i] recebe a posio do vrtice i na busca em largura pelas arestas (ignorando o sentido), que
+// comea em cada componente pelo primeiro vrtice dela no arquivo
+static int numerarBFS(const NavGrafo* g, const int* origens, const int* destinos, int m, int* novo) {
+    int n = g->totalVertices;
+    int* inicio = calloc(n + 1, sizeof(int));
+    int* vizinhos = malloc((2 * (size_t)m + 1) * sizeof(int));
+    int* fila = malloc((n + 1) * sizeof(int));
+    if (!inicio || !vizinhos || !fila) {
+        free(inicio); free(vizinhos); free(fila);
+        return 0;
+    }
+    for (int i = 0; i < m; i++) {
+        inicio[origens[i]]++;
+        inicio[destinos[i]]++;
+    }
+    for (int v = 0, soma = 0; v <= n; v++) {   // Contagens -> fim de cada lista; o preenchimento volta ao incio
+        soma += v < n ? inicio[v] : 0;
+        inicio[v] = soma;
+    }
+    for (int i = 0; i < m; i++) {
+        vizinhos[--inicio[origens[i]]] = destinos[i];
+        vizinhos[--inicio[destinos[i]]] = origens[i];
+    }
+
+    for (int v = 0; v < n; v++) novo[v] = -1;
+    int total = 0;
+    for (int s = 0; s < n; s++) {
+        if (novo[s] != -1) continue;
+        int cabeca = total;
+        novo[s] = total;
+        fila[total++] = s;
+        while (cabeca < total) {
+            int u = fila[cabeca++];
+            for (int k = inicio[u]; k < inicio[u + 1]; k++) {
+                int v = vizinhos[k];
+                if (novo[v] != -1) continue;
+                novo[v] = total;
+                fila[total++] = v;
+            }
+        }
+    }
+    free(inicio); free(vizinhos); free(fila);
+    return 1;
+}
+
+// Renumera os vrtices j lidos na ordem pedida, antes de montar as adjacncias: move
+// os vrtices, troca os ndices da tabela de IDs e das arestas lidas (origens/destinos, m arestas)
+// e guarda o caminho de volta em g->indiceDoArquivo. Retorna 0 se faltar memria
+static int reordenarVertices(NavGrafo* g, int ordem, int* origens, int* destinos, int m) {
+    int n = g->totalVertices;
+    g->ordemVertices = ORDEM_ARQUIVO;
+    if (ordem == ORDEM_ARQUIVO || n < 2) return 1;
+    int* novo = malloc((n + 1) * sizeof(int));
+    Vertice* copia = malloc((n + 1) * sizeof(Vertice));
+    int ok = novo && copia
+          && (ordem == ORDEM_HILBERT ? numerarHilbert(g, novo) : numerarBFS(g, origens, destinos, m, novo));
+    if (!ok) {
+        free(novo);
+        free(copia);
+        return 0;
+    }
+    CONTAR_BYTES(g, (n + 1) * sizeof(int));
+    for (int i = 0; i < n; i++) copia[novo[i]] = g->vertices[i];
+    memcpy(g->vertices, copia, n * sizeof(Vertice));
+    free(copia);
+    for (unsigned long long k = 0; k <= g->idParaIndice.mascara; k++) {
+        if (g->idParaIndice.indices[k] != -1) g->idParaIndice.indices[k] = novo[g->idParaIndice.indices[k]];
+    }
+    for (int i = 0; i < m; i++) {
+        origens[i] = novo[origens[i]];
+        destinos[i] = novo[destinos[i]];
+    }
+    g->indiceDoArquivo = novo;
+    g->ordemVertices = ordem;
+    return 1;
+}
+
+// Resumo (FNV-1a) dos IDs na ordem interna. Os .ch e .alt guardam ndices internos e s valem
+// para um grafo numerado do mesmo jeito que o usado ao ger-los
+static unsigned long long assinaturaNumeracao(const NavGrafo* g) {
+    unsigned long long h = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < g->totalVertices; i++) {
+        h ^= (unsigned long long)g->vertices[i].id;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+// ------------------------ HEAP MNIMA ------------------------ //
+// Heap binria mnima para organizar os vrtices conforme distncia acumulada
+// As buscas inserem o vrtice de novo a cada melhoria (entradas antigas so descartadas ao
+// extrair um vrtice j visitado), por isso a capacidade  o nmero de arestas dirigidas + 1
+typedef struct {
+    NodoHeap* itens;   // Vetor que representa a heap
+    int tam;           // Tamanho atual da heap
+} HeapMinima;
+
+// Troca os elementos na heap nas posies i e j
+static void trocar(HeapMinima* h, int i, int j) {
+    NodoHeap tmp = h->itens[i];
+    h->itens[i] = h->itens[j];
+    h->itens[j] = tmp;
+}
+
+// Sobe um elemento na heap para garantir a propriedade de heap mnima
+// enquanto o elemento estiver menor que o seu pai, troca com o pai
+static void subir(HeapMinima* h, int i) {
+    while (i > 0 && h->itens[i].dist < h->itens[(i - 1) / 2].dist) {
+        trocar(h, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+// Desce um elemento na heap para garantir a propriedade de heap mnima
+// compara com filhos e troca com o menor deles enquanto necessrio
+static void descer(HeapMinima* h, int i) {
+    while (1) {
+        int menor = i;
+        int esq = 2 * i + 1, dir = 2 * i + 2;
+        if (esq < h->tam && h->itens[esq].dist < h->itens[menor].dist) menor = esq;
+        if (dir < h->tam && h->itens[dir].dist < h->itens[menor].dist) menor = dir;
+        if (menor == i) break;
+        trocar(h, i, menor);
+        i = menor;
+    }
+}
+
+// Insere um novo vrtice na heap, colocando-o no final e subindo para a posio correta
+static void inserirHeap(HeapMinima* h, int id, double dist) {
+    h->itens[h->tam].id = id;
+    h->itens[h->tam].dist = dist;
+    subir(h, h->tam);
+    h->tam++;
+}
+
+// Remove e retorna o vrtice com menor distncia acumulada da heap (raiz da heap)
+static int extrairMin(HeapMinima* h) {
+    int min = h->itens[0].id;           // Vrtice da raiz da heap (menor distncia)
+    h->itens[0] = h->itens[--h->tam];   // Move ltimo elemento para a raiz
+    descer(h, 0);                       // Ajusta a heap descendo o elemento
+    return min;                         // Retorna o vrtice removido (menor distncia)
+}
+
+// Aloca a heap com espao para 'capacidade' entradas
+// Retorna 1 se bem sucedido, 0 se faltar memria
+static int alocarHeap(HeapMinima* h, int capacidade) {
+    h->itens = malloc(capacidade * sizeof(NodoHeap));
+    h->tam = 0;
+    return h->itens != NULL;
+}
+
+static void liberarHeap(HeapMinima* h) {
+    free(h->itens);
+    h->itens = NULL;
+    h->tam = 0;
+}
+
+// ------------------------ HEAP 4-RIA INDEXADA ------------------------ //
+// Cada vrtice aparece no mximo uma vez: uma melhoria de distncia diminui a chave da entrada
+// que j est na heap em vez de inserir outra. A capacidade  o nmero de vrtices e a altura
+// da rvore cai pela metade em relao  heap binria, ao custo de comparar 4 filhos ao descer
+#define ARIDADE_HEAP 4
+
+typedef struct {
+    NodoHeap* itens;   // Vetor que representa a heap
+    int* pos;          // Posio de cada vrtice em itens, ou -1 se ele no est na heap
+    int tam;
+} HeapIndexada;
+
+// Sobe o elemento da posio i abrindo espao (sem trocas), at achar um pai com chave menor
+static void subirIndexada(HeapIndexada* h, int i) {
+    NodoHeap x = h->itens[i];
+    while (i > 0) {
+        int pai = (i - 1) / ARIDADE_HEAP;
+        if (h->itens[pai].dist <= x.dist) break;
+        h->itens[i] = h->itens[pai];
+        h->pos[h->itens[i].id] = i;
+        i = pai;
+    }
+    h->itens[i] = x;
+    h->pos[x.id] = i;
+}
+
+// Desce o elemento da posio i trocando de lugar com o menor dos filhos enquanto necessrio
+static void descerIndexada(HeapIndexada* h, int i) {
+    NodoHeap x = h->itens[i];
+    while (1) {
+        int primeiro = ARIDADE_HEAP * i + 1;
+        if (primeiro >= h->tam) break;
+        int ultimo = primeiro + ARIDADE_HEAP < h->tam ? primeiro + ARIDADE_HEAP : h->tam;
+        int menor = primeiro;
+        for (int f = primeiro + 1; f < ultimo; f++)
+            if (h->itens[f].dist < h->itens[menor].dist) menor = f;
+        if (h->itens[menor].dist >= x.dist) break;
+        h->itens[i] = h->itens[menor];
+        h->pos[h->itens[i].id] = i;
+        i = menor;
+    }
+    h->itens[i] = x;
+    h->pos[x.id] = i;
+}
+
+// Insere o vrtice ou diminui sua chave se ele j est na heap
+// Retorna 1 se inseriu, 2 se diminuiu a chave, 0 se a chave atual j era menor ou igual
+static int inserirOuDiminuir(HeapIndexada* h, int id, double dist) {
+    int i = h->pos[id];
+    if (i == -1) {
+        i = h->tam++;
+        h->itens[i].id = id;
+        h->itens[i].dist = dist;
+        subirIndexada(h, i);
+        return 1;
+    }
+    if (dist >= h->itens[i].dist) return 0;
+    h->itens[i].dist = dist;
+    subirIndexada(h, i);
+    return 2;
+}
+
+// Troca a chave de um vrtice que est na heap, para mais ou para menos
+static void alterarChaveIndexada(HeapIndexada* h, int id, double dist) {
+    int i = h->pos[id];
+    double antiga = h->itens[i].dist;
+    h->itens[i].dist = dist;
+    if (dist < antiga) subirIndexada(h, i);
+    else descerIndexada(h, i);
+}
+
+static int extrairMinIndexada(HeapIndexada* h) {
+    int min = h->itens[0].id;
+    h->pos[min] = -1;
+    if (--h->tam > 0) {
+        h->itens[0] = h->itens[h->tam];
+        descerIndexada(h, 0);
+    }
+    return min;
+}
+
+// Esvazia a heap desmarcando s os vrtices que ainda estavam nela
+static void esvaziarIndexada(HeapIndexada* h) {
+    for (int i = 0; i < h->tam; i++) h->pos[h->itens[i].id] = -1;
+    h->tam = 0;
+}
+
+static int alocarIndexada(HeapIndexada* h, int totalVertices) {
+    h->itens = malloc((totalVertices + 1) * sizeof(NodoHeap));
+    h->pos = malloc((totalVertices + 1) * sizeof(int));
+    h->tam = 0;
+    if (!h->itens || !h->pos) return 0;
+    for (int v = 0; v <= totalVertices; v++) h->pos[v] = -1;
+    return 1;
+}
+
+static void liberarIndexada(HeapIndexada* h) {
+    free(h->itens);
+    free(h->pos);
+    memset(h, 0, sizeof(HeapIndexada));
+}
+
+// ------------------------ RADIX HEAP ------------------------ //
+// Fila montona: as chaves extradas nunca diminuem, o que vale para Dijkstra, para o A* com
+// heurstica consistente e para cada sentido das buscas bidirecionais. As chaves so quantizadas
+// em mltiplos de QUANTUM_RADIX e cada entrada fica no balde dado pelo bit mais alto em que a sua
+// chave difere da ltima extrada; extrair s redistribui o primeiro balde no vazio. Com pesos
+// inteiros (ou mltiplos do quantum) a ordem  exata; nos demais, empates abaixo do quantum podem
+// sair fora de ordem, com erro no custo menor que QUANTUM_RADIX por vrtice do caminho.
+// Como a heap binria, uma melhoria insere outra entrada (remoo preguiosa)
+#define QUANTUM_RADIX 1e-6
+#define TOTAL_BALDES_RADIX 65
+
+typedef struct {
+    int* vertice;                    // Entradas, encadeadas em listas (uma por balde) por 'proximo'
+    double* chave;                   // Chave original de cada entrada
+    unsigned long long* quantizada;  // Chave quantizada de cada entrada
+    int* proximo;
+    int livre;                       // Lista de entradas livres
+    int balde[TOTAL_BALDES_RADIX];   // Primeira entrada de cada balde, -1 se vazio
+    unsigned long long ultima;       // ltima chave quantizada extrada
+} HeapRadix;
+
+// Converte a chave para inteiro sem sinal preservando a ordem (inclusive para chaves negativas,
+// que aparecem com os potenciais da busca bidirecional A*)
+static unsigned long long quantizarChave(double chave) {
+    long long q = (long long)floor(chave / QUANTUM_RADIX);
+    return (unsigned long long)q ^ (1ULL << 63);
+}
+
+// Balde de uma chave: 0 se igual  ltima extrada, seno a posio do bit mais alto diferente
+static int baldeRadix(unsigned long long q, unsigned long long ultima) {
+    unsigned long long x = q ^ ultima;
+    if (x == 0) return 0;
+#ifdef __GNUC__
+    return 64 - __builtin_clzll(x);
+#else
+    int b = 0;
+    while (x) { b++; x >>= 1; }
+    return b;
+#endif
+}
+
+static void inserirRadix(HeapRadix* h, int id, double chave) {
+    unsigned long long q = quantizarChave(chave);
+    if (q < h->ultima) q = h->ultima;   // Arredondamento abaixo da ltima extrada
+    int e = h->livre;
+    h->livre = h->proximo[e];
+    h->vertice[e] = id;
+    h->chave[e] = chave;
+    h->quantizada[e] = q;
+    int b = baldeRadix(q, h->ultima);
+    h->proximo[e] = h->balde[b];
+    h->balde[b] = e;
+}
+
+// Garante que o balde 0 tem as entradas de menor chave: se estiver vazio, a menor chave do primeiro
+// balde no vazio passa a ser a ltima extrada e as entradas desse balde descem para baldes menores
+static void prepararRadix(HeapRadix* h) {
+    if (h->balde[0] != -1) return;
+    int b = 1;
+    while (h->balde[b] == -1) b++;
+    unsigned long long menor = h->quantizada[h->balde[b]];
+    for (int e = h->balde[b]; e != -1; e = h->proximo[e])
+        if (h->quantizada[e] < menor) menor = h->quantizada[e];
+    h->ultima = menor;
+    int e = h->balde[b];
+    h->balde[b] = -1;
+    while (e != -1) {
+        int prox = h->proximo[e];
+        int novo = baldeRadix(h->quantizada[e], menor);
+        h->proximo[e] = h->balde[novo];
+        h->balde[novo] = e;
+        e = prox;
+    }
+}
+
+static int extrairMinRadix(HeapRadix* h) {
+    prepararRadix(h);
+    int e = h->balde[0];
+    h->balde[0] = h->proximo[e];
+    h->proximo[e] = h->livre;
+    h->livre = e;
+    return h->vertice[e];
+}
+
+static double menorChaveRadix(HeapRadix* h) {
+    prepararRadix(h);
+    return h->chave[h->balde[0]];
+}
+
+// Devolve todas as entradas  lista livre percorrendo s os baldes ocupados
+static void esvaziarRadix(HeapRadix* h) {
+    for (int b = 0; b < TOTAL_BALDES_RADIX; b++) {
+        int e = h->balde[b];
+        while (e != -1) {
+            int prox = h->proximo[e];
+            h->proximo[e] = h->livre;
+            h->livre = e;
+            e = prox;
+        }
+        h->balde[b] = -1;
+    }
+    h->ultima = 0;
+}
+
+static int alocarRadix(HeapRadix* h, int capacidade) {
+    h->vertice = malloc(capacidade * sizeof(int));
+    h->chave = malloc(capacidade * sizeof(double));
+    h->quantizada = malloc(capacidade * sizeof(unsigned long long));
+    h->proximo = malloc(capacidade * sizeof(int));
+    if (!h->vertice || !h->chave || !h->quantizada || !h->proximo) return 0;
+    for (int e = 0; e < capacidade; e++) h->proximo[e] = e + 1 < capacidade ? e + 1 : -1;
+    h->livre = 0;
+    for (int b = 0; b < TOTAL_BALDES_RADIX; b++) h->balde[b] = -1;
+    h->ultima = 0;
+    return 1;
+}
+
+static void liberarRadix(HeapRadix* h) {
+    free(h->vertice);
+    free(h->chave);
+    free(h->quantizada);
+    free(h->proximo);
+    memset(h, 0, sizeof(HeapRadix));
+}
+
+// ------------------------ FILA DE PRIORIDADE DAS BUSCAS ------------------------ //
+// Interface comum s trs filas, usada pelas buscas das consultas. 'tam' conta as entradas de
+// qualquer tipo de fila, e os contadores acumulam as operaes at serem zerados
+typedef struct {
+    TipoFila tipo;
+    int tam;                       // Entradas na fila (na heap indexada, vrtices distintos)
+    HeapMinima binaria;            // FILA_BINARIA
+    HeapIndexada indexada;         // FILA_QUATERNARIA
+    HeapRadix radix;               // FILA_RADIX
+    NavContadoresFila contadores;
+    long long bytes;               // Memria alocada pela fila (s com NAV_METRICAS)
+} FilaPrioridade;
+
+static void inserirFila(FilaPrioridade* f, int id, double chave) {
+    switch (f->tipo) {
+        case FILA_QUATERNARIA: {
+            int r = inserirOuDiminuir(&f->indexada, id, chave);
+            if (r == 2) f->contadores.diminuicoes++;
+            if (r != 1) return;
+            break;
+        }
+        case FILA_RADIX:
+            inserirRadix(&f->radix, id, chave);
+            break;
+        default:
+            inserirHeap(&f->binaria, id, chave);
+            break;
+    }
+    f->tam++;
+    f->contadores.insercoes++;
+    if (f->tam > f->contadores.maiorTamanho) f->contadores.maiorTamanho = f->tam;
+}
+
+static int extrairMinFila(FilaPrioridade* f) {
+    f->tam--;
+    f->contadores.extracoes++;
+    switch (f->tipo) {
+        case FILA_QUATERNARIA: return extrairMinIndexada(&f->indexada);
+        case FILA_RADIX: return extrairMinRadix(&f->radix);
+        default: return extrairMin(&f->binaria);
+    }
+}
+
+// Chave da entrada que extrairMinFila devolveria; a fila no pode estar vazia
+static double menorChaveFila(FilaPrioridade* f) {
+    switch (f->tipo) {
+        case FILA_QUATERNARIA: return f->indexada.itens[0].dist;
+        case FILA_RADIX: return menorChaveRadix(&f->radix);
+        default: return f->binaria.itens[0].dist;
+    }
+}
+
+static void esvaziarFila(FilaPrioridade* f) {
+    switch (f->tipo) {
+        case FILA_QUATERNARIA: esvaziarIndexada(&f->indexada); break;
+        case FILA_RADIX: esvaziarRadix(&f->radix); break;
+        default: f->binaria.tam = 0; break;
+    }
+    f->tam = 0;
+}
+
+// Aloca a fila do tipo pedido. As filas com remoo preguiosa precisam de 'capacidade' entradas
+// (uma por aresta percorrida); a indexada, de uma por vrtice. Retorna 1 se bem sucedido
+static int alocarFila(FilaPrioridade* f, TipoFila tipo, int capacidade, int totalVertices) {
+    memset(f, 0, sizeof(FilaPrioridade));
+    f->tipo = tipo;
+    METRICA(f->bytes = tipo == FILA_QUATERNARIA ? (long long)(totalVertices + 1) * (sizeof(NodoHeap) + sizeof(int))
+                     : tipo == FILA_RADIX ? (long long)capacidade * (2 * sizeof(int) + sizeof(double) + sizeof(unsigned long long))
+                     : (long long)capacidade * sizeof(NodoHeap));
+    switch (tipo) {
+        case FILA_QUATERNARIA: return alocarIndexada(&f->indexada, totalVertices);
+        case FILA_RADIX: return alocarRadix(&f->radix, capacidade);
+        default: return alocarHeap(&f->binaria, capacidade);
+    }
+}
+
+static void liberarFila(FilaPrioridade* f) {
+    liberarHeap(&f->binaria);
+    liberarIndexada(&f->indexada);
+    liberarRadix(&f->radix);
+    f->tam = 0;
+}
+
+// ------------------------ ESPAO DE BUSCA ------------------------ //
+// rvore de caminhos mnimos guardada no cache de um espao de busca (veja CACHE DE RVORES)
+typedef struct ArvoreCache {
+    int origem;                // ndice interno da origem
+    unsigned int versao;       // Verso do grafo quando a rvore foi calculada
+    int completa;              // 1 se a busca esgotou a fila: todos os vrtices alcanveis esto fechados
+    int pendente;              // Vrtice fechado cujas arestas ainda no foram relaxadas (-1 se nenhum)
+    double* dist;              // Estado do Dijkstra a partir da origem; com completa == 0, os vrtices
+    int* anterior;             // com dist < NAV_INF e no fechados formam a fronteira da busca
+    int* fechado;
+    struct ArvoreCache* maisRecente;   // Lista LRU duplamente encadeada
+    struct ArvoreCache* menosRecente;
+} ArvoreCache;
+
+// Cache LRU de rvores por origem, limitado em bytes (desligado com bytesMaximos == 0)
+typedef struct {
+    long long bytesMaximos;
+    ArvoreCache** daOrigem;    // rvore guardada de cada vrtice (NULL se no h), para busca em O(1)
+    ArvoreCache* primeira;     // Usada mais recentemente
+    ArvoreCache* ultima;       // Prxima a ser descartada
+    NavContadoresCache contadores;
+} CacheArvores;
+
+// Estado de uma busca em andamento: vetores por vrtice e heaps. As buscas s leem o grafo,
+// ento cada thread com o seu espao de busca pode consultar o mesmo grafo ao mesmo tempo
+struct NavEspaco {
+    const NavGrafo* grafo; // Grafo para o qual os vetores foram dimensionados
+    double* dist;          // Distncias da busca direta (a partir da origem)
+    double* distReversa;   // Distncias da busca reversa (at o destino), nas buscas bidirecionais
+    int* visitado;         // Vrtices j fechados pela busca direta
+    int* visitadoReversa;  // Vrtices j fechados pela busca reversa
+    int* anterior;         // Predecessor de cada vrtice na rvore da busca direta
+    int* sucessor;         // Sucessor (rumo ao destino) de cada vrtice na rvore da busca reversa
+    int* meioAnterior;     // Vrtice pulado pelo atalho usado para chegar ao vrtice (CH)
+    int* meioSucessor;     // Vrtice pulado pelo atalho usado para sair do vrtice (CH)
+    int* caminho;          // Caminho da ltima consulta (ndices internos)
+    NavId* caminhoIds;     // O mesmo caminho em IDs originais, devolvido em NavResultado
+    int* trechos;          // rea auxiliar de 3 * totalVertices para montar o caminho (CH)
+    int* pilha;            // rea auxiliar de 3 * totalVertices para desempacotar atalhos (CH)
+    int* alvo;             // Marca os destinos ainda no fechados da busca um-para-muitos (zerado entre buscas)
+    FilaPrioridade heap;   // Fila da busca direta
+    FilaPrioridade heapReversa; // Fila da busca reversa
+    int capacidadeFila;    // Entradas de cada fila com remoo preguiosa (veja capacidadeHeapConsultas)
+    NavMetricas metricas;  // Da ltima consulta; os contadores s avanam com NAV_METRICAS
+    CacheArvores cache;    // rvores dos modos dijkstra e parada por origem (navDefinirCache)
+    long long bytesVetores; // Memria dos vetores acima, sem as filas (s com NAV_METRICAS)
+};
+typedef struct NavEspaco EspacoBusca;
+
+// Bytes ocupados por uma rvore do cache em um grafo com n vrtices
+static long long bytesArvoreCache(int n) {
+    return (long long)sizeof(ArvoreCache) + (long long)(n + 1) * (sizeof(double) + 2 * sizeof(int));
+}
+
+// Tira a rvore da lista LRU (sem liber-la)
+static void desligarArvoreCache(CacheArvores* c, ArvoreCache* a) {
+    if (a->maisRecente) a->maisRecente->menosRecente = a->menosRecente;
+    else c->primeira = a->menosRecente;
+    if (a->menosRecente) a->menosRecente->maisRecente = a->maisRecente;
+    else c->ultima = a->maisRecente;
+    a->maisRecente = a->menosRecente = NULL;
+}
+
+// Coloca a rvore no incio da lista LRU (usada mais recentemente)
+static void ligarArvoreCache(CacheArvores* c, ArvoreCache* a) {
+    a->maisRecente = NULL;
+    a->menosRecente = c->primeira;
+    if (c->primeira) c->primeira->maisRecente = a;
+    else c->ultima = a;
+    c->primeira = a;
+}
+
+// Remove a rvore do cache e libera sua memria
+static void removerArvoreCache(CacheArvores* c, ArvoreCache* a, int n) {
+    desligarArvoreCache(c, a);
+    c->daOrigem[a->origem] = NULL;
+    c->contadores.arvores--;
+    c->contadores.bytes -= bytesArvoreCache(n);
+    free(a->dist);
+    free(a->anterior);
+    free(a->fechado);
+    free(a);
+}
+
+static void liberarEspacoBusca(EspacoBusca* eb) {
+    while (eb->cache.ultima) removerArvoreCache(&eb->cache, eb->cache.ultima, eb->grafo->totalVertices);
+    free(eb->cache.daOrigem);
+    free(eb->dist); free(eb->distReversa);
+    free(eb->visitado); free(eb->visitadoReversa);
+    free(eb->anterior); free(eb->sucessor);
+    free(eb->meioAnterior); free(eb->meioSucessor);
+    free(eb->caminho); free(eb->caminhoIds); free(eb->trechos); free(eb->pilha);
+    free(eb->alvo);
+    liberarFila(&eb->heap);
+    liberarFila(&eb->heapReversa);
+    memset(eb, 0, sizeof(EspacoBusca));
+}
+
+// Aloca um espao de busca para o grafo carregado, com filas do tipo pedido; capacidadeHeap deve
+// comportar uma entrada por aresta percorrida (veja capacidadeHeapConsultas). Retorna 1 se bem sucedido
+static int alocarEspacoBusca(const NavGrafo* g, EspacoBusca* eb, int capacidadeHeap, TipoFila tipoFila) {
+    int n = g->totalVertices + 1;
+    memset(eb, 0, sizeof(EspacoBusca));
+    eb->grafo = g;
+    eb->dist = malloc(n * sizeof(double));
+    eb->distReversa = malloc(n * sizeof(double));
+    eb->visitado = malloc(n * sizeof(int));
+    eb->visitadoReversa = malloc(n * sizeof(int));
+    eb->anterior = malloc(n * sizeof(int));
+    eb->sucessor = malloc(n * sizeof(int));
+    eb->meioAnterior = malloc(n * sizeof(int));
+    eb->meioSucessor = malloc(n * sizeof(int));
+    eb->caminho = malloc(n * sizeof(int));
+    eb->caminhoIds = malloc(n * sizeof(NavId));
+    eb->trechos = malloc(3 * n * sizeof(int));
+    eb->pilha = malloc(3 * n * sizeof(int));
+    eb->alvo = calloc(n, sizeof(int));
+    METRICA(eb->bytesVetores = (long long)n * (2 * sizeof(double) + 14 * sizeof(int) + sizeof(NavId)));
+    int ok = eb->dist && eb->distReversa && eb->visitado && eb->visitadoReversa && eb->anterior
+          && eb->sucessor && eb->meioAnterior && eb->meioSucessor && eb->caminho && eb->caminhoIds && eb->trechos && eb->pilha
+          && eb->alvo && alocarFila(&eb->heap, tipoFila, capacidadeHeap, g->totalVertices)
+          && alocarFila(&eb->heapReversa, tipoFila, capacidadeHeap, g->totalVertices);
+    eb->capacidadeFila = capacidadeHeap;
+    if (!ok) liberarEspacoBusca(eb);
+    return ok;
+}
+
+// ------------------------ COMPONENTES CONEXAS ------------------------ //
+// Mapas extrados do OpenStreetMap costumam ter fragmentos desconectados, e sem caminho o Dijkstra
+// s descobre isso depois de fechar tudo o que a origem alcana. As componentes permitem recusar
+// esses pares em O(1): no h caminho de s a t se esto em componentes fracas diferentes ou se a
+// componente forte de s tem nmero menor que a de t (numerao em ordem topolgica reversa)
+
+// Tarjan iterativo (pilha de chamadas explcita, para no estourar a pilha em grafos grandes) para
+// as componentes fortes e busca em largura sobre as arestas nos dois sentidos para as fracas
+// Retorna 1 se bem sucedido, 0 se faltar memria
+static int calcularComponentes(NavGrafo* g) {
+    int n = g->totalVertices;
+    g->componenteForte = malloc((n + 1) * sizeof(int));
+    g->componenteFraca = malloc((n + 1) * sizeof(int));
+    int* ordem = malloc((n + 1) * sizeof(int));          // Ordem de descoberta, -1 se no visitado
+    int* baixo = malloc((n + 1) * sizeof(int));          // Menor ordem alcanvel pela subrvore (lowlink)
+    int* proximaAresta = malloc((n + 1) * sizeof(int));  // Prxima aresta a examinar de cada vrtice aberto
+    int* chamadas = malloc((n + 1) * sizeof(int));       // Vrtices abertos, como na recurso
+    int* pilha = malloc((n + 1) * sizeof(int));          // Pilha de Tarjan (depois, fila da busca em largura)
+    int ok = g->componenteForte && g->componenteFraca && ordem && baixo && proximaAresta && chamadas && pilha;
+    if (ok) {
+        CONTAR_BYTES(g, 7 * (n + 1) * sizeof(int));
+        for (int v = 0; v < n; v++) ordem[v] = g->componenteForte[v] = g->componenteFraca[v] = -1;
+
+        // Um vrtice est na pilha de Tarjan enquanto foi visitado e ainda no tem componente
+        int contador = 0, topoPilha = 0;
+        g->totalComponentesFortes = 0;
+        for (int raiz = 0; raiz < n; raiz++) {
+            if (ordem[raiz] != -1) continue;
+            int topo = 0;
+            ordem[raiz] = baixo[raiz] = contador++;
+            proximaAresta[raiz] = g->inicioAresta[raiz];
+            pilha[topoPilha++] = raiz;
+            chamadas[topo++] = raiz;
+            while (topo > 0) {
+                int u = chamadas[topo - 1];
+                if (proximaAresta[u] < g->inicioAresta[u + 1]) {
+                    int v = g->destinoAresta[proximaAresta[u]++];
+                    if (ordem[v] == -1) {
+                        ordem[v] = baixo[v] = contador++;
+                        proximaAresta[v] = g->inicioAresta[v];
+                        pilha[topoPilha++] = v;
+                        chamadas[topo++] = v;
+                    } else if (g->componenteForte[v] == -1 && ordem[v] < baixo[u]) {
+                        baixo[u] = ordem[v];
+                    }
+                    continue;
+                }
+                // Todas as arestas de u examinadas: "retorna" para o vrtice que o descobriu
+                topo--;
+                if (baixo[u] == ordem[u]) {
+                    int w;
+                    do {
+                        w = pilha[--topoPilha];
+                        g->componenteForte[w] = g->totalComponentesFortes;
+                    } while (w != u);
+                    g->totalComponentesFortes++;
+                }
+                if (topo > 0 && baixo[u] < baixo[chamadas[topo - 1]]) baixo[chamadas[topo - 1]] = baixo[u];
+            }
+        }
+
+        g->totalComponentesFracas = 0;
+        for (int raiz = 0; raiz < n; raiz++) {
+            if (g->componenteFraca[raiz] != -1) continue;
+            int inicio = 0, fim = 0;
+            pilha[fim++] = raiz;
+            g->componenteFraca[raiz] = g->totalComponentesFracas;
+            while (inicio < fim) {
+                int u = pilha[inicio++];
+                for (int e = g->inicioAresta[u]; e < g->inicioAresta[u + 1]; e++) {
+                    int v = g->destinoAresta[e];
+                    if (g->componenteFraca[v] == -1) {
+                        g->componenteFraca[v] = g->totalComponentesFracas;
+                        pilha[fim++] = v;
+                    }
+                }
+                for (int e = g->inicioArestaReversa[u]; e < g->inicioArestaReversa[u + 1]; e++) {
+                    int v = g->origemArestaReversa[e];
+                    if (g->componenteFraca[v] == -1) {
+                        g->componenteFraca[v] = g->totalComponentesFracas;
+                        pilha[fim++] = v;
+                    }
+                }
+            }
+            g->totalComponentesFracas++;
+        }
+    }
+    free(ordem); free(baixo); free(proximaAresta); free(chamadas); free(pilha);
+    return ok;
+}
+
+// 1 se pode existir caminho de 'origem' a 'destino' (ndices internos), 0 se certamente no existe
+static int caminhoPossivel(const NavGrafo* g, int origem, int destino) {
+    return g->componenteFraca[origem] == g->componenteFraca[destino]
+        && g->componenteForte[origem] >= g->componenteForte[destino];
+}
+
+// ------------------------ NDICE ESPACIAL ------------------------ //
+// Quem usa a biblioteca conhece coordenadas, no IDs, e o front-end precisa saber o que est na tela
+// ou sob o mouse. Uma grade uniforme com poucos vrtices por clula responde essas consultas olhando
+// s as clulas prximas do ponto ou do retngulo, em vez de percorrer o grafo inteiro
+#define VERTICES_POR_CELULA 2
+
+// Coluna/linha da grade que contm a coordenada; pontos fora da grade vo para a borda
+static int colunaGrade(const GradeEspacial* gr, double x) {
+    double c = floor((x - gr->minX) / gr->lado);
+    if (!(c >= 0)) return 0;   // Tambm trata NaN
+    return c >= gr->colunas ? gr->colunas - 1 : (int)c;
+}
+
+static int linhaGrade(const GradeEspacial* gr, double y) {
+    double l = floor((y - gr->minY) / gr->lado);
+    if (!(l >= 0)) return 0;
+    return l >= gr->linhas ? gr->linhas - 1 : (int)l;
+}
+
+// Arestas de mo dupla aparecem duas vezes no CSR; a grade guarda s o sentido com origem < destino
+static int arestaIndexada(const NavGrafo* g, int u, int v) {
+    if (u <= v) return 1;
+    for (int e = g->inicioAresta[v]; e < g->inicioAresta[v + 1]; e++)
+        if (g->destinoAresta[e] == u) return 0;
+    return 1;
+}
+
+// Retngulo de clulas coberto pelo retngulo envolvente da aresta u-v
+static void celulasAresta(const NavGrafo* g, int u, int v, int* c1, int* l1, int* c2, int* l2) {
+    const Vertice* a = &g->vertices[u];
+    const Vertice* b = &g->vertices[v];
+    *c1 = colunaGrade(&g->grade, fmin(a->x, b->x));
+    *c2 = colunaGrade(&g->grade, fmax(a->x, b->x));
+    *l1 = linhaGrade(&g->grade, fmin(a->y, b->y));
+    *l2 = linhaGrade(&g->grade, fmax(a->y, b->y));
+}
+
+// Distribui vrtices e arestas nas clulas por contagem (duas passadas, sem listas encadeadas). O lado
+// da clula  escolhido para dar cerca de VERTICES_POR_CELULA vrtices por clula se os pontos fossem
+// uniformes no retngulo envolvente. Retorna 1 se bem sucedido, 0 se faltar memria
+static int construirGrade(NavGrafo* g) {
+    GradeEspacial* gr = &g->grade;
+    int n = g->totalVertices;
+    double maxX = 0, maxY = 0;
+    gr->minX = gr->minY = 0;
+    for (int v = 0; v < n; v++) {
+        if (v == 0 || g->vertices[v].x < gr->minX) gr->minX = g->vertices[v].x;
+        if (v == 0 || g->vertices[v].y < gr->minY) gr->minY = g->vertices[v].y;
+        if (v == 0 || g->vertices[v].x > maxX) maxX = g->vertices[v].x;
+        if (v == 0 || g->vertices[v].y > maxY) maxY = g->vertices[v].y;
+    }
+    double largura = maxX - gr->minX, altura = maxY - gr->minY;
+    double porCelula = (double)VERTICES_POR_CELULA / (n > 0 ? n : 1);
+    gr->lado = largura * altura > 0 ? sqrt(largura * altura * porCelula) : fmax(largura, altura) * porCelula;
+    if (!(gr->lado > 0)) gr->lado = 1;
+    // Em mapas muito alongados o lado acima gera clulas demais; limita a algumas por vrtice
+    for (;;) {
+        double colunas = floor(largura / gr->lado) + 1, linhas = floor(altura / gr->lado) + 1;
+        if (colunas * linhas <= 4.0 * n + 16) {
+            gr->colunas = (int)colunas;
+            gr->linhas = (int)linhas;
+            break;
+        }
+        gr->lado *= 2;
+    }
+    int celulas = gr->colunas * gr->linhas;
+
+    gr->inicioVertices = calloc(celulas + 1, sizeof(int));
+    gr->verticeCelula = malloc((n + 1) * sizeof(int));
+    gr->inicioArestas = calloc(celulas + 1, sizeof(int));
+    if (!gr->inicioVertices || !gr->verticeCelula || !gr->inicioArestas) return 0;
+    CONTAR_BYTES(g, 2 * (celulas + 1) * sizeof(int) + (n + 1) * sizeof(int));
+
+    for (int v = 0; v < n; v++)
+        gr->inicioVertices[linhaGrade(gr, g->vertices[v].y) * gr->colunas + colunaGrade(gr, g->vertices[v].x) + 1]++;
+    for (int c = 0; c < celulas; c++) gr->inicioVertices[c + 1] += gr->inicioVertices[c];
+    for (int v = 0; v < n; v++) {
+        int c = linhaGrade(gr, g->vertices[v].y) * gr->colunas + colunaGrade(gr, g->vertices[v].x);
+        gr->verticeCelula[gr->inicioVertices[c]++] = v;
+    }
+    // inicioVertices[c] avanou at o incio da clula seguinte; desloca de volta
+    for (int c = celulas; c > 0; c--) gr->inicioVertices[c] = gr->inicioVertices[c - 1];
+    gr->inicioVertices[0] = 0;
+
+    long long entradas = 0;
+    for (int u = 0; u < n; u++) {
+        for (int e = g->inicioAresta[u]; e < g->inicioAresta[u + 1]; e++) {
+            int v = g->destinoAresta[e], c1, l1, c2, l2;
+            if (!arestaIndexada(g, u, v)) continue;
+            celulasAresta(g, u, v, &c1, &l1, &c2, &l2);
+            for (int l = l1; l <= l2; l++)
+                for (int c = c1; c <= c2; c++) gr->inicioArestas[l * gr->colunas + c + 1]++;
+            entradas += (long long)(c2 - c1 + 1) * (l2 - l1 + 1);
+        }
+    }
+    if (entradas > 0x3fffffff) {
+        fprintf(stderr, "Erro: arestas longas demais para o ndice espacial\n");
+        return 0;
+    }
+    gr->totalEntradasArestas = (int)entradas;
+    gr->arestaCelula = malloc((2 * entradas + 1) * sizeof(int));
+    if (!gr->arestaCelula) return 0;
+    CONTAR_BYTES(g, (2 * entradas + 1) * sizeof(int));
+    for (int c = 0; c < celulas; c++) gr->inicioArestas[c + 1] += gr->inicioArestas[c];
+    for (int u = 0; u < n; u++) {
+        for (int e = g->inicioAresta[u]; e < g->inicioAresta[u + 1]; e++) {
+            int v = g->destinoAresta[e], c1, l1, c2, l2;
+            if (!arestaIndexada(g, u, v)) continue;
+            celulasAresta(g, u, v, &c1, &l1, &c2, &l2);
+            for (int l = l1; l <= l2; l++) {
+                for (int c = c1; c <= c2; c++) {
+                    int k = gr->inicioArestas[l * gr->colunas + c]++;
+                    gr->arestaCelula[2 * k] = u;
+                    gr->arestaCelula[2 * k + 1] = v;
+                }
+            }
+        }
+    }
+    for (int c = celulas; c > 0; c--) gr->inicioArestas[c] = gr->inicioArestas[c - 1];
+    gr->inicioArestas[0] = 0;
+    return 1;
+}
+
+// Distncia do ponto (x, y) ao segmento a-b; 'fracao' recebe a posio do ponto mais prximo
+// (0 em a, 1 em b)
+static double distanciaSegmento(const Vertice* a, const Vertice* b, double x, double y, double* fracao) {
+    double dx = b->x - a->x, dy = b->y - a->y;
+    double comprimento2 = dx * dx + dy * dy;
+    double t = comprimento2 > 0 ? ((x - a->x) * dx + (y - a->y) * dy) / comprimento2 : 0;
+    if (t < 0) t = 0;
+    if (t > 1) t = 1;
+    *fracao = t;
+    return hypot(x - (a->x + t * dx), y - (a->y + t * dy));
+}
+
+// Vrtice (buscarAresta == 0) ou aresta (buscarAresta == 1) mais prximos de (x, y). Percorre anis de
+// clulas cada vez maiores ao redor da clula do ponto: tudo o que fica fora dos anis 0..r est a
+// pelo menos r * lado do ponto, ento a busca termina assim que o melhor candidato est mais perto que
+// isso. Devolve a distncia (INFINITY se o grafo no tem o que buscar) e o vrtice em *u ou a aresta
+// em *u, *v e *fracao
+static double maisProximoNaGrade(const NavGrafo* g, double x, double y, int buscarAresta, int* u, int* v, double* fracao) {
+    const GradeEspacial* gr = &g->grade;
+    double melhor = INFINITY;
+    int cx = colunaGrade(gr, x), cy = linhaGrade(gr, y);
+    int maiorRaio = gr->colunas > gr->linhas ? gr->colunas : gr->linhas;
+    for (int r = 0; r <= maiorRaio && !(melhor <= (r - 1) * gr->lado); r++) {
+        for (int l = cy - r; l <= cy + r; l++) {
+            if (l < 0 || l >= gr->linhas) continue;
+            // Nas linhas do meio do anel s as duas clulas das pontas pertencem a ele
+            int passo = (l == cy - r || l == cy + r) ? 1 : 2 * r;
+            for (int c = cx - r; c <= cx + r; c += passo) {
+                if (c < 0 || c >= gr->colunas) continue;
+                int celula = l * gr->colunas + c;
+                if (!buscarAresta) {
+                    for (int k = gr->inicioVertices[celula]; k < gr->inicioVertices[celula + 1]; k++) {
+                        int w = gr->verticeCelula[k];
+                        double d = hypot(g->vertices[w].x - x, g->vertices[w].y - y);
+                        if (d < melhor) { melhor = d; *u = w; }
+                    }
+                } else {
+                    for (int k = gr->inicioArestas[celula]; k < gr->inicioArestas[celula + 1]; k++) {
+                        int a = gr->arestaCelula[2 * k], b = gr->arestaCelula[2 * k + 1];
+                        double t, d = distanciaSegmento(&g->vertices[a], &g->vertices[b], x, y, &t);
+                        if (d < melhor) { melhor = d; *u = a; *v = b; *fracao = t; }
+                    }
+                }
+            }
+        }
+    }
+    return melhor;
+}
+
+// 1 se o segmento a-b tem algum ponto no retngulo [x1, x2] x [y1, y2] (recorte de Liang-Barsky)
+static int segmentoNoRetangulo(const Vertice* a, const Vertice* b, double x1, double y1, double x2, double y2) {
+    double dx = b->x - a->x, dy = b->y - a->y, t0 = 0, t1 = 1;
+    double p[4] = { -dx, dx, -dy, dy };
+    double q[4] = { a->x - x1, x2 - a->x, a->y - y1, y2 - a->y };
+    for (int i = 0; i < 4; i++) {
+        if (p[i] == 0) {
+            if (q[i] < 0) return 0;   // Paralelo ao lado e do lado de fora
+            continue;
+        }
+        double t = q[i] / p[i];
+        if (p[i] < 0) {
+            if (t > t1) return 0;
+            if (t > t0) t0 = t;
+        } else {
+            if (t < t0) return 0;
+            if (t < t1) t1 = t;
+        }
+    }
+    return 1;
+}
+
+// Vrtices (arestas == 0) ou arestas (arestas == 1) no retngulo [x1, x2] x [y1, y2]. Grava at 'max'
+// resultados em ids (e, para arestas, em ids2) e retorna quantos existem ao todo. Uma aresta aparece
+// em todas as clulas que seu retngulo envolvente cobre; ela  relatada s na primeira clula desse
+// conjunto que tambm est no retngulo consultado, o que dispensa marcar as j vistas
+static int elementosNaRegiao(const NavGrafo* g, double x1, double y1, double x2, double y2, int arestas,
+                             NavId* ids, NavId* ids2, int max) {
+    const GradeEspacial* gr = &g->grade;
+    if (x1 > x2) { double t = x1; x1 = x2; x2 = t; }
+    if (y1 > y2) { double t = y1; y1 = y2; y2 = t; }
+    int qc1 = colunaGrade(gr, x1), qc2 = colunaGrade(gr, x2);
+    int ql1 = linhaGrade(gr, y1), ql2 = linhaGrade(gr, y2);
+    int total = 0;
+    for (int l = ql1; l <= ql2; l++) {
+        for (int c = qc1; c <= qc2; c++) {
+            int celula = l * gr->colunas + c;
+            if (!arestas) {
+                for (int k = gr->inicioVertices[celula]; k < gr->inicioVertices[celula + 1]; k++) {
+                    const Vertice* p = &g->vertices[gr->verticeCelula[k]];
+                    if (p->x < x1 || p->x > x2 || p->y < y1 || p->y > y2) continue;
+                    if (total < max) ids[total] = p->id;
+                    total++;
+                }
+                continue;
+            }
+            for (int k = gr->inicioArestas[celula]; k < gr->inicioArestas[celula + 1]; k++) {
+                int a = gr->arestaCelula[2 * k], b = gr->arestaCelula[2 * k + 1], c1, l1, c2, l2;
+                celulasAresta(g, a, b, &c1, &l1, &c2, &l2);
+                if (c != (c1 > qc1 ? c1 : qc1) || l != (l1 > ql1 ? l1 : ql1)) continue;
+                if (!segmentoNoRetangulo(&g->vertices[a], &g->vertices[b], x1, y1, x2, y2)) continue;
+                if (total < max) {
+                    ids[total] = g->vertices[a].id;
+                    ids2[total] = g->vertices[b].id;
+                }
+                total++;
+            }
+        }
+    }
+    return total;
+}
+
+// ------------------------ GEOMETRIA DAS ARESTAS ------------------------ //
+// O conversor com --compactar deixa como vrtices s os cruzamentos e as pontas das vias; os ns
+// intermedirios viram a geometria das arestas, gravada no arquivo .geo ao lado do .poly:
+//   <linhas>
+//   <aresta> <k> <x1> <y1> ... <xk> <yk>     (uma linha por aresta com pontos intermedirios)
+// onde <aresta>  a posio da aresta no .poly (0 = primeira) e os pontos vo da origem para o
+// destino. O peso da aresta passa a ser o comprimento da poligonal (dividido pela velocidade, se o
+// .poly tiver); a distncia em linha reta entre as pontas continua sendo um limite inferior dele
+
+// L o .geo e aplica os comprimentos e os pontos s arestas do CSR direto recm-montado (antes do
+// reverso, que copia os pesos). origens, destinos e velocidades so os passados a construirCSR, e a
+// posio de cada aresta no CSR vem de g->dirigidaDaAresta. Retorna 1 se bem sucedido ou se o arquivo
+// no existe, 0 se ele  invlido ou faltar memria
+static int carregarGeometria(NavGrafo* g, const char* nome, const int* origens, const int* destinos,
+                             const double* velocidades, int m) {
+    FILE* f = fopen(nome, "r");
+    if (!f) return 1;
+    int linhas;
+    if (fscanf(f, "%d", &linhas) != 1 || linhas < 0) {
+        fprintf(stderr, "Erro: arquivo de geometria invlido: %s\n", nome);
+        fclose(f);
+        return 0;
+    }
+
+    // Posio no CSR de cada aresta do .poly (e da inversa, -1 nas de mo nica)
+    const int* dirigida = g->dirigidaDaAresta;
+    int* arestaLinha = malloc((linhas + 1) * sizeof(int));
+    int* inicioLinha = malloc((linhas + 2) * sizeof(int));
+    double* pontos = NULL;
+    int capacidadePontos = 0, totalPontos = 0, ok = 1;
+    g->inicioGeometria = calloc(g->totalArestasDirigidas + 1, sizeof(int));
+    if (!arestaLinha || !inicioLinha || !g->inicioGeometria) ok = 0;
+    CONTAR_BYTES(g, (2 * linhas + 3) * sizeof(int) + (g->totalArestasDirigidas + 1) * sizeof(int));
+
+    // L as linhas, guardando os pontos em sequncia; inicioGeometria conta os pontos de cada aresta
+    // dirigida (deslocado de uma posio) e marca as j vistas
+    inicioLinha[0] = 0;
+    for (int l = 0; ok && l < linhas; l++) {
+        int aresta, k;
+        if (fscanf(f, "%d %d", &aresta, &k) != 2 || aresta < 0 || aresta >= m || k < 0
+            || g->inicioGeometria[dirigida[2 * aresta] + 1] != 0 || (long long)totalPontos + k > 0x3fffffff) {
+            fprintf(stderr, "Erro: arquivo de geometria invlido: %s\n", nome);
+            ok = 0;
+            break;
+        }
+        if (totalPontos + k > capacidadePontos) {
+            capacidadePontos = 2 * (totalPontos + k);
+            double* novo = realloc(pontos, 2 * (size_t)capacidadePontos * sizeof(double));
+            if (!novo) { ok = 0; break; }
+            pontos = novo;
+        }
+        for (int j = 0; j < 2 * k; j++) {
+            if (fscanf(f, "%lf", &pontos[2 * totalPontos + j]) != 1) {
+                fprintf(stderr, "Erro: arquivo de geometria invlido: %s\n", nome);
+                ok = 0;
+                break;
+            }
+        }
+        arestaLinha[l] = aresta;
+        totalPontos += k;
+        inicioLinha[l + 1] = totalPontos;
+        g->inicioGeometria[dirigida[2 * aresta] + 1] = k;
+        if (dirigida[2 * aresta + 1] != -1) g->inicioGeometria[dirigida[2 * aresta + 1] + 1] = k;
+    }
+    fclose(f);
+
+    // Cada aresta dirigida guarda os seus pontos (as inversas, na ordem contrria); o peso vira o
+    // comprimento da poligonal
+    if (ok) {
+        for (int e = 0; e < g->totalArestasDirigidas; e++) g->inicioGeometria[e + 1] += g->inicioGeometria[e];
+        g->totalPontosGeometria = g->inicioGeometria[g->totalArestasDirigidas];
+        g->pontosGeometria = malloc(2 * ((size_t)g->totalPontosGeometria + 1) * sizeof(double));
+        ok = g->pontosGeometria != NULL;
+        CONTAR_BYTES(g, 2 * ((size_t)g->totalPontosGeometria + 1) * sizeof(double));
+    }
+    for (int l = 0; ok && l < linhas; l++) {
+        int aresta = arestaLinha[l], k = inicioLinha[l + 1] - inicioLinha[l];
+        const double* p = pontos + 2 * inicioLinha[l];
+        const Vertice* a = &g->vertices[origens[aresta]];
+        const Vertice* b = &g->vertices[destinos[aresta]];
+        double comprimento = 0, x = a->x, y = a->y;
+        for (int j = 0; j < k; j++) {
+            comprimento += hypot(p[2 * j] - x, p[2 * j + 1] - y);
+            x = p[2 * j];
+            y = p[2 * j + 1];
+        }
+        comprimento += hypot(b->x - x, b->y - y);
+        if (velocidades) comprimento /= velocidades[aresta];
+
+        int e = dirigida[2 * aresta];
+        if (k > 0) memcpy(g->pontosGeometria + 2 * g->inicioGeometria[e], p, 2 * (size_t)k * sizeof(double));
+        g->pesoAresta[e] = comprimento;
+        if ((e = dirigida[2 * aresta + 1]) != -1) {
+            double* destino = g->pontosGeometria + 2 * g->inicioGeometria[e];
+            for (int j = 0; j < k; j++) {
+                destino[2 * j] = p[2 * (k - 1 - j)];
+                destino[2 * j + 1] = p[2 * (k - 1 - j) + 1];
+            }
+            g->pesoAresta[e] = comprimento;
+        }
+    }
+    free(arestaLinha); free(inicioLinha); free(pontos);
+    return ok;
+}
+
+// Posio no CSR da aresta u -> v de menor peso, a escolhida pelas buscas, ou -1 se u e v no so vizinhos
+static int menorAresta(const NavGrafo* g, int u, int v) {
+    int melhor = -1;
+    for (int e = g->inicioAresta[u]; e < g->inicioAresta[u + 1]; e++)
+        if (g->destinoAresta[e] == v && (melhor == -1 || g->pesoAresta[e] < g->pesoAresta[melhor])) melhor = e;
+    return melhor;
+}
+
+// Acrescenta a saida[] (at max pontos) os pontos intermedirios da aresta u -> v de menor peso, a
+// escolhida pelas buscas. Retorna quantos pontos a aresta tem, ou -1 se u e v no so vizinhos
+static int pontosDaAresta(const NavGrafo* g, int u, int v, double* x, double* y, int inicio, int max) {
+    int melhor = menorAresta(g, u, v);
+    if (melhor == -1) return -1;
+    if (!g->inicioGeometria) return 0;
+    int k = g->inicioGeometria[melhor + 1] - g->inicioGeometria[melhor];
+    for (int j = 0; j < k && inicio + j < max; j++) {
+        x[inicio + j] = g->pontosGeometria[2 * (g->inicioGeometria[melhor] + j)];
+        y[inicio + j] = g->pontosGeometria[2 * (g->inicioGeometria[melhor] + j) + 1];
+    }
+    return k;
+}
+
+// ------------------------ LEITURA DO ARQUIVO .POLY ------------------------ //
+// L o arquivo .poly com formato esperado e popula o grafo com vrtices e arestas
+// e renumera os vrtices na ordem pedida. Retorna 1 se leitura bem sucedida, 0 se erro
+static int lerArquivoPoly(NavGrafo* g, const char* nome, int ordem) {
+    FILE* f = fopen(nome, "r");
+    if (!f) return 0;
+    double ini = relogio();
+
+    // L o cabealho do arquivo .poly (nmero de vrtices e alguns parmetros no usados)
+    // Os vetores do grafo so dimensionados pelo cabealho, sem limite fixo de vrtices
+    int lixo1, lixo2, lixo3;
+    if (fscanf(f, "%d %d %d %d", &g->totalVertices, &lixo1, &lixo2, &lixo3) != 4 || g->totalVertices < 0) {
+        fclose(f);
+        return 0;
+    }
+
+    g->vertices = malloc((g->totalVertices + 1) * sizeof(Vertice));
+    if (!g->vertices || !alocarTabelaIds(&g->idParaIndice, g->totalVertices)) {
+        fprintf(stderr, "Erro: memria insuficiente para %d vrtices\n", g->totalVertices);
+        fclose(f);
+        return 0;
+    }
+    CONTAR_BYTES(g, (g->totalVertices + 1) * sizeof(Vertice) + (g->idParaIndice.mascara + 1) * (sizeof(NavId) + sizeof(int)));
+
+    // L os vrtices: id, coordenadas x e y
+    for (int i = 0; i < g->totalVertices; i++) {
+        long long id;
+        double x, y;
+        if (fscanf(f, "%lld %lf %lf", &id, &x, &y) != 3) {
+            fclose(f);
+            return 0;
+        }
+        g->vertices[i].id = id;
+        g->vertices[i].x = x;
+        g->vertices[i].y = y;
+
+        // Mapeia ID para ndice interno; um ID repetido tornaria as arestas ambguas
+        if (!inserirId(&g->idParaIndice, id, i)) {
+            fprintf(stderr, "Erro: ID de vrtice duplicado: %lld\n", id);
+            fclose(f);
+            return 0;
+        }
+    }
+
+    // L nmero de arestas (e outro parmetro no usado)
+    if (fscanf(f, "%d %d", &g->totalArestas, &lixo1) != 2 || g->totalArestas < 0) {
+        fclose(f);
+        return 0;
+    }
+
+    // Vetores temporrios com as arestas lidas, convertidos para CSR ao final da leitura
+    int* origens = malloc((g->totalArestas + 1) * sizeof(int));
+    int* destinos = malloc((g->totalArestas + 1) * sizeof(int));
+    int* direcoes = malloc((g->totalArestas + 1) * sizeof(int));
+    NavId* ids = malloc((g->totalArestas + 1) * sizeof(NavId));
+    double* velocidades = NULL;   // S alocado se alguma aresta tiver a quinta coluna
+    if (!origens || !destinos || !direcoes || !ids) {
+        free(origens); free(destinos); free(direcoes); free(ids);
+        fclose(f);
+        return 0;
+    }
+    CONTAR_BYTES(g, 3 * (g->totalArestas + 1) * sizeof(int) + (g->totalArestas + 1) * sizeof(NavId));
+
+    // L as arestas: id da aresta (usado por navAtualizarPesos), origem, destino, direo (0 = bidirecional,
+    // 1 = direcionado) e, opcionalmente, a velocidade da via (conversor com --velocidades): o peso vira
+    // comprimento / velocidade. As arestas sem a quinta coluna tm velocidade 1
+    for (int i = 0; i < g->totalArestas; i++) {
+        long long id, o, d;
+        int dir, c;
+        if (fscanf(f, "%lld %lld %lld %d", &id, &o, &d, &dir) != 4) {
+            free(origens); free(destinos); free(direcoes); free(ids); free(velocidades);
+            fclose(f);
+            return 0;
+        }
+        while ((c = fgetc(f)) == ' ' || c == '\t') {}
+        if (c != '\n' && c != '\r' && c != EOF) {
+            ungetc(c, f);
+            if (!velocidades) {
+                velocidades = malloc((g->totalArestas + 1) * sizeof(double));
+                if (!velocidades) {
+                    free(origens); free(destinos); free(direcoes); free(ids);
+                    fclose(f);
+                    return 0;
+                }
+                CONTAR_BYTES(g, (g->totalArestas + 1) * sizeof(double));
+                for (int k = 0; k < i; k++) velocidades[k] = 1;
+            }
+            if (fscanf(f, "%lf", &velocidades[i]) != 1 || !(velocidades[i] > 0)) {
+                fprintf(stderr, "Erro: velocidade invlida na aresta %lld\n", id);
+                free(origens); free(destinos); free(direcoes); free(ids); free(velocidades);
+                fclose(f);
+                return 0;
+            }
+        } else if (velocidades) {
+            velocidades[i] = 1;
+        }
+
+        // Converte os IDs de vrtices para ndices internos do vetor grafo
+        int o_idx = buscarId(&g->idParaIndice, o);
+        int d_idx = buscarId(&g->idParaIndice, d);
+
+        // Verifica se os vrtices de origem e destino existem no grafo
+        if (o_idx == -1 || d_idx == -1) {
+            fprintf(stderr, "Erro: aresta com vrtice inexistente (origem %lld, destino %lld)\n", o, d);
+            free(origens); free(destinos); free(direcoes); free(ids); free(velocidades);
+            fclose(f);
+            return 0;
+        }
+        ids[i] = id;
+        origens[i] = o_idx;
+        destinos[i] = d_idx;
+        direcoes[i] = dir;
+    }
+    fclose(f);
+    double meio = relogio();
+
+    // Pontos intermedirios e comprimentos das arestas compactadas, do .geo ao lado do .poly (se existir)
+    char nomeGeometria[4096];
+    navNomeArquivoAuxiliar(nome, ".geo", nomeGeometria, sizeof(nomeGeometria));
+    int ok = reordenarVertices(g, ordem, origens, destinos, g->totalArestas)
+          && construirCSR(g, origens, destinos, direcoes, velocidades, g->totalArestas)
+          && carregarGeometria(g, nomeGeometria, origens, destinos, velocidades, g->totalArestas)
+          && construirCSRReverso(g) && registrarArestas(g, ids) && calcularComponentes(g) && construirGrade(g);
+    free(origens); free(destinos); free(direcoes); free(ids); free(velocidades);
+    if (ok) calcularFatorHeuristica(g);
+
+    g->tempoLeitura = meio - ini;
+    g->tempoConstrucaoCSR = relogio() - meio;
+    return ok;  // Sucesso na leitura do arquivo
+}
+
+// ------------------------ FORMATO BINRIO (.navg) ------------------------ //
+// O arquivo guarda exatamente os vetores do NavGrafo: um cabealho seguido das sees abaixo,
+// cada uma comeando em deslocamento mltiplo de 8. Abrir o grafo  s mapear o arquivo e apontar
+// os vetores para as sees (O(1), sem ler nem converter nada), e processos que abrem o mesmo
+// arquivo compartilham as pginas. O formato depende da ordem dos bytes e do tamanho dos tipos da
+// mquina que gravou, ento  um cache local gerado a partir do .poly, que continua sendo a entrada
+#define ASSINATURA_BINARIO "NAVGRF1"
+#define VERSAO_BINARIO 7           // 2: componentes conexas; 3: ndice espacial; 4: geometria; 5: fator da heurstica;
+                                   // 6: ordem dos vrtices; 7: IDs e posies das arestas (pesos dinmicos)
+#define MARCA_ORDEM_BYTES 0x01020304
+
+enum {
+    SECAO_VERTICES,            // Vertice[totalVertices]
+    SECAO_INICIO,              // int[totalVertices + 1]
+    SECAO_DESTINO,             // int[totalArestasDirigidas]
+    SECAO_PESO,                // double[totalArestasDirigidas]
+    SECAO_INICIO_REVERSA,      // int[totalVertices + 1]
+    SECAO_ORIGEM_REVERSA,      // int[totalArestasDirigidas]
+    SECAO_PESO_REVERSA,        // double[totalArestasDirigidas]
+    SECAO_CHAVES_IDS,          // NavId[mascaraIds + 1]
+    SECAO_INDICES_IDS,         // int[mascaraIds + 1]
+    SECAO_COMPONENTE_FORTE,    // int[totalVertices]
+    SECAO_COMPONENTE_FRACA,    // int[totalVertices]
+    SECAO_GRADE_INICIO_VERTICES, // int[colunasGrade * linhasGrade + 1]
+    SECAO_GRADE_VERTICES,      // int[totalVertices]
+    SECAO_GRADE_INICIO_ARESTAS, // int[colunasGrade * linhasGrade + 1]
+    SECAO_GRADE_ARESTAS,       // int[2 * entradasGrade]
+    SECAO_INICIO_GEOMETRIA,    // int[totalArestasDirigidas + 1], vazia se pontosGeometria == -1
+    SECAO_PONTOS_GEOMETRIA,    // double[2 * pontosGeometria]
+    SECAO_INDICE_DO_ARQUIVO,   // int[totalVertices], vazia se ordemVertices == ORDEM_ARQUIVO
+    SECAO_CHAVES_ARESTAS,      // NavId[mascaraArestas + 1]
+    SECAO_INDICES_ARESTAS,     // int[mascaraArestas + 1]
+    SECAO_DIRIGIDA_DA_ARESTA,  // int[2 * totalArestas]
+    SECAO_REVERSA_DA_DIRIGIDA, // int[totalArestasDirigidas]
+    SECAO_PESO_ORIGINAL,       // double[totalArestas]
+    TOTAL_SECOES
+};
+
+typedef struct {
+    char assinatura[8];
+    int versao;
+    int ordemBytes;            // MARCA_ORDEM_BYTES como gravada pela mquina de origem
+    int totalVertices;
+    int totalArestas;
+    int totalArestasDirigidas;
+    int totalComponentesFortes;
+    int totalComponentesFracas;
+    int colunasGrade;
+    int linhasGrade;
+    int entradasGrade;         // Pares (origem, destino) da grade de arestas
+    int pontosGeometria;       // Pontos intermedirios das arestas (-1 se o grafo no tem geometria)
+    int ordemVertices;         // OrdemVertices usada na converso
+    unsigned long long mascaraIds;
+    unsigned long long mascaraArestas;   // Tabela dos IDs das arestas
+    double minXGrade, minYGrade, ladoGrade;
+    double fatorHeuristica;
+    long long inicioSecao[TOTAL_SECOES];   // Deslocamento de cada seo a partir do incio do arquivo
+    long long tamanhoSecao[TOTAL_SECOES];  // Tamanho de cada seo em bytes
+} CabecalhoBinario;
+
+// Tamanho esperado de cada seo para um grafo com n vrtices, a arestas no .poly, m arestas dirigidas,
+// as tabelas de IDs dos vrtices e das arestas, a grade espacial (clulas e pares de arestas), os pontos
+// da geometria (-1 sem geometria) e a ordem dos vrtices dados
+static void tamanhosSecoes(long long n, long long a, long long m, unsigned long long mascaraIds,
+                           unsigned long long mascaraArestas, long long celulas, long long entradas,
+                           long long pontos, int ordem, long long* tam) {
+    long long capacidadeIds = (long long)mascaraIds + 1;
+    long long capacidadeArestas = (long long)mascaraArestas + 1;
+    tam[SECAO_VERTICES] = n * (long long)sizeof(Vertice);
+    tam[SECAO_INICIO] = tam[SECAO_INICIO_REVERSA] = (n + 1) * (long long)sizeof(int);
+    tam[SECAO_DESTINO] = tam[SECAO_ORIGEM_REVERSA] = m * (long long)sizeof(int);
+    tam[SECAO_PESO] = tam[SECAO_PESO_REVERSA] = m * (long long)sizeof(double);
+    tam[SECAO_CHAVES_IDS] = capacidadeIds * (long long)sizeof(NavId);
+    tam[SECAO_INDICES_IDS] = capacidadeIds * (long long)sizeof(int);
+    tam[SECAO_COMPONENTE_FORTE] = tam[SECAO_COMPONENTE_FRACA] = n * (long long)sizeof(int);
+    tam[SECAO_GRADE_INICIO_VERTICES] = tam[SECAO_GRADE_INICIO_ARESTAS] = (celulas + 1) * (long long)sizeof(int);
+    tam[SECAO_GRADE_VERTICES] = n * (long long)sizeof(int);
+    tam[SECAO_GRADE_ARESTAS] = 2 * entradas * (long long)sizeof(int);
+    tam[SECAO_INICIO_GEOMETRIA] = pontos >= 0 ? (m + 1) * (long long)sizeof(int) : 0;
+    tam[SECAO_PONTOS_GEOMETRIA] = pontos > 0 ? 2 * pontos * (long long)sizeof(double) : 0;
+    tam[SECAO_INDICE_DO_ARQUIVO] = ordem != ORDEM_ARQUIVO ? n * (long long)sizeof(int) : 0;
+    tam[SECAO_CHAVES_ARESTAS] = capacidadeArestas * (long long)sizeof(NavId);
+    tam[SECAO_INDICES_ARESTAS] = capacidadeArestas * (long long)sizeof(int);
+    tam[SECAO_DIRIGIDA_DA_ARESTA] = 2 * a * (long long)sizeof(int);
+    tam[SECAO_REVERSA_DA_DIRIGIDA] = m * (long long)sizeof(int);
+    tam[SECAO_PESO_ORIGINAL] = a * (long long)sizeof(double);
+}
+
+// Grava o grafo carregado no formato binrio. Retorna 1 se bem sucedido
+static int salvarBinario(const NavGrafo* g, const char* nome) {
+    const void* dados[TOTAL_SECOES] = {
+        g->vertices, g->inicioAresta, g->destinoAresta, g->pesoAresta,
+        g->inicioArestaReversa, g->origemArestaReversa, g->pesoArestaReversa,
+        g->idParaIndice.chaves, g->idParaIndice.indices, g->componenteForte, g->componenteFraca,
+        g->grade.inicioVertices, g->grade.verticeCelula, g->grade.inicioArestas, g->grade.arestaCelula,
+        g->inicioGeometria, g->pontosGeometria, g->indiceDoArquivo,
+        g->idArestaParaIndice.chaves, g->idArestaParaIndice.indices, g->dirigidaDaAresta, g->reversaDaDirigida,
+        g->pesoOriginal
+    };
+    CabecalhoBinario c;
+    memset(&c, 0, sizeof(c));
+    memcpy(c.assinatura, ASSINATURA_BINARIO, 8);
+    c.versao = VERSAO_BINARIO;
+    c.ordemBytes = MARCA_ORDEM_BYTES;
+    c.totalVertices = g->totalVertices;
+    c.totalArestas = g->totalArestas;
+    c.totalArestasDirigidas = g->totalArestasDirigidas;
+    c.totalComponentesFortes = g->totalComponentesFortes;
+    c.totalComponentesFracas = g->totalComponentesFracas;
+    c.mascaraIds = g->idParaIndice.mascara;
+    c.mascaraArestas = g->idArestaParaIndice.mascara;
+    c.colunasGrade = g->grade.colunas;
+    c.linhasGrade = g->grade.linhas;
+    c.entradasGrade = g->grade.totalEntradasArestas;
+    c.minXGrade = g->grade.minX;
+    c.minYGrade = g->grade.minY;
+    c.ladoGrade = g->grade.lado;
+    c.pontosGeometria = g->inicioGeometria ? g->totalPontosGeometria : -1;
+    c.fatorHeuristica = g->fatorHeuristica;
+    c.ordemVertices = g->indiceDoArquivo ? g->ordemVertices : ORDEM_ARQUIVO;
+    tamanhosSecoes(g->totalVertices, g->totalArestas, g->totalArestasDirigidas, c.mascaraIds, c.mascaraArestas,
+                   (long long)c.colunasGrade * c.linhasGrade, c.entradasGrade, c.pontosGeometria, c.ordemVertices,
+                   c.tamanhoSecao);
+    long long pos = sizeof(CabecalhoBinario);
+    for (int s = 0; s < TOTAL_SECOES; s++) {
+        c.inicioSecao[s] = pos;
+        pos += (c.tamanhoSecao[s] + 7) & ~7LL;
+    }
+
+    FILE* f = fopen(nome, "wb");
+    if (!f) return 0;
+    static const char zeros[8] = {0};
+    int ok = fwrite(&c, sizeof(c), 1, f) == 1;
+    for (int s = 0; ok && s < TOTAL_SECOES; s++) {
+        long long preenchimento = ((c.tamanhoSecao[s] + 7) & ~7LL) - c.tamanhoSecao[s];
+        ok = fwrite(dados[s], 1, c.tamanhoSecao[s], f) == (size_t)c.tamanhoSecao[s]
+          && fwrite(zeros, 1, preenchimento, f) == (size_t)preenchimento;
+    }
+    if (fclose(f) != 0) ok = 0;
+    return ok;
+}
+
+// Mapeia o arquivo inteiro em memria, somente leitura. Retorna NULL se falhar
+static void* mapearArquivo(const char* nome, size_t* tamanho) {
+#ifdef _WIN32
+    HANDLE arquivo = CreateFileA(nome, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                 FILE_ATTRIBUTE_NORMAL, NULL);
+    if (arquivo == INVALID_HANDLE_VALUE) return NULL;
+    LARGE_INTEGER tam;
+    HANDLE mapa = NULL;
+    void* base = NULL;
+    if (GetFileSizeEx(arquivo, &tam) && tam.QuadPart > 0)
+        mapa = CreateFileMappingA(arquivo, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapa) base = MapViewOfFile(mapa, FILE_MAP_READ, 0, 0, 0);
+    // A viso mapeada mantm o arquivo aberto; os handles no so mais necessrios
+    if (mapa) CloseHandle(mapa);
+    CloseHandle(arquivo);
+    *tamanho = base ? (size_t)tam.QuadPart : 0;
+    return base;
+#else
+    int fd = open(nome, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    void* base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+        base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return NULL;
+    *tamanho = (size_t)st.st_size;
+    return base;
+#endif
+}
+
+static void desmapearArquivo(void* base, size_t tamanho) {
+    if (!base) return;
+#ifdef _WIN32
+    (void)tamanho;
+    UnmapViewOfFile(base);
+#else
+    munmap(base, tamanho);
+#endif
+}
+
+// Retorna 1 se o arquivo comea com a assinatura do formato binrio
+static int ehArquivoBinario(const char* nome) {
+    char assinatura[8];
+    FILE* f = fopen(nome, "rb");
+    if (!f) return 0;
+    int ok = fread(assinatura, 1, 8, f) == 8 && memcmp(assinatura, ASSINATURA_BINARIO, 8) == 0;
+    fclose(f);
+    return ok;
+}
+
+// Abre um arquivo .navg: valida o cabealho e os limites das sees e aponta os vetores do grafo
+// para dentro do mapeamento. Retorna 1 se bem sucedido, 0 se erro
+static int abrirArquivoBinario(NavGrafo* g, const char* nome) {
+    double ini = relogio();
+    size_t tamanho;
+    char* base = mapearArquivo(nome, &tamanho);
+    if (!base) return 0;
+    g->mapeamento = base;
+    g->tamanhoMapeamento = tamanho;
+
+    const CabecalhoBinario* c = (const CabecalhoBinario*)base;
+    if (tamanho < sizeof(CabecalhoBinario) || memcmp(c->assinatura, ASSINATURA_BINARIO, 8) != 0) return 0;
+    if (c->versao != VERSAO_BINARIO || c->ordemBytes != MARCA_ORDEM_BYTES) {
+        fprintf(stderr, "Erro: %s foi gravado em outra verso do formato ou em outra arquitetura; "
+                        "converta o .poly novamente\n", nome);
+        return 0;
+    }
+    if (c->totalVertices < 0 || c->totalArestas < 0 || c->totalArestasDirigidas < 0
+        || ((c->mascaraIds + 1) & c->mascaraIds) != 0 || c->mascaraIds + 1 < 2ULL * (unsigned long long)c->totalVertices
+        || ((c->mascaraArestas + 1) & c->mascaraArestas) != 0
+        || c->mascaraArestas + 1 < 2ULL * (unsigned long long)c->totalArestas) return 0;
+    if (c->colunasGrade <= 0 || c->linhasGrade <= 0 || c->entradasGrade < 0 || !(c->ladoGrade > 0) || c->pontosGeometria < -1
+        || !(c->fatorHeuristica >= 0 && c->fatorHeuristica <= 1)
+        || c->ordemVertices < 0 || c->ordemVertices >= TOTAL_ORDENS_VERTICES
+        || (long long)c->colunasGrade * c->linhasGrade > 4LL * c->totalVertices + 16) {
+        fprintf(stderr, "Erro: arquivo binrio corrompido: %s\n", nome);
+        return 0;
+    }
+
+    long long celulas = (long long)c->colunasGrade * c->linhasGrade;
+    long long esperado[TOTAL_SECOES];
+    tamanhosSecoes(c->totalVertices, c->totalArestas, c->totalArestasDirigidas, c->mascaraIds, c->mascaraArestas,
+                   celulas, c->entradasGrade, c->pontosGeometria, c->ordemVertices, esperado);
+    for (int s = 0; s < TOTAL_SECOES; s++) {
+        if (c->tamanhoSecao[s] != esperado[s] || c->inicioSecao[s] < (long long)sizeof(CabecalhoBinario)
+            || c->inicioSecao[s] % 8 != 0 || c->inicioSecao[s] + esperado[s] > (long long)tamanho) {
+            fprintf(stderr, "Erro: arquivo binrio corrompido: %s\n", nome);
+            return 0;
+        }
+    }
+
+    g->totalVertices = c->totalVertices;
+    g->totalArestas = c->totalArestas;
+    g->totalArestasDirigidas = c->totalArestasDirigidas;
+    g->vertices = (Vertice*)(base + c->inicioSecao[SECAO_VERTICES]);
+    g->inicioAresta = (int*)(base + c->inicioSecao[SECAO_INICIO]);
+    g->destinoAresta = (int*)(base + c->inicioSecao[SECAO_DESTINO]);
+    g->pesoAresta = (double*)(base + c->inicioSecao[SECAO_PESO]);
+    g->inicioArestaReversa = (int*)(base + c->inicioSecao[SECAO_INICIO_REVERSA]);
+    g->origemArestaReversa = (int*)(base + c->inicioSecao[SECAO_ORIGEM_REVERSA]);
+    g->pesoArestaReversa = (double*)(base + c->inicioSecao[SECAO_PESO_REVERSA]);
+    g->idParaIndice.chaves = (NavId*)(base + c->inicioSecao[SECAO_CHAVES_IDS]);
+    g->idParaIndice.indices = (int*)(base + c->inicioSecao[SECAO_INDICES_IDS]);
+    g->idParaIndice.mascara = c->mascaraIds;
+    g->componenteForte = (int*)(base + c->inicioSecao[SECAO_COMPONENTE_FORTE]);
+    g->componenteFraca = (int*)(base + c->inicioSecao[SECAO_COMPONENTE_FRACA]);
+    g->totalComponentesFortes = c->totalComponentesFortes;
+    g->totalComponentesFracas = c->totalComponentesFracas;
+    g->fatorHeuristica = c->fatorHeuristica;
+    g->grade.colunas = c->colunasGrade;
+    g->grade.linhas = c->linhasGrade;
+    g->grade.minX = c->minXGrade;
+    g->grade.minY = c->minYGrade;
+    g->grade.lado = c->ladoGrade;
+    g->grade.totalEntradasArestas = c->entradasGrade;
+    g->grade.inicioVertices = (int*)(base + c->inicioSecao[SECAO_GRADE_INICIO_VERTICES]);
+    g->grade.verticeCelula = (int*)(base + c->inicioSecao[SECAO_GRADE_VERTICES]);
+    g->grade.inicioArestas = (int*)(base + c->inicioSecao[SECAO_GRADE_INICIO_ARESTAS]);
+    g->grade.arestaCelula = (int*)(base + c->inicioSecao[SECAO_GRADE_ARESTAS]);
+    if (c->pontosGeometria >= 0) {
+        g->inicioGeometria = (int*)(base + c->inicioSecao[SECAO_INICIO_GEOMETRIA]);
+        g->pontosGeometria = (double*)(base + c->inicioSecao[SECAO_PONTOS_GEOMETRIA]);
+        g->totalPontosGeometria = c->pontosGeometria;
+    }
+    g->ordemVertices = c->ordemVertices;
+    if (c->ordemVertices != ORDEM_ARQUIVO) g->indiceDoArquivo = (int*)(base + c->inicioSecao[SECAO_INDICE_DO_ARQUIVO]);
+    g->idArestaParaIndice.chaves = (NavId*)(base + c->inicioSecao[SECAO_CHAVES_ARESTAS]);
+    g->idArestaParaIndice.indices = (int*)(base + c->inicioSecao[SECAO_INDICES_ARESTAS]);
+    g->idArestaParaIndice.mascara = c->mascaraArestas;
+    g->dirigidaDaAresta = (int*)(base + c->inicioSecao[SECAO_DIRIGIDA_DA_ARESTA]);
+    g->reversaDaDirigida = (int*)(base + c->inicioSecao[SECAO_REVERSA_DA_DIRIGIDA]);
+    g->pesoOriginal = (double*)(base + c->inicioSecao[SECAO_PESO_ORIGINAL]);
+
+    // Conferncia barata da consistncia do CSR e da grade (os vetores inteiros no so percorridos)
+    if (g->inicioAresta[g->totalVertices] != g->totalArestasDirigidas
+        || g->inicioArestaReversa[g->totalVertices] != g->totalArestasDirigidas
+        || g->grade.inicioVertices[celulas] != g->totalVertices
+        || g->grade.inicioArestas[celulas] != g->grade.totalEntradasArestas
+        || (g->inicioGeometria && g->inicioGeometria[g->totalArestasDirigidas] != g->totalPontosGeometria)) {
+        fprintf(stderr, "Erro: arquivo binrio corrompido: %s\n", nome);
+        return 0;
+    }
+    g->tempoLeitura = relogio() - ini;
+    g->tempoConstrucaoCSR = 0;
+    return 1;
+}
+
+// ------------------------ ALGORITMO DE DIJKSTRA ------------------------ //
+// Implementa o algoritmo para encontrar o caminho mnimo entre vrtices
+// origem e destino so ndices internos dos vrtices no grafo
+// pararNoDestino encerra a busca quando o destino  extrado da heap (sua distncia j  definitiva);
+// com 0, o componente inteiro alcanvel pela origem  explorado
+// nosExplorados armazena a quantidade de ns visitados
+// custoFinal recebe o custo total do caminho encontrado
+// eb  o espao de busca usado; ao final, eb->anterior guarda o predecessor de cada vrtice
+// para reconstruo do caminho e eb->dist as distncias a partir da origem
+// Lao principal do Dijkstra sobre os vetores dados: os do espao de busca ou os de uma rvore do
+// cache, quando a busca  retomada. Fecha os vrtices da fila eb->heap at esvazi-la ou, com
+// pararNoDestino, at fechar o destino (que fica sem ter as arestas relaxadas)
+// Soma os vrtices fechados a *nosExplorados e retorna 1 se a fila esvaziou
+static int fecharVertices(const NavGrafo* g, EspacoBusca* eb, double* dist, int* visitado, int* anterior,
+                          int destino, int pararNoDestino, int* nosExplorados) {
+    while (eb->heap.tam > 0) {
+        int u = extrairMinFila(&eb->heap);    // Remove vrtice com menor distncia acumulada
+        if (visitado[u]) {  // Se j visitado, ignora
+            METRICA(eb->metricas.extracoesObsoletas++);
+            continue;
+        }
+        visitado[u] = 1;
+        (*nosExplorados)++;  // Incrementa contador de ns explorados
+        if (pararNoDestino && u == destino) return 0;
+        METRICA(eb->metricas.arestasRelaxadas += g->inicioAresta[u + 1] - g->inicioAresta[u]);
+
+        // Relaxa todas as arestas adjacentes a u, percorrendo o trecho contguo do CSR
+        for (int e = g->inicioAresta[u]; e < g->inicioAresta[u + 1]; e++) {
+            int v = g->destinoAresta[e];
+            // Se no visitado e novo caminho menor, atualiza distncia e predecessor
+            if (!visitado[v] && dist[u] + g->pesoAresta[e] < dist[v]) {
+                dist[v] = dist[u] + g->pesoAresta[e];
+                anterior[v] = u;
+                inserirFila(&eb->heap, v, dist[v]);  // Insere ou atualiza heap com nova distncia
+            }
+        }
+    }
+    return 1;
+}
+
+static void dijkstra(const NavGrafo* g, EspacoBusca* eb, int origem, int destino, int pararNoDestino, int* nosExplorados, double* custoFinal) {
+    double* dist = eb->dist;          // Distncias mnimas acumuladas da origem
+    int* visitado = eb->visitado;     // Marca se o vrtice j foi visitado
+    int* anterior = eb->anterior;
+    *nosExplorados = 0;               // Inicializa contador de ns explorados
+
+    // Inicializa distncias com infinito e predecessores invlidos (-1)
+    for (int i = 0; i < g->totalVertices; i++) {
+        dist[i] = NAV_INF;
+        visitado[i] = 0;
+        anterior[i] = -1;
+    }
+    dist[origem] = 0;  // Distncia do vrtice origem para ele mesmo  zero
+
+    esvaziarFila(&eb->heap);                     // Inicializa heap vazia
+    inserirFila(&eb->heap, origem, 0);    // Insere vrtice origem na heap
+    fecharVertices(g, eb, dist, visitado, anterior, destino, pararNoDestino, nosExplorados);
+
+    *custoFinal = dist[destino];  // Define o custo final encontrado para o destino
+}
+
+// Dijkstra de um vrtice para todos, sem caminho: preenche dist[] com a distncia a partir de
+// 'origem' no grafo direto, ou at 'origem' quando reverso == 1 (percorrendo o CSR reverso)
+static void dijkstraCompleto(const NavGrafo* g, EspacoBusca* eb, int origem, int reverso, double* dist) {
+    int* inicio = reverso ? g->inicioArestaReversa : g->inicioAresta;
+    int* vizinho = reverso ? g->origemArestaReversa : g->destinoAresta;
+    double* peso = reverso ? g->pesoArestaReversa : g->pesoAresta;
+
+    for (int i = 0; i < g->totalVertices; i++) dist[i] = NAV_INF;
+    dist[origem] = 0;
+    esvaziarFila(&eb->heap);
+    inserirFila(&eb->heap, origem, 0);
+
+    while (eb->heap.tam > 0) {
+        double d = menorChaveFila(&eb->heap);
+        int u = extrairMinFila(&eb->heap);
+        if (d > dist[u]) continue;  // Entrada antiga na heap
+        for (int e = inicio[u]; e < inicio[u + 1]; e++) {
+            int v = vizinho[e];
+            if (d + peso[e] < dist[v]) {
+                dist[v] = d + peso[e];
+                inserirFila(&eb->heap, v, dist[v]);
+            }
+        }
+    }
+}
+
+// Dijkstra de uma origem para vrios destinos: para assim que todos os destinos alcanveis forem
+// fechados. custos[j] recebe a distncia at alvos[j] (INF se no houver caminho); destinos
+// repetidos so permitidos. Ao final, eb->anterior permite reconstruir o caminho at cada destino
+// Retorna a quantidade de ns explorados
+static int dijkstraUmParaMuitos(const NavGrafo* g, EspacoBusca* eb, int origem, const int* alvos, int totalAlvos, double* custos) {
+    double* dist = eb->dist;
+    int* visitado = eb->visitado;
+    int* anterior = eb->anterior;
+    int nosExplorados = 0;
+
+    for (int i = 0; i < g->totalVertices; i++) {
+        dist[i] = NAV_INF;
+        visitado[i] = 0;
+        anterior[i] = -1;
+    }
+    int pendentes = 0;   // Destinos distintos ainda no fechados
+    for (int j = 0; j < totalAlvos; j++) {
+        // Destinos que as componentes garantem inalcanveis no seguram a busca
+        if (eb->alvo[alvos[j]] || !caminhoPossivel(g, origem, alvos[j])) continue;
+        eb->alvo[alvos[j]] = 1;
+        pendentes++;
+    }
+    dist[origem] = 0;
+
+    esvaziarFila(&eb->heap);
+    inserirFila(&eb->heap, origem, 0);
+
+    while (eb->heap.tam > 0 && pendentes > 0) {
+        int u = extrairMinFila(&eb->heap);
+        if (visitado[u]) continue;
+        visitado[u] = 1;
+        nosExplorados++;
+        if (eb->alvo[u]) {
+            eb->alvo[u] = 0;
+            pendentes--;
+        }
+
+        for (int e = g->inicioAresta[u]; e < g->inicioAresta[u + 1]; e++) {
+            int v = g->destinoAresta[e];
+            if (!visitado[v] && dist[u] + g->pesoAresta[e] < dist[v]) {
+                dist[v] = dist[u] + g->pesoAresta[e];
+                anterior[v] = u;
+                inserirFila(&eb->heap, v, dist[v]);
+            }
+        }
+    }
+
+    // Copia as distncias e desfaz as marcas dos destinos que no foram alcanados
+    for (int j = 0; j < totalAlvos; j++) {
+        custos[j] = dist[alvos[j]];
+        eb->alvo[alvos[j]] = 0;
+    }
+    return nosExplorados;
+}
+
+// Dijkstra limitado por custo: fecha, em ordem crescente de distncia, os vrtices a no mximo
+// 'limite' da origem. Relaxaes que passariam do limite nem entram na fila, ento a busca termina
+// assim que nada dentro do limite resta. A ordem de fechamento fica em eb->caminho (a origem
+// primeiro) e eb->dist/eb->anterior guardam a rvore. Retorna a quantidade de vrtices fechados
+static int dijkstraLimitado(const NavGrafo* g, EspacoBusca* eb, int origem, double limite) {
+    double* dist = eb->dist;
+    int* visitado = eb->visitado;
+    int* anterior = eb->anterior;
+    int fechados = 0;
+
+    for (int i = 0; i < g->totalVertices; i++) {
+        dist[i] = NAV_INF;
+        visitado[i] = 0;
+        anterior[i] = -1;
+    }
+    dist[origem] = 0;
+    esvaziarFila(&eb->heap);
+    inserirFila(&eb->heap, origem, 0);
+
+    while (eb->heap.tam > 0) {
+        int u = extrairMinFila(&eb->heap);
+        if (visitado[u]) continue;
+        visitado[u] = 1;
+        eb->caminho[fechados++] = u;
+
+        for (int e = g->inicioAresta[u]; e < g->inicioAresta[u + 1]; e++) {
+            int v = g->destinoAresta[e];
+            double d = dist[u] + g->pesoAresta[e];
+            if (!visitado[v] && d <= limite && d < dist[v]) {
+                dist[v] = d;
+                anterior[v] = u;
+                inserirFila(&eb->heap, v, d);
+            }
+        }
+    }
+    return fechados;
+}
+
+// ------------------------ CACHE DE RVORES POR ORIGEM ------------------------ //
+// Na prtica poucas origens (depsitos) se repetem muito. Cada espao de busca pode guardar o estado
+// do Dijkstra (dist, anterior e vrtices fechados) das origens usadas por ltimo: uma consulta
+// repetida s reconstri o caminho, e uma busca que parou antes de fechar o destino pedido 
+// retomada de onde parou, com a fronteira devolvida  fila. O cache  por espao de busca, ento
+// threads diferentes no disputam as mesmas rvores
+
+// rvore da origem no cache, movida para o incio da lista LRU. Se no h (ou foi calculada com
+// outra verso do grafo), cria uma nova, descartando as menos recentes at caber no limite; *nova
+// indica se foi criada. Retorna NULL se uma rvore no cabe no limite ou falta memria
+static ArvoreCache* arvoreDoCache(const NavGrafo* g, EspacoBusca* eb, int origem, int* nova) {
+    CacheArvores* c = &eb->cache;
+    int n = g->totalVertices;
+    ArvoreCache* a = c->daOrigem[origem];
+    if (a && a->versao != g->versao) {
+        removerArvoreCache(c, a, n);
+        a = NULL;
+    }
+    if (a) {
+        desligarArvoreCache(c, a);
+        ligarArvoreCache(c, a);
+        *nova = 0;
+        return a;
+    }
+
+    long long bytes = bytesArvoreCache(n);
+    if (bytes > c->bytesMaximos) return NULL;
+    while (c->ultima && c->contadores.bytes + bytes > c->bytesMaximos) {
+        removerArvoreCache(c, c->ultima, n);
+        c->contadores.descartes++;
+    }
+    a = calloc(1, sizeof(ArvoreCache));
+    if (a) {
+        a->dist = malloc((n + 1) * sizeof(double));
+        a->anterior = malloc((n + 1) * sizeof(int));
+        a->fechado = malloc((n + 1) * sizeof(int));
+    }
+    if (!a || !a->dist || !a->anterior || !a->fechado) {
+        if (a) {
+            free(a->dist);
+            free(a->anterior);
+            free(a->fechado);
+        }
+        free(a);
+        return NULL;
+    }
+    for (int i = 0; i < n; i++) {
+        a->dist[i] = NAV_INF;
+        a->fechado[i] = 0;
+        a->anterior[i] = -1;
+    }
+    a->dist[origem] = 0;
+    a->origem = origem;
+    a->versao = g->versao;
+    a->pendente = -1;
+    ligarArvoreCache(c, a);
+    c->daOrigem[origem] = a;
+    c->contadores.arvores++;
+    c->contadores.bytes += bytes;
+    *nova = 1;
+    return a;
+}
+
+// Responde a consulta com a rvore 'a' da origem: acerto se o destino j est fechado (ou a rvore
+// est completa); seno a busca continua a partir da fronteira guardada, como o Dijkstra faria
+static void consultarArvore(const NavGrafo* g, EspacoBusca* eb, ArvoreCache* a, int nova, int destino,
+                            int pararNoDestino, int* nosExplorados, double* custoFinal) {
+    NavContadoresCache* contadores = &eb->cache.contadores;
+    *nosExplorados = 0;
+    if (!nova && (a->completa || a->fechado[destino])) {
+        contadores->acertos++;
+        eb->metricas.cache = 1;
+        *custoFinal = a->dist[destino];
+        return;
+    }
+
+    esvaziarFila(&eb->heap);
+    if (nova) {
+        contadores->faltas++;
+        eb->metricas.cache = 3;
+        inserirFila(&eb->heap, a->origem, 0);
+    } else {
+        contadores->retomadas++;
+        eb->metricas.cache = 2;
+        // O ltimo vrtice fechado (o destino da consulta anterior) ainda no teve as arestas relaxadas
+        int u = a->pendente;
+        for (int e = u == -1 ? 0 : g->inicioAresta[u]; u != -1 && e < g->inicioAresta[u + 1]; e++) {
+            int v = g->destinoAresta[e];
+            if (!a->fechado[v] && a->dist[u] + g->pesoAresta[e] < a->dist[v]) {
+                a->dist[v] = a->dist[u] + g->pesoAresta[e];
+                a->anterior[v] = u;
+            }
+        }
+        for (int v = 0; v < g->totalVertices; v++)
+            if (!a->fechado[v] && a->dist[v] < NAV_INF) inserirFila(&eb->heap, v, a->dist[v]);
+    }
+    a->completa = fecharVertices(g, eb, a->dist, a->fechado, a->anterior, destino, pararNoDestino, nosExplorados);
+    a->pendente = a->completa ? -1 : destino;
+    *custoFinal = a->dist[destino];
+}
+
+// ------------------------ ALT (LANDMARKS) ------------------------ //
+// Pr-processamento (backend --gerar-alt): escolhe K vrtices de referncia (landmarks) e grava,
+// em um arquivo .alt ao lado do .poly, as distncias de cada landmark L para todos os vrtices
+// e de todos os vrtices at L. Pela desigualdade triangular, para qualquer v e destino t:
+//     d(v, t) >= d(v, L) - d(t, L)   e   d(v, t) >= d(L, t) - d(L, v)
+// O maior desses limites (e a distncia Euclidiana) vira a heurstica do A* no modo "alt",
+// bem mais justa que a Euclidiana pura em mapas com rios, vias de mo nica e becos
+
+#define LANDMARKS_PADRAO 8     // Quantidade de landmarks quando no informada (k <= 0)
+#define MAX_LANDMARKS 64
+
+
+static void liberarLandmarks(NavGrafo* g) {
+    free(g->alt.landmark);
+    free(g->alt.distDe);
+    free(g->alt.distPara);
+    g->alt.landmark = NULL;
+    g->alt.distDe = g->alt.distPara = NULL;
+    g->alt.total = 0;
+    g->alt.carregada = 0;
+}
+
+// Escolhe os landmarks por "ponto mais distante": o primeiro  o vrtice mais distante de um
+// ponto de partida bem conectado e cada novo landmark  o vrtice cuja menor distncia aos
+// landmarks j escolhidos  a maior. Vrtices inalcanveis a partir de todos so ignorados,
+// o que concentra os landmarks no maior componente, onde est a maioria das consultas
+// eb  usado nos Dijkstras de pr-processamento. Retorna 1 se bem sucedido, 0 se faltar memria
+static int construirLandmarks(NavGrafo* g, EspacoBusca* eb, int k) {
+    liberarLandmarks(g);
+    int n = g->totalVertices;
+    if (k > n) k = n;
+    if (k > MAX_LANDMARKS) k = MAX_LANDMARKS;
+    g->alt.landmark = malloc((k + 1) * sizeof(int));
+    g->alt.distDe = malloc(((size_t)k * n + 1) * sizeof(double));
+    g->alt.distPara = malloc(((size_t)k * n + 1) * sizeof(double));
+    double* menor = malloc((n + 1) * sizeof(double));
+    if (!g->alt.landmark || !g->alt.distDe || !g->alt.distPara || !menor) {
+        free(menor);
+        liberarLandmarks(g);
+        return 0;
+    }
+
+    // Ponto de partida: entre alguns vrtices espalhados, o que alcana mais vrtices
+    int partida = 0, melhorAlcance = -1;
+    for (int amostra = 0; amostra < 16 && n > 0; amostra++) {
+        int v = (int)((long long)amostra * n / 16);
+        dijkstraCompleto(g, eb, v, 0, menor);
+        int alcance = 0;
+        for (int i = 0; i < n; i++) if (menor[i] < NAV_INF) alcance++;
+        if (alcance > melhorAlcance) {
+            melhorAlcance = alcance;
+            partida = v;
+        }
+    }
+    dijkstraCompleto(g, eb, partida, 0, menor);
+
+    for (g->alt.total = 0; g->alt.total < k; g->alt.total++) {
+        // Prximo landmark: maior distncia finita ao conjunto atual (ou ao ponto de partida)
+        int escolhido = -1;
+        for (int v = 0; v < n; v++)
+            if (menor[v] < NAV_INF && (escolhido == -1 || menor[v] > menor[escolhido])) escolhido = v;
+        if (escolhido == -1 || (g->alt.total > 0 && menor[escolhido] == 0)) break;
+
+        double* de = g->alt.distDe + (size_t)g->alt.total * n;
+        double* para = g->alt.distPara + (size_t)g->alt.total * n;
+        g->alt.landmark[g->alt.total] = escolhido;
+        dijkstraCompleto(g, eb, escolhido, 0, de);
+        dijkstraCompleto(g, eb, escolhido, 1, para);
+
+        if (g->alt.total == 0) {
+            for (int v = 0; v < n; v++) menor[v] = de[v];
+        } else {
+            for (int v = 0; v < n; v++) if (de[v] < menor[v]) menor[v] = de[v];
+        }
+    }
+    free(menor);
+    g->alt.carregada = g->alt.total > 0;
+    CONTAR_BYTES(g, (k + 1) * sizeof(int) + 2 * ((size_t)k * n + 1) * sizeof(double));
+    return 1;
+}
+
+// Limite inferior de d(v, destino) pelos landmarks (combinado com a distncia Euclidiana)
+// Devolve INF quando algum landmark prova que v no alcana o destino: o destino chega em L
+// mas v no, logo no pode existir caminho v -> destino
+static double heuristicaALT(const NavGrafo* g, int v, int destino) {
+    double h = heuristica(g, v, destino);
+    int n = g->totalVertices;
+    for (int k = 0; k < g->alt.total; k++) {
+        double paraV = g->alt.distPara[(size_t)k * n + v], paraT = g->alt.distPara[(size_t)k * n + destino];
+        double deV = g->alt.distDe[(size_t)k * n + v], deT = g->alt.distDe[(size_t)k * n + destino];
+        if (paraT < NAV_INF) {
+            if (paraV >= NAV_INF) return NAV_INF;
+            if (paraV - paraT > h) h = paraV - paraT;
+        }
+        if (deT < NAV_INF && deV < NAV_INF && deT - deV > h) h = deT - deV;
+    }
+    return h;
+}
+
+// Formato do arquivo .alt (binrio): assinatura "NAVALT2\0", totalVertices, totalArestasDirigidas,
+// assinaturaNumeracao, K, landmark[K], distDe[K * totalVertices] e distPara[K * totalVertices]
+// O formato anterior ("NAVALT1\0", sem assinaturaNumeracao) foi gerado sempre na ordem do arquivo e
+// continua aceito por grafos carregados nessa ordem
+#define ASSINATURA_ALT "NAVALT2"
+#define ASSINATURA_ALT_ORDEM_ARQUIVO "NAVALT1"
+
+static int salvarLandmarks(const NavGrafo* g, const char* nome) {
+    FILE* f = fopen(nome, "wb");
+    if (!f) return 0;
+    char assinatura[8] = ASSINATURA_ALT;
+    size_t tabela = (size_t)g->alt.total * g->totalVertices;
+    unsigned long long numeracao = assinaturaNumeracao(g);
+    int ok = fwrite(assinatura, 1, 8, f) == 8
+          && fwrite(&g->totalVertices, sizeof(int), 1, f) == 1
+          && fwrite(&g->totalArestasDirigidas, sizeof(int), 1, f) == 1
+          && fwrite(&numeracao, sizeof(numeracao), 1, f) == 1
+          && fwrite(&g->alt.total, sizeof(int), 1, f) == 1
+          && fwrite(g->alt.landmark, sizeof(int), g->alt.total, f) == (size_t)g->alt.total
+          && fwrite(g->alt.distDe, sizeof(double), tabela, f) == tabela
+          && fwrite(g->alt.distPara, sizeof(double), tabela, f) == tabela;
+    fclose(f);
+    return ok;
+}
+
+// L as tabelas de landmarks geradas para o grafo carregado; retorna 0 se o arquivo no existir,
+// estiver corrompido ou tiver sido gerado a partir de outro grafo (ou do mesmo em outra ordem de vrtices)
+static int carregarLandmarks(NavGrafo* g, const char* nome) {
+    liberarLandmarks(g);
+    FILE* f = fopen(nome, "rb");
+    if (!f) return 0;
+
+    char assinatura[8];
+    int n, m, k;
+    unsigned long long numeracao = assinaturaNumeracao(g);
+    int ok = fread(assinatura, 1, 8, f) == 8;
+    int antigo = ok && memcmp(assinatura, ASSINATURA_ALT_ORDEM_ARQUIVO, 8) == 0 && g->ordemVertices == ORDEM_ARQUIVO;
+    ok = ok && (antigo || memcmp(assinatura, ASSINATURA_ALT, 8) == 0)
+          && fread(&n, sizeof(int), 1, f) == 1 && fread(&m, sizeof(int), 1, f) == 1
+          && (antigo || fread(&numeracao, sizeof(numeracao), 1, f) == 1) && fread(&k, sizeof(int), 1, f) == 1
+          && n == g->totalVertices && m == g->totalArestasDirigidas && numeracao == assinaturaNumeracao(g)
+          && k > 0 && k <= MAX_LANDMARKS;
+    if (ok) {
+        size_t tabela = (size_t)k * n;
+        g->alt.landmark = malloc(k * sizeof(int));
+        g->alt.distDe = malloc((tabela + 1) * sizeof(double));
+        g->alt.distPara = malloc((tabela + 1) * sizeof(double));
+        ok = g->alt.landmark && g->alt.distDe && g->alt.distPara
+          && fread(g->alt.landmark, sizeof(int), k, f) == (size_t)k
+          && fread(g->alt.distDe, sizeof(double), tabela, f) == tabela
+          && fread(g->alt.distPara, sizeof(double), tabela, f) == tabela;
+    }
+    fclose(f);
+    if (!ok) {
+        liberarLandmarks(g);
+        return 0;
+    }
+    g->alt.total = k;
+    g->alt.carregada = 1;
+    CONTAR_BYTES(g, k * sizeof(int) + 2 * ((size_t)k * n + 1) * sizeof(double));
+    return 1;
+}
+
+// ------------------------ ALGORITMO A* ------------------------ //
+// Variante do Dijkstra guiada ao destino: a heap  ordenada por dist[v] + h(v), onde h(v)  a
+// distncia Euclidiana de v at o destino (vezes g->fatorHeuristica). Como nenhuma aresta pesa menos
+// que isso entre as suas pontas, h nunca superestima o custo restante (admissvel) e respeita a
+// desigualdade triangular (consistente), ento um vrtice extrado da heap j tem distncia definitiva
+// Com usarLandmarks, h(v)  o limite de heuristicaALT(g), tambm consistente, e vrtices que
+// comprovadamente no alcanam o destino nem entram na heap
+// Parmetros iguais aos de dijkstra(g); a busca sempre para ao extrair o destino
+static void astar(const NavGrafo* g, EspacoBusca* eb, int origem, int destino, int usarLandmarks, int* nosExplorados, double* custoFinal) {
+    double* dist = eb->dist;          // Distncias mnimas acumuladas da origem (g)
+    int* visitado = eb->visitado;     // Marca se o vrtice j foi fechado
+    int* anterior = eb->anterior;
+    *nosExplorados = 0;
+
+    for (int i = 0; i < g->totalVertices; i++) {
+        dist[i] = NAV_INF;
+        visitado[i] = 0;
+        anterior[i] = -1;
+    }
+    dist[origem] = 0;
+
+    esvaziarFila(&eb->heap);
+    double h = usarLandmarks ? heuristicaALT(g, origem, destino) : heuristica(g, origem, destino);
+    if (h < NAV_INF) inserirFila(&eb->heap, origem, h);  // Chave f = g + h
+
+    while (eb->heap.tam > 0) {
+        int u = extrairMinFila(&eb->heap);
+        if (visitado[u]) {
+            METRICA(eb->metricas.extracoesObsoletas++);
+            continue;
+        }
+        visitado[u] = 1;
+        (*nosExplorados)++;
+        if (u == destino) break;  // Destino fechado: dist[destino]  o custo mnimo
+        METRICA(eb->metricas.arestasRelaxadas += g->inicioAresta[u + 1] - g->inicioAresta[u]);
+
+        for (int e = g->inicioAresta[u]; e < g->inicioAresta[u + 1]; e++) {
+            int v = g->destinoAresta[e];
+            if (!visitado[v] && dist[u] + g->pesoAresta[e] < dist[v]) {
+                h = usarLandmarks ? heuristicaALT(g, v, destino) : heuristica(g, v, destino);
+                if (h >= NAV_INF) continue;  // v no alcana o destino
+                dist[v] = dist[u] + g->pesoAresta[e];
+                anterior[v] = u;
+                inserirFila(&eb->heap, v, dist[v] + h);
+            }
+        }
+    }
+
+    *custoFinal = dist[destino];
+}
+
+// ------------------------ BUSCA BIDIRECIONAL ------------------------ //
+// Potencial usado pela busca bidirecional A*: mdia das heursticas dos dois sentidos,
+// pF(v) = (d(v, destino) - d(origem, v)) / 2, enquanto a busca reversa usa pR(v) = -pF(v)
+// Com potenciais opostos as duas buscas enxergam os mesmos custos reduzidos, o que mantm
+// vlido o critrio de parada do Dijkstra bidirecional
+static double potencialBidirecional(const NavGrafo* g, int v, int origem, int destino) {
+    return (heuristica(g, v, destino) - heuristica(g, origem, v)) / 2;
+}
+
+// Busca simultnea a partir da origem (no grafo direto) e do destino (no grafo reverso)
+// A cada passo avana o sentido cuja heap tem a menor chave; 'melhor' guarda o custo do melhor
+// caminho origem -> encontro -> destino j visto, e a busca termina quando a soma das chaves
+// mnimas das duas heaps alcana esse valor, pois nenhum caminho ainda no visto pode ser menor
+// usarAstar soma os potenciais Euclidianos s chaves (com 0  o Dijkstra bidirecional puro)
+// Retorna o vrtice de encontro das duas rvores (-1 se no h caminho), usado por montarCaminhoBidirecional
+static int buscaBidirecional(const NavGrafo* g, EspacoBusca* eb, int origem, int destino, int usarAstar, int* nosExplorados,
+                             double* custoFinal) {
+    double* distDireta = eb->dist;
+    double* distReversa = eb->distReversa;
+    int* visitadoDireta = eb->visitado;
+    int* visitadoReversa = eb->visitadoReversa;
+    int* anterior = eb->anterior;   // Predecessor na rvore da busca direta
+    int* sucessor = eb->sucessor;   // Sucessor (rumo ao destino) na rvore da busca reversa
+    FilaPrioridade* heapDireta = &eb->heap;
+    FilaPrioridade* heapReversa = &eb->heapReversa;
+    *nosExplorados = 0;
+
+    for (int i = 0; i < g->totalVertices; i++) {
+        distDireta[i] = distReversa[i] = NAV_INF;
+        visitadoDireta[i] = visitadoReversa[i] = 0;
+        anterior[i] = sucessor[i] = -1;
+    }
+    distDireta[origem] = 0;
+    distReversa[destino] = 0;
+
+    double melhor = NAV_INF;   // Custo do melhor caminho completo encontrado at agora
+    int encontro = -1;     // Vrtice onde as duas rvores se encontram nesse caminho
+    if (origem == destino) {
+        melhor = 0;
+        encontro = origem;
+    }
+
+    esvaziarFila(heapDireta);
+    esvaziarFila(heapReversa);
+    inserirFila(heapDireta, origem, usarAstar ? potencialBidirecional(g, origem, origem, destino) : 0);
+    inserirFila(heapReversa, destino, usarAstar ? -potencialBidirecional(g, destino, origem, destino) : 0);
+
+    while (heapDireta->tam > 0 && heapReversa->tam > 0) {
+        // Critrio de parada: as chaves mnimas (j com os potenciais) somadas no melhoram 'melhor'
+        if (menorChaveFila(heapDireta) + menorChaveFila(heapReversa) >= melhor) break;
+
+        if (menorChaveFila(heapDireta) <= menorChaveFila(heapReversa)) {
+            int u = extrairMinFila(heapDireta);
+            if (visitadoDireta[u]) {
+                METRICA(eb->metricas.extracoesObsoletas++);
+                continue;
+            }
+            visitadoDireta[u] = 1;
+            (*nosExplorados)++;
+            METRICA(eb->metricas.arestasRelaxadas += g->inicioAresta[u + 1] - g->inicioAresta[u]);
+
+            for (int e = g->inicioAresta[u]; e < g->inicioAresta[u + 1]; e++) {
+                int v = g->destinoAresta[e];
+                if (!visitadoDireta[v] && distDireta[u] + g->pesoAresta[e] < distDireta[v]) {
+                    distDireta[v] = distDireta[u] + g->pesoAresta[e];
+                    anterior[v] = u;
+                    double p = usarAstar ? potencialBidirecional(g, v, origem, destino) : 0;
+                    inserirFila(heapDireta, v, distDireta[v] + p);
+                    // v j alcanado pela busca reversa: fecha um caminho completo
+                    if (distDireta[v] + distReversa[v] < melhor) {
+                        melhor = distDireta[v] + distReversa[v];
+                        encontro = v;
+                    }
+                }
+            }
+        } else {
+            int u = extrairMinFila(heapReversa);
+            if (visitadoReversa[u]) {
+                METRICA(eb->metricas.extracoesObsoletas++);
+                continue;
+            }
+            visitadoReversa[u] = 1;
+            (*nosExplorados)++;
+            METRICA(eb->metricas.arestasRelaxadas += g->inicioArestaReversa[u + 1] - g->inicioArestaReversa[u]);
+
+            for (int e = g->inicioArestaReversa[u]; e < g->inicioArestaReversa[u + 1]; e++) {
+                int v = g->origemArestaReversa[e];
+                if (!visitadoReversa[v] && distReversa[u] + g->pesoArestaReversa[e] < distReversa[v]) {
+                    distReversa[v] = distReversa[u] + g->pesoArestaReversa[e];
+                    sucessor[v] = u;
+                    double p = usarAstar ? -potencialBidirecional(g, v, origem, destino) : 0;
+                    inserirFila(heapReversa, v, distReversa[v] + p);
+                    if (distDireta[v] + distReversa[v] < melhor) {
+                        melhor = distDireta[v] + distReversa[v];
+                        encontro = v;
+                    }
+                }
+            }
+        }
+    }
+
+    *custoFinal = melhor;
+    return encontro;
+}
+
+// Caminho da busca bidirecional: origem .. encontro (rvore direta, de trs para frente) seguido de
+// encontro .. destino (rvore reversa). Escreve em caminho[] e retorna a quantidade de vrtices
+static int montarCaminhoBidirecional(const NavGrafo* g, const EspacoBusca* eb, int encontro, int* caminho) {
+    int tam = 0;
+    for (int v = encontro; v != -1 && tam < g->totalVertices; v = eb->anterior[v])
+        caminho[tam++] = v;
+    for (int i = 0; i < tam / 2; i++) {
+        int tmp = caminho[i];
+        caminho[i] = caminho[tam - 1 - i];
+        caminho[tam - 1 - i] = tmp;
+    }
+    for (int v = eb->sucessor[encontro]; v != -1 && tam < g->totalVertices; v = eb->sucessor[v])
+        caminho[tam++] = v;
+    return tam;
+}
+
+// ------------------------ CONTRACTION HIERARCHIES ------------------------ //
+// Pr-processamento (backend --gerar-ch): os vrtices so contrados um a um, em ordem de
+// importncia crescente. Ao contrair v, cada par u -> v -> x cujo menor caminho passa
+// obrigatoriamente por v ganha um atalho u -> x com o peso somado. O resultado  gravado em
+// um arquivo .ch ao lado do .poly. A consulta faz uma busca bidirecional que s sobe na
+// hierarquia: a direta usa as arestas para vrtices contrados depois (subida) e a reversa as
+// arestas que chegam de vrtices contrados depois (descida). Os atalhos do caminho encontrado
+// so desempacotados de volta nos vrtices originais de vertices[]
+
+// Limite de vrtices fechados por busca de testemunha: cresce com o grau do vrtice contrado. Perto
+// do topo da hierarquia os vizinhos esto ligados por atalhos longos e uma busca curta deixa de achar
+// testemunhas que existem; cada atalho desnecessrio aumenta o grau dos vizinhos, que passam a criar
+// ainda mais atalhos quando forem contrados
+#define FECHADOS_TESTEMUNHA 1000     // Vrtices fechados por busca, mais...
+#define FECHADOS_POR_ARESTA 400      // ... este tanto por aresta (de entrada ou sada) do vrtice contrado
+
+// Aresta da hierarquia: original (meio == -1) ou atalho que pula o vrtice contrado 'meio'
+typedef struct {
+    int alvo;              // ndice interno do vrtice vizinho
+    double peso;           // Peso da aresta ou soma dos pesos do trecho representado pelo atalho
+    int meio;              // Vrtice contrado pulado pelo atalho, -1 se for aresta original
+    int originais;         // Arestas originais representadas (1 se for aresta original)
+} ArestaCH;
+
+// Lista dinmica de arestas de um vrtice durante a contrao
+typedef struct {
+    ArestaCH* itens;
+    int tam, cap;
+} ListaCH;
+
+
+// Estado usado apenas durante o pr-processamento
+typedef struct {
+    ListaCH* saidas;       // Arestas que saem de cada vrtice ainda no contrado
+    ListaCH* entradas;     // Arestas que chegam a cada vrtice ainda no contrado
+    double* distTestemunha;
+    int* tocados;          // Vrtices com distTestemunha alterada pela ltima busca
+    int totalTocados;
+    int* marcaAlvo;        // marcaAlvo[x] == carimbo: x  destino de um atalho da busca atual
+    int carimbo;
+    int alvosRestantes;    // Destinos da busca atual ainda no fechados
+    int originaisAtalhos;  // Arestas originais representadas pelos atalhos da ltima contrao
+    HeapIndexada heapTestemunha;
+} ContracaoCH;
+
+// Adiciona a aresta para 'alvo' na lista, ou melhora a existente se o novo peso for menor
+// Retorna 1 se bem sucedido, 0 se faltar memria (a lista continua como estava)
+static int atualizarListaCH(ListaCH* l, int alvo, double peso, int meio, int originais) {
+    for (int i = 0; i < l->tam; i++) {
+        if (l->itens[i].alvo == alvo) {
+            if (peso < l->itens[i].peso) {
+                l->itens[i].peso = peso;
+                l->itens[i].meio = meio;
+                l->itens[i].originais = originais;
+            }
+            return 1;
+        }
+    }
+    if (l->tam == l->cap) {
+        int cap = l->cap ? 2 * l->cap : 4;
+        ArestaCH* itens = realloc(l->itens, cap * sizeof(ArestaCH));
+        if (!itens) return 0;
+        l->itens = itens;
+        l->cap = cap;
+    }
+    l->itens[l->tam].alvo = alvo;
+    l->itens[l->tam].peso = peso;
+    l->itens[l->tam].meio = meio;
+    l->itens[l->tam].originais = originais;
+    l->tam++;
+    return 1;
+}
+
+// Remove a aresta para 'alvo' da lista (a ordem das arestas no importa)
+static void removerListaCH(ListaCH* l, int alvo) {
+    for (int i = 0; i < l->tam; i++) {
+        if (l->itens[i].alvo == alvo) {
+            l->itens[i] = l->itens[--l->tam];
+            return;
+        }
+    }
+}
+
+// Dijkstra local a partir de 'inicio' que ignora o vrtice 'ignorado' (o que est sendo contrado)
+// Para ao passar do custo 'limite', aps 'maxFechados' vrtices fechados ou quando os destinos marcados
+// (c->alvosRestantes) j foram todos fechados; distTestemunha[x] fica com o custo de um caminho real
+// at x, ou INF se nenhum foi encontrado dentro dos limites
+static void buscaTestemunha(ContracaoCH* c, int inicio, int ignorado, double limite, int maxFechados) {
+    int fechados = 0;
+    esvaziarIndexada(&c->heapTestemunha);
+    c->distTestemunha[inicio] = 0;
+    c->tocados[c->totalTocados++] = inicio;
+    inserirOuDiminuir(&c->heapTestemunha, inicio, 0);
+
+    while (c->heapTestemunha.tam > 0 && c->alvosRestantes > 0) {
+        double d = c->heapTestemunha.itens[0].dist;
+        int u = extrairMinIndexada(&c->heapTestemunha);
+        if (d > limite || ++fechados > maxFechados) break;
+        if (c->marcaAlvo[u] == c->carimbo) c->alvosRestantes--;
+
+        ListaCH* l = &c->saidas[u];
+        for (int i = 0; i < l->tam; i++) {
+            int x = l->itens[i].alvo;
+            double nd = d + l->itens[i].peso;
+            if (x == ignorado || nd >= c->distTestemunha[x]) continue;
+            if (c->distTestemunha[x] >= NAV_INF) c->tocados[c->totalTocados++] = x;
+            c->distTestemunha[x] = nd;
+            inserirOuDiminuir(&c->heapTestemunha, x, nd);
+        }
+    }
+}
+
+// Restaura distTestemunha para INF apenas nos vrtices tocados pela ltima busca
+static void limparTestemunha(ContracaoCH* c) {
+    for (int i = 0; i < c->totalTocados; i++)
+        c->distTestemunha[c->tocados[i]] = NAV_INF;
+    c->totalTocados = 0;
+}
+
+// Contrai o vrtice v, criando os atalhos necessrios entre seus vizinhos ainda no contrados
+// Com simular == 1 apenas conta quantos atalhos seriam criados, sem alterar o grafo. A simulao
+// usa os mesmos limites da contrao: se ela achar menos testemunhas, a prioridade fica errada
+// justamente nos vrtices que criam mais atalhos. Soma em c->originaisAtalhos as arestas originais
+// representadas pelos atalhos. Retorna o nmero de atalhos, ou -1 se faltar memria para guard-los
+static int contrairVertice(ContracaoCH* c, int v, int simular) {
+    int atalhos = 0;
+    int maxFechados = FECHADOS_TESTEMUNHA + FECHADOS_POR_ARESTA * (c->entradas[v].tam + c->saidas[v].tam);
+    c->originaisAtalhos = 0;
+
+    for (int i = 0; i < c->entradas[v].tam; i++) {
+        int u = c->entradas[v].itens[i].alvo;
+        double pesoEntrada = c->entradas[v].itens[i].peso;
+
+        // Destinos de atalhos a partir de u: a busca termina assim que todos forem fechados
+        double maiorSaida = 0;
+        c->carimbo++;
+        c->alvosRestantes = 0;
+        for (int j = 0; j < c->saidas[v].tam; j++) {
+            int x = c->saidas[v].itens[j].alvo;
+            if (x == u || c->marcaAlvo[x] == c->carimbo) continue;
+            c->marcaAlvo[x] = c->carimbo;
+            c->alvosRestantes++;
+            if (c->saidas[v].itens[j].peso > maiorSaida) maiorSaida = c->saidas[v].itens[j].peso;
+        }
+        if (c->alvosRestantes == 0) continue;
+        buscaTestemunha(c, u, v, pesoEntrada + maiorSaida, maxFechados);
+
+        for (int j = 0; j < c->saidas[v].tam; j++) {
+            int x = c->saidas[v].itens[j].alvo;
+            double pesoAtalho = pesoEntrada + c->saidas[v].itens[j].peso;
+            if (x == u || c->distTestemunha[x] <= pesoAtalho) continue;  // Existe caminho sem passar por v
+            int originais = c->entradas[v].itens[i].originais + c->saidas[v].itens[j].originais;
+            atalhos++;
+            c->originaisAtalhos += originais;
+            if (!simular && (!atualizarListaCH(&c->saidas[u], x, pesoAtalho, v, originais)
+                             || !atualizarListaCH(&c->entradas[x], u, pesoAtalho, v, originais))) {
+                limparTestemunha(c);
+                return -1;
+            }
+        }
+        limparTestemunha(c);
+    }
+    return atalhos;
+}
+
+// Prioridade de contrao: diferena de arestas (atalhos criados - arestas removidas) somada 
+// diferena de arestas originais representadas por elas. O segundo termo adia os vrtices cujos
+// atalhos ficariam longos e espalha a contrao pelo grafo
+static double prioridadeCH(ContracaoCH* c, int v) {
+    int atalhos = contrairVertice(c, v, 1);
+    int removidas = 0;
+    for (int i = 0; i < c->entradas[v].tam; i++) removidas += c->entradas[v].itens[i].originais;
+    for (int i = 0; i < c->saidas[v].tam; i++) removidas += c->saidas[v].itens[i].originais;
+    return (double)(atalhos - c->entradas[v].tam - c->saidas[v].tam) + (c->originaisAtalhos - removidas);
+}
+
+// Converte as listas congeladas no momento da contrao em um grafo de atalhos CSR
+static int listasParaCSR(const NavGrafo* g, ListaCH* listas, CSRAtalhos* csr) {
+    csr->total = 0;
+    for (int v = 0; v < g->totalVertices; v++) csr->total += listas[v].tam;
+    csr->inicio = malloc((g->totalVertices + 1) * sizeof(int));
+    csr->alvo = malloc((csr->total + 1) * sizeof(int));
+    csr->peso = malloc((csr->total + 1) * sizeof(double));
+    csr->meio = malloc((csr->total + 1) * sizeof(int));
+    if (!csr->inicio || !csr->alvo || !csr->peso || !csr->meio) return 0;
+
+    int k = 0;
+    for (int v = 0; v < g->totalVertices; v++) {
+        csr->inicio[v] = k;
+        for (int i = 0; i < listas[v].tam; i++, k++) {
+            csr->alvo[k] = listas[v].itens[i].alvo;
+            csr->peso[k] = listas[v].itens[i].peso;
+            csr->meio[k] = listas[v].itens[i].meio;
+        }
+    }
+    csr->inicio[g->totalVertices] = k;
+    return 1;
+}
+
+static void liberarCSRAtalhos(CSRAtalhos* csr) {
+    free(csr->inicio); free(csr->alvo); free(csr->peso); free(csr->meio);
+    csr->inicio = csr->alvo = csr->meio = NULL;
+    csr->peso = NULL;
+    csr->total = 0;
+}
+
+static void liberarHierarquia(NavGrafo* g) {
+    free(g->ch.nivel);
+    g->ch.nivel = NULL;
+    liberarCSRAtalhos(&g->ch.subida);
+    liberarCSRAtalhos(&g->ch.descida);
+    g->ch.carregada = 0;
+    g->ch.cordal = 0;
+}
+
+// Aloca o estado da contrao e monta o grafo inicial a partir do CSR com os pesos atuais: sem laos,
+// sem arestas interditadas (peso >= NAV_INF, veja PESOS DINMICOS) e mantendo a menor entre arestas
+// paralelas. Retorna 1 se bem sucedido, 0 se faltar memria (liberarContracao libera o que foi alocado)
+static int iniciarContracao(const NavGrafo* g, ContracaoCH* c) {
+    int n = g->totalVertices;
+    c->saidas = calloc(n, sizeof(ListaCH));
+    c->entradas = calloc(n, sizeof(ListaCH));
+    c->distTestemunha = malloc(n * sizeof(double));
+    c->tocados = malloc(n * sizeof(int));
+    c->marcaAlvo = calloc(n, sizeof(int));
+    c->carimbo = 0;
+    if (!c->saidas || !c->entradas || !c->distTestemunha || !c->tocados || !c->marcaAlvo
+        || !alocarIndexada(&c->heapTestemunha, n)) return 0;
+
+    for (int u = 0; u < n; u++) {
+        c->distTestemunha[u] = NAV_INF;
+        for (int e = g->inicioAresta[u]; e < g->inicioAresta[u + 1]; e++) {
+            int v = g->destinoAresta[e];
+            if (v == u || g->pesoAresta[e] >= NAV_INF) continue;
+            if (!atualizarListaCH(&c->saidas[u], v, g->pesoAresta[e], -1, 1)
+                || !atualizarListaCH(&c->entradas[v], u, g->pesoAresta[e], -1, 1)) return 0;
+        }
+    }
+    return 1;
+}
+
+static void liberarContracao(ContracaoCH* c, int n) {
+    for (int v = 0; c->saidas && c->entradas && v < n; v++) {
+        free(c->saidas[v].itens);
+        free(c->entradas[v].itens);
+    }
+    free(c->saidas); free(c->entradas);
+    free(c->distTestemunha); free(c->tocados); free(c->marcaAlvo);
+    liberarIndexada(&c->heapTestemunha);
+}
+
+// Tira o vrtice v, recm-contrado, das listas dos vizinhos. As listas de v ficam congeladas:
+// todos os vizinhos restantes esto acima na hierarquia
+static void congelarVertice(ContracaoCH* c, int v) {
+    for (int i = 0; i < c->saidas[v].tam; i++)
+        removerListaCH(&c->entradas[c->saidas[v].itens[i].alvo], v);
+    for (int i = 0; i < c->entradas[v].tam; i++)
+        removerListaCH(&c->saidas[c->entradas[v].itens[i].alvo], v);
+}
+
+// Calcula a hierarquia para o grafo carregado e a deixa em 'ch'
+// Retorna o nmero de atalhos criados, ou -1 se faltar memria
+static int construirHierarquia(NavGrafo* g) {
+    int n = g->totalVertices;
+    ContracaoCH contracao = { 0 };
+    ContracaoCH* c = &contracao;
+    HeapIndexada fila = { 0 };
+    int* atualizadoEm = malloc(n * sizeof(int));   // ltima contrao que recalculou a prioridade do vrtice
+    g->ch.nivel = malloc(n * sizeof(int));
+    int ok = g->ch.nivel && atualizadoEm && iniciarContracao(g, c) && alocarIndexada(&fila, n);
+
+    int atalhos = 0;
+    if (ok) {
+        for (int v = 0; v < n; v++) {
+            atualizadoEm[v] = -1;
+            inserirOuDiminuir(&fila, v, prioridadeCH(c, v));
+        }
+
+        // A contrao de v muda as arestas dos vizinhos, ento a prioridade de cada um  recalculada
+        // logo em seguida. A de vrtices mais distantes s muda se um caminho de testemunha passava
+        // por v, e fica como est
+        int ordem = 0;
+        while (fila.tam > 0) {
+            int v = extrairMinIndexada(&fila);
+            int criados = contrairVertice(c, v, 0);
+            if (criados < 0) {
+                ok = 0;
+                break;
+            }
+            atalhos += criados;
+            g->ch.nivel[v] = ordem++;
+            congelarVertice(c, v);
+
+            for (int lado = 0; lado < 2; lado++) {
+                ListaCH* l = lado == 0 ? &c->saidas[v] : &c->entradas[v];
+                for (int i = 0; i < l->tam; i++) {
+                    int x = l->itens[i].alvo;
+                    if (atualizadoEm[x] == ordem) continue;
+                    atualizadoEm[x] = ordem;
+                    alterarChaveIndexada(&fila, x, prioridadeCH(c, x));
+                }
+            }
+        }
+
+        ok = ok && listasParaCSR(g, c->saidas, &g->ch.subida) && listasParaCSR(g, c->entradas, &g->ch.descida);
+    }
+
+    liberarContracao(c, n);
+    liberarIndexada(&fila);
+    free(atualizadoEm);
+
+    if (!ok) {
+        liberarHierarquia(g);
+        return -1;
+    }
+    g->ch.carregada = 1;
+    CONTAR_BYTES(g, 3 * (g->totalVertices + 1) * sizeof(int)
+                    + (g->ch.subida.total + g->ch.descida.total + 2) * (2 * sizeof(int) + sizeof(double)));
+    return atalhos;
+}
+
+// ---- Recustomizao (pesos dinmicos) ---- //
+// Depois de navAtualizarPesos a hierarquia no  recontrada: como na CCH (Customizable Contraction
+// Hierarchies, Dibbelt, Strasser e Wagner), a topologia dos atalhos fica fixa e s os pesos so
+// recalculados. Os atalhos da contrao no servem para isso, porque as buscas de testemunha que os
+// eliminaram dependem dos pesos. Na primeira recustomizao, a subida e a descida passam a ser o grafo
+// cordal de uma ordem por disseco aninhada (dissecarGrafo): todas as arestas, nos dois sentidos e
+// mesmo as interditadas, e os atalhos entre cada par de vizinhos mais altos de cada vrtice, sem
+// testemunhas. A ordem da contrao no serve aqui, j que o grafo cordal dela tem muitas vezes mais
+// arestas. A subida e a descida de um vrtice passam a ter os mesmos alvos, ordenados por nvel, e
+// as recustomizaes seguintes s refazem os pesos, de baixo para cima (customizarMetrica)
+
+#define LIMITE_DISSECCAO 16   // Partes com at tantos vrtices no so mais divididas
+
+typedef struct {
+    double coordenada;
+    int vertice;
+} ChaveCorte;
+
+static int compararChaveCorte(const void* a, const void* b) {
+    const ChaveCorte* x = (const ChaveCorte*)a;
+    const ChaveCorte* y = (const ChaveCorte*)b;
+    if (x->coordenada != y->coordenada) return x->coordenada < y->coordenada ? -1 : 1;
+    return (x->vertice > y->vertice) - (x->vertice < y->vertice);
+}
+
+// Numera vertices[ini..fim-1] com os nveis topo-1, topo-2, ...: divide a parte ao meio pela mediana
+// da coordenada de maior extenso, e os vrtices da metade de baixo com vizinho na de cima formam o
+// separador, que fica com os nveis mais altos. As duas metades sem o separador no tm arestas entre
+// si e so numeradas do mesmo jeito. 'carimbo' e 'lado' marcam a metade de cima de cada diviso
+static void dissecar(const NavGrafo* g, ChaveCorte* chaves, int* vertices, int ini, int fim, int topo,
+                     int* lado, int* carimbo, int* nivel) {
+    int tam = fim - ini;
+    if (tam <= LIMITE_DISSECCAO) {
+        for (int i = ini; i < fim; i++) nivel[vertices[i]] = --topo;
+        return;
+    }
+    double minX = g->vertices[vertices[ini]].x, maxX = minX, minY = g->vertices[vertices[ini]].y, maxY = minY;
+    for (int i = ini + 1; i < fim; i++) {
+        const Vertice* v = &g->vertices[vertices[i]];
+        if (v->x < minX) minX = v->x;
+        if (v->x > maxX) maxX = v->x;
+        if (v->y < minY) minY = v->y;
+        if (v->y > maxY) maxY = v->y;
+    }
+    int porX = maxX - minX >= maxY - minY;
+    for (int i = 0; i < tam; i++) {
+        chaves[i].vertice = vertices[ini + i];
+        chaves[i].coordenada = porX ? g->vertices[chaves[i].vertice].x : g->vertices[chaves[i].vertice].y;
+    }
+    qsort(chaves, tam, sizeof(ChaveCorte), compararChaveCorte);
+    int meio = ini + tam / 2;
+    (*carimbo)++;
+    for (int i = 0; i < tam; i++) {
+        vertices[ini + i] = chaves[i].vertice;
+        if (ini + i >= meio) lado[chaves[i].vertice] = *carimbo;
+    }
+
+    // Separador no fim da metade de baixo: [ini, fimBaixo) fica sem vizinhos em [meio, fim)
+    int fimBaixo = meio;
+    for (int i = meio - 1; i >= ini; i--) {
+        int v = vertices[i], separa = 0;
+        for (int e = g->inicioAresta[v]; !separa && e < g->inicioAresta[v + 1]; e++)
+            separa = lado[g->destinoAresta[e]] == *carimbo;
+        for (int e = g->inicioArestaReversa[v]; !separa && e < g->inicioArestaReversa[v + 1]; e++)
+            separa = lado[g->origemArestaReversa[e]] == *carimbo;
+        if (separa) {
+            vertices[i] = vertices[--fimBaixo];
+            vertices[fimBaixo] = v;
+        }
+    }
+    for (int i = fimBaixo; i < meio; i++) nivel[vertices[i]] = --topo;
+    dissecar(g, chaves, vertices, meio, fim, topo, lado, carimbo, nivel);
+    dissecar(g, chaves, vertices, ini, fimBaixo, topo - (fim - meio), lado, carimbo, nivel);
+}
+
+// Preenche nivel[] com a ordem por disseco aninhada das coordenadas dos vrtices
+// Retorna 1 se bem sucedido, 0 se faltar memria
+static int dissecarGrafo(const NavGrafo* g, int* nivel) {
+    int n = g->totalVertices;
+    ChaveCorte* chaves = malloc((n + 1) * sizeof(ChaveCorte));
+    int* vertices = malloc((n + 1) * sizeof(int));
+    int* lado = malloc((n + 1) * sizeof(int));
+    int carimbo = 0;
+    int ok = chaves && vertices && lado;
+    if (ok) {
+        for (int v = 0; v < n; v++) {
+            vertices[v] = v;
+            lado[v] = 0;
+        }
+        dissecar(g, chaves, vertices, 0, n, n, lado, &carimbo, nivel);
+    }
+    free(chaves);
+    free(vertices);
+    free(lado);
+    return ok;
+}
+
+// Lista dinmica de nveis, usada s na montagem do grafo cordal
+typedef struct {
+    int* itens;
+    int tam, cap;
+} ListaNiveis;
+
+static int adicionarNivel(ListaNiveis* l, int nivel) {
+    if (l->tam == l->cap) {
+        int cap = l->cap ? 2 * l->cap : 4;
+        int* itens = realloc(l->itens, cap * sizeof(int));
+        if (!itens) return 0;
+        l->itens = itens;
+        l->cap = cap;
+    }
+    l->itens[l->tam++] = nivel;
+    return 1;
+}
+
+static int compararInteiros(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Monta inicio, alvo e total da subida e da descida com o grafo cordal da ordem nivel[] (peso e
+// meio ficam para customizarMetrica). Eliminar um vrtice liga seus vizinhos mais altos entre si;
+// basta pass-los ao mais baixo deles, que ser eliminado antes dos outros
+// Retorna 1 se bem sucedido, 0 se faltar memria (nada fica alocado)
+static int montarTopologiaCordal(const NavGrafo* g, const int* nivel, CSRAtalhos* subida, CSRAtalhos* descida) {
+    int n = g->totalVertices;
+    ListaNiveis* listas = calloc(n + 1, sizeof(ListaNiveis));   // Indexadas por nvel
+    int* marca = malloc((n + 1) * sizeof(int));
+    int* porNivel = malloc((n + 1) * sizeof(int));
+    int ok = listas && marca && porNivel;
+
+    for (int u = 0; ok && u < n; u++) {
+        for (int e = g->inicioAresta[u]; ok && e < g->inicioAresta[u + 1]; e++) {
+            int a = nivel[u], b = nivel[g->destinoAresta[e]];
+            if (a != b) ok = adicionarNivel(&listas[a < b ? a : b], a < b ? b : a);
+        }
+    }
+    long long total = 0;
+    if (ok) {
+        for (int v = 0; v < n; v++) {
+            marca[v] = -1;
+            porNivel[nivel[v]] = v;
+        }
+        for (int l = 0; ok && l < n; l++) {
+            ListaNiveis* lista = &listas[l];
+            int tam = 0;
+            for (int i = 0; i < lista->tam; i++) {
+                if (marca[lista->itens[i]] == l) continue;
+                marca[lista->itens[i]] = l;
+                lista->itens[tam++] = lista->itens[i];
+            }
+            lista->tam = tam;
+            if (tam == 0) continue;
+            qsort(lista->itens, tam, sizeof(int), compararInteiros);
+            for (int i = 1; ok && i < tam; i++) ok = adicionarNivel(&listas[lista->itens[0]], lista->itens[i]);
+            total += tam;
+        }
+    }
+    ok = ok && total < INT_MAX;
+
+    subida->inicio = descida->inicio = subida->alvo = descida->alvo = NULL;
+    if (ok) {
+        subida->total = descida->total = (int)total;
+        subida->inicio = malloc((n + 1) * sizeof(int));
+        descida->inicio = malloc((n + 1) * sizeof(int));
+        subida->alvo = malloc((total + 1) * sizeof(int));
+        descida->alvo = malloc((total + 1) * sizeof(int));
+        ok = subida->inicio && descida->inicio && subida->alvo && descida->alvo;
+    }
+    if (ok) {
+        int k = 0;
+        for (int v = 0; v < n; v++) {
+            const ListaNiveis* lista = &listas[nivel[v]];
+            subida->inicio[v] = descida->inicio[v] = k;
+            for (int i = 0; i < lista->tam; i++, k++) subida->alvo[k] = descida->alvo[k] = porNivel[lista->itens[i]];
+        }
+        subida->inicio[n] = descida->inicio[n] = k;
+    } else {
+        free(subida->inicio); free(descida->inicio);
+        free(subida->alvo); free(descida->alvo);
+    }
+    for (int l = 0; listas && l < n; l++) free(listas[l].itens);
+    free(listas);
+    free(marca);
+    free(porNivel);
+    return ok;
+}
+
+// Calcula peso e meio da subida e da descida (topologia de montarTopologiaCordal) com os pesos atuais.
+// Em ordem crescente de nvel, cada aresta a -> b da subida (e b -> a da descida) recebe a menor aresta
+// original entre a e b e o menor dos tringulos inferiores a -> v -> b, com v mais baixo que a e vizinho
+// dos dois. As arestas de v j so finais nesse momento, porque v foi processado antes de a
+// Retorna 1 se bem sucedido, 0 se faltar memria
+static int customizarMetrica(const NavGrafo* g, const int* nivel, CSRAtalhos* subida, CSRAtalhos* descida) {
+    int n = g->totalVertices;
+    int* posicao = malloc((n + 1) * sizeof(int));
+    int* porNivel = malloc((n + 1) * sizeof(int));
+    // Arestas que chegam a cada vrtice vindas de baixo: a posio i, na subida de v, da aresta v -> a
+    int* inicioInferior = calloc(n + 2, sizeof(int));
+    int* verticeInferior = malloc((subida->total + 1) * sizeof(int));
+    int* posicaoInferior = malloc((subida->total + 1) * sizeof(int));
+    int ok = posicao && porNivel && inicioInferior && verticeInferior && posicaoInferior;
+
+    if (ok) {
+        for (int e = 0; e < subida->total; e++) inicioInferior[subida->alvo[e] + 2]++;
+        for (int v = 0; v < n; v++) inicioInferior[v + 2] += inicioInferior[v + 1];
+        for (int v = 0; v < n; v++) {
+            for (int i = subida->inicio[v]; i < subida->inicio[v + 1]; i++) {
+                int k = inicioInferior[subida->alvo[i] + 1]++;
+                verticeInferior[k] = v;
+                posicaoInferior[k] = i;
+            }
+            posicao[v] = -1;
+            porNivel[nivel[v]] = v;
+        }
+
+        // descida[v][i]  a -> v e subida[v][j]  v -> b
+        for (int l = 0; l < n; l++) {
+            int a = porNivel[l];
+            for (int k = subida->inicio[a]; k < subida->inicio[a + 1]; k++) {
+                posicao[subida->alvo[k]] = k;
+                subida->peso[k] = descida->peso[k] = NAV_INF;
+                subida->meio[k] = descida->meio[k] = -1;
+            }
+            for (int e = g->inicioAresta[a]; e < g->inicioAresta[a + 1]; e++) {
+                int k = posicao[g->destinoAresta[e]];
+                if (k != -1 && g->pesoAresta[e] < subida->peso[k]) subida->peso[k] = g->pesoAresta[e];
+            }
+            for (int e = g->inicioArestaReversa[a]; e < g->inicioArestaReversa[a + 1]; e++) {
+                int k = posicao[g->origemArestaReversa[e]];
+                if (k != -1 && g->pesoArestaReversa[e] < descida->peso[k]) descida->peso[k] = g->pesoArestaReversa[e];
+            }
+            for (int t = inicioInferior[a]; t < inicioInferior[a + 1]; t++) {
+                int v = verticeInferior[t], i = posicaoInferior[t];
+                double paraV = descida->peso[i], deV = subida->peso[i];
+                if (paraV >= NAV_INF && deV >= NAV_INF) continue;
+                // Os vizinhos mais altos de v formam uma clique: os que vm depois de a esto na subida de a
+                for (int j = i + 1; j < subida->inicio[v + 1]; j++) {
+                    int k = posicao[subida->alvo[j]];
+                    double subindo = paraV + subida->peso[j];      // a -> v -> b
+                    double descendo = descida->peso[j] + deV;      // b -> v -> a
+                    if (subindo < subida->peso[k] && subindo < NAV_INF) {
+                        subida->peso[k] = subindo;
+                        subida->meio[k] = v;
+                    }
+                    if (descendo < descida->peso[k] && descendo < NAV_INF) {
+                        descida->peso[k] = descendo;
+                        descida->meio[k] = v;
+                    }
+                }
+            }
+            for (int k = subida->inicio[a]; k < subida->inicio[a + 1]; k++) posicao[subida->alvo[k]] = -1;
+        }
+    }
+    free(posicao);
+    free(porNivel);
+    free(inicioInferior);
+    free(verticeInferior);
+    free(posicaoInferior);
+    return ok;
+}
+
+// Recustomizao com os pesos de g: monta a ordem e o grafo cordal se g->ch ainda no os tem e
+// recalcula os pesos. O resultado vai para 'nova', sem alterar g->ch: os vetores que no mudam (o nvel
+// e a topologia, depois da primeira vez) so compartilhados com g->ch, e os outros so novos
+// Retorna 1 se bem sucedido, 0 se faltar memria (nada fica alocado)
+static int recustomizarHierarquia(const NavGrafo* g, HierarquiaCH* nova) {
+    *nova = g->ch;
+    nova->carregada = nova->cordal = 1;
+    if (!g->ch.cordal) {
+        nova->nivel = malloc((g->totalVertices + 1) * sizeof(int));
+        if (!nova->nivel || !dissecarGrafo(g, nova->nivel)
+            || !montarTopologiaCordal(g, nova->nivel, &nova->subida, &nova->descida)) {
+            free(nova->nivel);
+            return 0;
+        }
+    }
+
+    CSRAtalhos* subida = &nova->subida;
+    CSRAtalhos* descida = &nova->descida;
+    subida->peso = malloc((subida->total + 1) * sizeof(double));
+    descida->peso = malloc((descida->total + 1) * sizeof(double));
+    subida->meio = malloc((subida->total + 1) * sizeof(int));
+    descida->meio = malloc((descida->total + 1) * sizeof(int));
+    int ok = subida->peso && descida->peso && subida->meio && descida->meio
+          && customizarMetrica(g, nova->nivel, subida, descida);
+    if (!ok) {
+        free(subida->peso); free(descida->peso);
+        free(subida->meio); free(descida->meio);
+        if (!g->ch.cordal) {
+            free(subida->inicio); free(descida->inicio);
+            free(subida->alvo); free(descida->alvo);
+            free(nova->nivel);
+        }
+    }
+    return ok;
+}
+
+// Bytes dos atalhos da hierarquia (alvo, peso e meio da subida e da descida), para CONTAR_BYTES
+#define BYTES_ATALHOS(ch) ((long long)((ch).subida.total + (ch).descida.total) * (long long)(2 * sizeof(int) + sizeof(double)))
+
+// Troca g->ch pela hierarquia de recustomizarHierarquia, liberando os vetores que ela no compartilha
+static void trocarHierarquia(NavGrafo* g, const HierarquiaCH* nova) {
+    CSRAtalhos* antigas[2] = { &g->ch.subida, &g->ch.descida };
+    const CSRAtalhos* novas[2] = { &nova->subida, &nova->descida };
+    if (g->ch.nivel != nova->nivel) free(g->ch.nivel);
+    for (int k = 0; k < 2; k++) {
+        if (antigas[k]->inicio != novas[k]->inicio) free(antigas[k]->inicio);
+        if (antigas[k]->alvo != novas[k]->alvo) free(antigas[k]->alvo);
+        free(antigas[k]->peso);
+        free(antigas[k]->meio);
+    }
+    g->ch = *nova;
+}
+
+// Formato do arquivo .ch (binrio, na ordem de bytes da mquina que o gerou):
+// assinatura "NAVCH02\0", totalVertices, totalArestasDirigidas, assinaturaNumeracao, nivel[totalVertices]
+// e, para a subida e depois para a descida: total, inicio[totalVertices + 1], alvo[total], peso[total], meio[total]
+// Como no .alt, o formato anterior ("NAVCH01\0", sem assinaturaNumeracao) vale na ordem do arquivo
+#define ASSINATURA_CH "NAVCH02"
+#define ASSINATURA_CH_ORDEM_ARQUIVO "NAVCH01"
+
+static int escreverCSRAtalhos(const NavGrafo* g, FILE* f, const CSRAtalhos* csr) {
+    return fwrite(&csr->total, sizeof(int), 1, f) == 1
+        && fwrite(csr->inicio, sizeof(int), g->totalVertices + 1, f) == (size_t)g->totalVertices + 1
+        && fwrite(csr->alvo, sizeof(int), csr->total, f) == (size_t)csr->total
+        && fwrite(csr->peso, sizeof(double), csr->total, f) == (size_t)csr->total
+        && fwrite(csr->meio, sizeof(int), csr->total, f) == (size_t)csr->total;
+}
+
+static int lerCSRAtalhos(const NavGrafo* g, FILE* f, CSRAtalhos* csr) {
+    if (fread(&csr->total, sizeof(int), 1, f) != 1 || csr->total < 0) return 0;
+    csr->inicio = malloc((g->totalVertices + 1) * sizeof(int));
+    csr->alvo = malloc((csr->total + 1) * sizeof(int));
+    csr->peso = malloc((csr->total + 1) * sizeof(double));
+    csr->meio = malloc((csr->total + 1) * sizeof(int));
+    if (!csr->inicio || !csr->alvo || !csr->peso || !csr->meio) return 0;
+    return fread(csr->inicio, sizeof(int), g->totalVertices + 1, f) == (size_t)g->totalVertices + 1
+        && fread(csr->alvo, sizeof(int), csr->total, f) == (size_t)csr->total
+        && fread(csr->peso, sizeof(double), csr->total, f) == (size_t)csr->total
+        && fread(csr->meio, sizeof(int), csr->total, f) == (size_t)csr->total;
+}
+
+// Grava a hierarquia atual em arquivo; retorna 1 se bem sucedido
+static int salvarHierarquia(const NavGrafo* g, const char* nome) {
+    FILE* f = fopen(nome, "wb");
+    if (!f) return 0;
+    char assinatura[8] = ASSINATURA_CH;
+    unsigned long long numeracao = assinaturaNumeracao(g);
+    int ok = fwrite(assinatura, 1, 8, f) == 8
+          && fwrite(&g->totalVertices, sizeof(int), 1, f) == 1
+          && fwrite(&g->totalArestasDirigidas, sizeof(int), 1, f) == 1
+          && fwrite(&numeracao, sizeof(numeracao), 1, f) == 1
+          && fwrite(g->ch.nivel, sizeof(int), g->totalVertices, f) == (size_t)g->totalVertices
+          && escreverCSRAtalhos(g, f, &g->ch.subida)
+          && escreverCSRAtalhos(g, f, &g->ch.descida);
+    fclose(f);
+    return ok;
+}
+
+// L a hierarquia gerada para o grafo carregado; retorna 0 se o arquivo no existir,
+// estiver corrompido ou tiver sido gerado a partir de outro grafo (ou do mesmo em outra ordem de vrtices)
+static int carregarHierarquia(NavGrafo* g, const char* nome) {
+    liberarHierarquia(g);
+    FILE* f = fopen(nome, "rb");
+    if (!f) return 0;
+
+    char assinatura[8];
+    int n, m;
+    unsigned long long numeracao = assinaturaNumeracao(g);
+    int ok = fread(assinatura, 1, 8, f) == 8;
+    int antigo = ok && memcmp(assinatura, ASSINATURA_CH_ORDEM_ARQUIVO, 8) == 0 && g->ordemVertices == ORDEM_ARQUIVO;
+    ok = ok && (antigo || memcmp(assinatura, ASSINATURA_CH, 8) == 0)
+          && fread(&n, sizeof(int), 1, f) == 1 && fread(&m, sizeof(int), 1, f) == 1
+          && (antigo || fread(&numeracao, sizeof(numeracao), 1, f) == 1)
+          && n == g->totalVertices && m == g->totalArestasDirigidas && numeracao == assinaturaNumeracao(g);
+    if (ok) {
+        g->ch.nivel = malloc((g->totalVertices + 1) * sizeof(int));
+        ok = g->ch.nivel && fread(g->ch.nivel, sizeof(int), g->totalVertices, f) == (size_t)g->totalVertices
+          && lerCSRAtalhos(g, f, &g->ch.subida) && lerCSRAtalhos(g, f, &g->ch.descida);
+    }
+    fclose(f);
+
+    if (!ok) {
+        liberarHierarquia(g);
+        return 0;
+    }
+    g->ch.carregada = 1;
+    CONTAR_BYTES(g, 3 * (g->totalVertices + 1) * sizeof(int)
+                    + (g->ch.subida.total + g->ch.descida.total + 2) * (2 * sizeof(int) + sizeof(double)));
+    return 1;
+}
+
+// Busca bidirecional na hierarquia: a direta s usa arestas de subida a partir da origem e a
+// reversa s arestas de descida a partir do destino. Cada sentido para quando sua menor chave
+// alcana o melhor caminho j encontrado; o encontro  o vrtice mais alto do caminho
+// Parmetros e retorno iguais aos de buscaBidirecional(g); o caminho  montado por montarCaminhoCH
+static int buscaCH(const NavGrafo* g, EspacoBusca* eb, int origem, int destino, int* nosExplorados, double* custoFinal) {
+    double* distDireta = eb->dist;
+    double* distReversa = eb->distReversa;
+    int* visitadoDireta = eb->visitado;
+    int* visitadoReversa = eb->visitadoReversa;
+    int* anterior = eb->anterior;            // Aresta usada para chegar (direta)
+    int* meioAnterior = eb->meioAnterior;
+    int* sucessor = eb->sucessor;            // Aresta usada para sair (reversa)
+    int* meioSucessor = eb->meioSucessor;
+    FilaPrioridade* heapDireta = &eb->heap;
+    FilaPrioridade* heapReversa = &eb->heapReversa;
+    *nosExplorados = 0;
+
+    for (int i = 0; i < g->totalVertices; i++) {
+        distDireta[i] = distReversa[i] = NAV_INF;
+        visitadoDireta[i] = visitadoReversa[i] = 0;
+        anterior[i] = sucessor[i] = -1;
+    }
+    distDireta[origem] = 0;
+    distReversa[destino] = 0;
+
+    double melhor = NAV_INF;
+    int encontro = -1;
+    if (origem == destino) {
+        melhor = 0;
+        encontro = origem;
+    }
+
+    esvaziarFila(heapDireta);
+    esvaziarFila(heapReversa);
+    inserirFila(heapDireta, origem, 0);
+    inserirFila(heapReversa, destino, 0);
+
+    while (1) {
+        int ativaDireta = heapDireta->tam > 0 && menorChaveFila(heapDireta) < melhor;
+        int ativaReversa = heapReversa->tam > 0 && menorChaveFila(heapReversa) < melhor;
+        if (!ativaDireta && !ativaReversa) break;
+        int direta = ativaDireta && (!ativaReversa || menorChaveFila(heapDireta) <= menorChaveFila(heapReversa));
+
+        FilaPrioridade* h = direta ? heapDireta : heapReversa;
+        const CSRAtalhos* csr = direta ? &g->ch.subida : &g->ch.descida;
+        double* dist = direta ? distDireta : distReversa;
+        double* distOutra = direta ? distReversa : distDireta;
+        int* visitado = direta ? visitadoDireta : visitadoReversa;
+        int* pai = direta ? anterior : sucessor;
+        int* meioPai = direta ? meioAnterior : meioSucessor;
+
+        int u = extrairMinFila(h);
+        if (visitado[u]) {
+            METRICA(eb->metricas.extracoesObsoletas++);
+            continue;
+        }
+        visitado[u] = 1;
+        (*nosExplorados)++;
+        METRICA(eb->metricas.arestasRelaxadas += csr->inicio[u + 1] - csr->inicio[u]);
+
+        for (int e = csr->inicio[u]; e < csr->inicio[u + 1]; e++) {
+            int v = csr->alvo[e];
+            if (dist[u] + csr->peso[e] < dist[v]) {
+                dist[v] = dist[u] + csr->peso[e];
+                pai[v] = u;
+                meioPai[v] = csr->meio[e];
+                inserirFila(h, v, dist[v]);
+                if (dist[v] + distOutra[v] < melhor) {
+                    melhor = dist[v] + distOutra[v];
+                    encontro = v;
+                }
+            }
+        }
+    }
+
+    *custoFinal = melhor;
+    return encontro;
+}
+
+// Caminho da busca na hierarquia, j desempacotado nos vrtices originais. Escreve em caminho[] e
+// retorna a quantidade de vrtices
+static int montarCaminhoCH(const NavGrafo* g, EspacoBusca* eb, int origem, int encontro, int* caminho) {
+    const int* anterior = eb->anterior;
+    const int* meioAnterior = eb->meioAnterior;
+    const int* sucessor = eb->sucessor;
+    const int* meioSucessor = eb->meioSucessor;
+
+    // Sequncia de arestas da hierarquia: origem .. encontro (de trs para frente) e encontro .. destino
+    int* de = eb->trechos;
+    int* para = eb->trechos + g->totalVertices;
+    int* meios = eb->trechos + 2 * g->totalVertices;
+    int totalTrechos = 0;
+    for (int v = encontro; anterior[v] != -1 && totalTrechos < g->totalVertices; v = anterior[v]) {
+        de[totalTrechos] = anterior[v];
+        para[totalTrechos] = v;
+        meios[totalTrechos++] = meioAnterior[v];
+    }
+    for (int i = 0; i < totalTrechos / 2; i++) {
+        int t;
+        t = de[i]; de[i] = de[totalTrechos - 1 - i]; de[totalTrechos - 1 - i] = t;
+        t = para[i]; para[i] = para[totalTrechos - 1 - i]; para[totalTrechos - 1 - i] = t;
+        t = meios[i]; meios[i] = meios[totalTrechos - 1 - i]; meios[totalTrechos - 1 - i] = t;
+    }
+    for (int v = encontro; sucessor[v] != -1 && totalTrechos < g->totalVertices; v = sucessor[v]) {
+        de[totalTrechos] = v;
+        para[totalTrechos] = sucessor[v];
+        meios[totalTrechos++] = meioSucessor[v];
+    }
+
+    // Desempacota cada trecho com uma pilha explcita: o atalho a -> b via m vira a -> m e m -> b,
+    // onde a -> m est na descida de m (a foi contrado depois) e m -> b na subida de m
+    int* pilhaDe = eb->pilha;
+    int* pilhaPara = eb->pilha + g->totalVertices;
+    int* pilhaMeio = eb->pilha + 2 * g->totalVertices;
+    int tam = 0;
+    caminho[tam++] = origem;
+    for (int t = 0; t < totalTrechos; t++) {
+        int topo = 0;
+        pilhaDe[topo] = de[t]; pilhaPara[topo] = para[t]; pilhaMeio[topo++] = meios[t];
+        while (topo > 0) {
+            topo--;
+            int a = pilhaDe[topo], b = pilhaPara[topo], m = pilhaMeio[topo];
+            if (m == -1) {
+                if (tam < g->totalVertices) caminho[tam++] = b;
+                continue;
+            }
+            if (topo + 2 > g->totalVertices) break;
+            int meioAM = -1, meioMB = -1;
+            for (int e = g->ch.descida.inicio[m]; e < g->ch.descida.inicio[m + 1]; e++)
+                if (g->ch.descida.alvo[e] == a) { meioAM = g->ch.descida.meio[e]; break; }
+            for (int e = g->ch.subida.inicio[m]; e < g->ch.subida.inicio[m + 1]; e++)
+                if (g->ch.subida.alvo[e] == b) { meioMB = g->ch.subida.meio[e]; break; }
+            // Empilha m -> b primeiro para que a -> m seja expandido antes
+            pilhaDe[topo] = m; pilhaPara[topo] = b; pilhaMeio[topo++] = meioMB;
+            pilhaDe[topo] = a; pilhaPara[topo] = m; pilhaMeio[topo++] = meioAM;
+        }
+    }
+    return tam;
+}
+
+// ------------------------ PUBLICAO DOS PESOS ------------------------ //
+// navAtualizarPesos roda ao mesmo tempo que as consultas: ela monta  parte os pesos e a hierarquia
+// novos, em uma cpia rasa do grafo (a vista), e os publica trocando um s ponteiro. Cada consulta usa,
+// do comeo ao fim, a vista que encontrou ao comear. Para saber quando os vetores substitudos podem
+// ser liberados, as consultas se registram em um de dois contadores, escolhido pela paridade da poca:
+// depois de publicar, navAtualizarPesos avana a poca e espera zerar o contador da poca anterior,
+// enquanto as consultas que comeam depois da troca contam no outro. As operaes atmicas so as
+// embutidas do GCC (__atomic_*), que o clang e o MinGW tambm tm. As funes de carga e
+// pr-processamento continuam sem concorrncia com as consultas (nav.h)
+
+// Cede o processador enquanto espera as consultas antigas ou outra atualizao terminarem
+static void cederProcessador(void) {
+#ifdef _WIN32
+    Sleep(0);
+#else
+    sched_yield();
+#endif
+}
+
+// Registra uma consulta e devolve o grafo que ela deve usar: a vista publicada ou, antes da primeira
+// atualizao, o prprio grafo. 'paridade' recebe o contador usado, que vai para sairLeitura
+static const NavGrafo* entrarLeitura(const NavGrafo* g, int* paridade) {
+    PublicacaoPesos* p = g->publicacao;
+    for (;;) {
+        unsigned int epoca = __atomic_load_n(&p->epoca, __ATOMIC_SEQ_CST);
+        __atomic_fetch_add(&p->leitores[epoca & 1], 1, __ATOMIC_SEQ_CST);
+        // Se a poca avanou antes do registro, o contador pode j ter sido conferido: tenta de novo
+        if (__atomic_load_n(&p->epoca, __ATOMIC_SEQ_CST) == epoca) {
+            *paridade = epoca & 1;
+            break;
+        }
+        __atomic_fetch_sub(&p->leitores[epoca & 1], 1, __ATOMIC_SEQ_CST);
+    }
+    const NavGrafo* vista = __atomic_load_n(&p->vista, __ATOMIC_SEQ_CST);
+    return vista ? vista : g;
+}
+
+// Encerra a consulta registrada por entrarLeitura (g pode ser o grafo ou a vista devolvida)
+static void sairLeitura(const NavGrafo* g, int paridade) {
+    __atomic_fetch_sub(&g->publicacao->leitores[paridade], 1, __ATOMIC_SEQ_CST);
+}
+
+// Publica a vista nova e espera terminarem as consultas que podem estar usando a anterior ou os
+// vetores do prprio grafo. Na volta, nenhuma consulta l mais os vetores substitudos
+static void publicarVista(NavGrafo* g, NavGrafo* vista) {
+    PublicacaoPesos* p = g->publicacao;
+    NavGrafo* anterior = p->vista;
+    __atomic_store_n(&p->vista, vista, __ATOMIC_SEQ_CST);
+    unsigned int epoca = __atomic_fetch_add(&p->epoca, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&p->leitores[epoca & 1], __ATOMIC_SEQ_CST) > 0) cederProcessador();
+    free(anterior);
+}
+
+// Descarta a vista, e as consultas voltam a usar o prprio grafo, que tem os mesmos pesos. S nas
+// funes de carga e pr-processamento, que alteram o grafo sem consultas em andamento
+static void descartarVista(NavGrafo* g) {
+    free(g->publicacao->vista);
+    g->publicacao->vista = NULL;
+}
+
+// As atualizaes de pesos so feitas uma por vez
+static void entrarEscrita(NavGrafo* g) {
+    int livre = 0;
+    while (!__atomic_compare_exchange_n(&g->publicacao->escrevendo, &livre, 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+        livre = 0;
+        cederProcessador();
+    }
+}
+
+static void sairEscrita(NavGrafo* g) {
+    __atomic_store_n(&g->publicacao->escrevendo, 0, __ATOMIC_SEQ_CST);
+}
+
+// ------------------------ CONSULTA DE ROTAS ------------------------ //
+// Capacidade de heap necessria para qualquer modo de busca no grafo carregado: as buscas da CH
+// percorrem as arestas de subida/descida (com atalhos), que podem ser mais numerosas que as do grafo
+static int capacidadeHeapConsultas(const NavGrafo* g) {
+    int capacidade = g->totalArestasDirigidas;
+    if (g->ch.carregada && g->ch.subida.total > capacidade) capacidade = g->ch.subida.total;
+    if (g->ch.carregada && g->ch.descida.total > capacidade) capacidade = g->ch.descida.total;
+    return capacidade + 1;
+}
+
+// Troca as duas filas do espao por filas novas do tipo e da capacidade pedidos, mantendo os
+// contadores. As novas so alocadas antes de liberar as antigas: se faltar memria, o espao
+// continua vlido. NAV_OK ou NAV_ERRO_MEMORIA
+static int trocarFilas(EspacoBusca* eb, TipoFila tipo, int capacidade) {
+    FilaPrioridade direta, reversa;
+    int okDireta = alocarFila(&direta, tipo, capacidade, eb->grafo->totalVertices);
+    int okReversa = alocarFila(&reversa, tipo, capacidade, eb->grafo->totalVertices);
+    if (!okDireta || !okReversa) {
+        liberarFila(&direta);
+        liberarFila(&reversa);
+        return NAV_ERRO_MEMORIA;
+    }
+    direta.contadores = eb->heap.contadores;
+    reversa.contadores = eb->heapReversa.contadores;
+    liberarFila(&eb->heap);
+    liberarFila(&eb->heapReversa);
+    eb->heap = direta;
+    eb->heapReversa = reversa;
+    eb->capacidadeFila = capacidade;
+    return NAV_OK;
+}
+
+// Converte um ID original (do arquivo .poly) para o ndice interno no vetor de vrtices
+// Retorna -1 se o ID no pertencer ao grafo carregado
+static int indiceDoId(const NavGrafo* g, NavId id) {
+    return buscarId(&g->idParaIndice, id);
+}
+
+// Caminho das buscas de uma rvore s (Dijkstra e A*): segue anterior[] (o do espao de busca ou o de
+// uma rvore do cache) do destino at a origem e inverte. Escreve em caminho[] e retorna a quantidade de vrtices
+static int montarCaminhoArvore(const int* anterior, int destino, int* caminho) {
+    int tam = 0;
+    for (int v = destino; v != -1; v = anterior[v])
+        caminho[tam++] = v;
+
+    // Inverte para ficar na ordem correta: origem at destino
+    for (int i = 0; i < tam / 2; i++) {
+        int tmp = caminho[i];
+        caminho[i] = caminho[tam - 1 - i];
+        caminho[tam - 1 - i] = tmp;
+    }
+    return tam;
+}
+
+// Executa a busca escolhida entre dois ndices internos e deixa o caminho em eb->caminho (ndices
+// internos, na ordem origem -> destino) e em eb->caminhoIds. Todos os modos de busca passam por
+// aqui; os tempos e contadores da consulta ficam em eb->metricas
+// Retorna NAV_ERRO_PRE_PROCESSAMENTO se o modo depende de um pr-processamento que no foi carregado
+static int executarConsulta(const NavGrafo* g, EspacoBusca* eb, int origem, int destino, ModoBusca modo,
+                            NavResultado* r) {
+    if (modo == BUSCA_CH && !g->ch.carregada) return NAV_ERRO_PRE_PROCESSAMENTO;
+    if (modo == BUSCA_ALT && !g->alt.carregada) return NAV_ERRO_PRE_PROCESSAMENTO;
+    // A hierarquia pode ter ganhado atalhos depois que o espao foi criado (navAtualizarPesos,
+    // navGerarHierarquia ou navCarregarHierarquia): as filas crescem antes da busca
+    int capacidade = capacidadeHeapConsultas(g);
+    if (capacidade > eb->capacidadeFila && trocarFilas(eb, eb->heap.tipo, capacidade) != NAV_OK)
+        return NAV_ERRO_MEMORIA;
+    NavMetricas* m = &eb->metricas;
+    memset(m, 0, sizeof(NavMetricas));
+#ifdef NAV_METRICAS
+    // As filas acumulam os contadores entre consultas; a consulta fica com a diferena
+    NavContadoresFila antes[2] = { eb->heap.contadores, eb->heapReversa.contadores };
+    eb->heap.contadores.maiorTamanho = eb->heapReversa.contadores.maiorTamanho = 0;
+#endif
+
+    double ini = relogio();
+    int encontro = destino;   // Nas buscas bidirecionais, vrtice onde as duas rvores se encontram
+    const int* anterior = eb->anterior;   // Nos modos de uma rvore s, de onde sai o caminho
+    ArvoreCache* arvore;
+    int nova;
+    if (!caminhoPossivel(g, origem, destino)) {
+        // Componentes incompatveis: no h caminho, e nenhuma busca precisa ser feita
+        r->custo = NAV_INF;
+        r->nosExplorados = 0;
+    } else switch (modo) {
+        case BUSCA_CH:
+            encontro = buscaCH(g, eb, origem, destino, &r->nosExplorados, &r->custo);
+            break;
+        case BUSCA_BIDIRECIONAL:
+        case BUSCA_ASTAR_BIDIRECIONAL:
+            encontro = buscaBidirecional(g, eb, origem, destino, modo == BUSCA_ASTAR_BIDIRECIONAL,
+                                         &r->nosExplorados, &r->custo);
+            break;
+        case BUSCA_PARADA:
+        case BUSCA_DIJKSTRA:
+            if (eb->cache.bytesMaximos > 0 && (arvore = arvoreDoCache(g, eb, origem, &nova)) != NULL) {
+                consultarArvore(g, eb, arvore, nova, destino, modo == BUSCA_PARADA, &r->nosExplorados, &r->custo);
+                anterior = arvore->anterior;
+            } else {
+                dijkstra(g, eb, origem, destino, modo == BUSCA_PARADA, &r->nosExplorados, &r->custo);
+            }
+            break;
+        case BUSCA_ASTAR:
+            astar(g, eb, origem, destino, 0, &r->nosExplorados, &r->custo);
+            break;
+        case BUSCA_ALT:
+            astar(g, eb, origem, destino, 1, &r->nosExplorados, &r->custo);
+            break;
+        default:
+            break;
+    }
+    double meio = relogio();
+
+    r->tamCaminho = 0;
+    if (r->custo < NAV_INF) {
+        if (modo == BUSCA_CH)
+            r->tamCaminho = montarCaminhoCH(g, eb, origem, encontro, eb->caminho);
+        else if (modo == BUSCA_BIDIRECIONAL || modo == BUSCA_ASTAR_BIDIRECIONAL)
+            r->tamCaminho = montarCaminhoBidirecional(g, eb, encontro, eb->caminho);
+        else
+            r->tamCaminho = montarCaminhoArvore(anterior, destino, eb->caminho);
+    }
+    // O caminho sai da busca em ndices internos; quem usa a biblioteca s conhece os IDs
+    for (int i = 0; i < r->tamCaminho; i++)
+        eb->caminhoIds[i] = g->vertices[eb->caminho[i]].id;
+    r->caminho = eb->caminhoIds;
+
+    double fim = relogio();
+    m->tempoBusca = meio - ini;
+    m->tempoCaminho = fim - meio;
+    r->tempo = fim - ini;
+#ifdef NAV_METRICAS
+    m->coletadas = 1;
+    for (int lado = 0; lado < 2; lado++) {
+        NavContadoresFila* c = lado == 0 ? &eb->heap.contadores : &eb->heapReversa.contadores;
+        m->insercoes += c->insercoes - antes[lado].insercoes;
+        m->diminuicoes += c->diminuicoes - antes[lado].diminuicoes;
+        m->extracoes += c->extracoes - antes[lado].extracoes;
+        if (c->maiorTamanho > m->maiorFila) m->maiorFila = c->maiorTamanho;
+        if (antes[lado].maiorTamanho > c->maiorTamanho) c->maiorTamanho = antes[lado].maiorTamanho;
+    }
+#endif
+    return NAV_OK;
+}
+
+int navRota(const NavGrafo* g, NavEspaco* e, NavId origemId, NavId destinoId, int modo, NavResultado* r) {
+    if (modo < 0 || modo >= TOTAL_MODOS_BUSCA) return NAV_ERRO_MODO;
+    if (e->grafo != g) return NAV_ERRO_ESPACO;
+    int origem = indiceDoId(g, origemId);
+    int destino = indiceDoId(g, destinoId);
+    if (origem == -1 || destino == -1) return NAV_ERRO_ID;
+    r->caminho = e->caminhoIds;
+    int paridade;
+    const NavGrafo* vista = entrarLeitura(g, &paridade);
+    int status = executarConsulta(vista, e, origem, destino, modo, r);
+    sairLeitura(g, paridade);
+    return status;
+}
+
+NavEspaco* navCriarEspaco(const NavGrafo* g) {
+    NavEspaco* e = malloc(sizeof(NavEspaco));
+    if (!e) return NULL;
+    int paridade;
+    int capacidade = capacidadeHeapConsultas(entrarLeitura(g, &paridade));
+    sairLeitura(g, paridade);
+    if (!alocarEspacoBusca(g, e, capacidade, FILA_PADRAO)) {
+        free(e);
+        return NULL;
+    }
+    return e;
+}
+
+void navLiberarEspaco(NavEspaco* e) {
+    if (!e) return;
+    liberarEspacoBusca(e);
+    free(e);
+}
+
+int navDefinirFila(NavEspaco* e, int tipo) {
+    if (tipo < 0 || tipo >= TOTAL_TIPOS_FILA) return NAV_ERRO_MODO;
+    if ((int)e->heap.tipo == tipo) return NAV_OK;
+    int paridade;
+    int capacidade = capacidadeHeapConsultas(entrarLeitura(e->grafo, &paridade));
+    sairLeitura(e->grafo, paridade);
+    return trocarFilas(e, tipo, capacidade > e->capacidadeFila ? capacidade : e->capacidadeFila);
+}
+
+void navContadoresFila(const NavEspaco* e, NavContadoresFila* c) {
+    const NavContadoresFila* d = &e->heap.contadores;
+    const NavContadoresFila* r = &e->heapReversa.contadores;
+    c->insercoes = d->insercoes + r->insercoes;
+    c->diminuicoes = d->diminuicoes + r->diminuicoes;
+    c->extracoes = d->extracoes + r->extracoes;
+    c->maiorTamanho = d->maiorTamanho > r->maiorTamanho ? d->maiorTamanho : r->maiorTamanho;
+}
+
+void navZerarContadoresFila(NavEspaco* e) {
+    memset(&e->heap.contadores, 0, sizeof(NavContadoresFila));
+    memset(&e->heapReversa.contadores, 0, sizeof(NavContadoresFila));
+}
+
+int navDefinirCache(NavEspaco* e, long long bytesMaximos) {
+    CacheArvores* c = &e->cache;
+    int n = e->grafo->totalVertices;
+    if (bytesMaximos <= 0) {
+        while (c->ultima) removerArvoreCache(c, c->ultima, n);
+        free(c->daOrigem);
+        c->daOrigem = NULL;
+        c->bytesMaximos = 0;
+        return NAV_OK;
+    }
+    if (!c->daOrigem && !(c->daOrigem = calloc(n + 1, sizeof(ArvoreCache*)))) return NAV_ERRO_MEMORIA;
+    c->bytesMaximos = bytesMaximos;
+    while (c->ultima && c->contadores.bytes > bytesMaximos) {
+        removerArvoreCache(c, c->ultima, n);
+        c->contadores.descartes++;
+    }
+    return NAV_OK;
+}
+
+void navContadoresCache(const NavEspaco* e, NavContadoresCache* c) {
+    *c = e->cache.contadores;
+}
+
+void navMetricas(const NavEspaco* e, NavMetricas* m) {
+    *m = e->metricas;
+    m->bytesEspaco = e->bytesVetores + e->heap.bytes + e->heapReversa.bytes;
+}
+
+int navModoDoNome(const char* nome) {
+    for (int m = 0; m < TOTAL_MODOS_BUSCA; m++)
+        if (strcmp(nome, nomesModoBusca[m]) == 0) return m;
+    return -1;
+}
+
+const char* navNomeModo(int modo) {
+    return (modo >= 0 && modo < TOTAL_MODOS_BUSCA) ? nomesModoBusca[modo] : NULL;
+}
+
+int navTipoFilaDoNome(const char* nome) {
+    for (int t = 0; t < TOTAL_TIPOS_FILA; t++)
+        if (strcmp(nome, nomesTipoFila[t]) == 0) return t;
+    return -1;
+}
+
+const char* navNomeTipoFila(int tipo) {
+    return (tipo >= 0 && tipo < TOTAL_TIPOS_FILA) ? nomesTipoFila[tipo] : NULL;
+}
+
+int navOrdemDoNome(const char* nome) {
+    for (int o = 0; o < TOTAL_ORDENS_VERTICES; o++)
+        if (strcmp(nome, nomesOrdem[o]) == 0) return o;
+    return -1;
+}
+
+const char* navNomeOrdem(int ordem) {
+    return (ordem >= 0 && ordem < TOTAL_ORDENS_VERTICES) ? nomesOrdem[ordem] : NULL;
+}
+
+double navRelogio(void) {
+    return relogio();
+}
+
+// ------------------------ MATRIZ DE DISTNCIAS ------------------------ //
+// Matriz origens x destinos calculada com uma busca um-para-muitos por origem
+void navLiberarMatriz(NavMatriz* md) {
+    if (md->caminhos) {
+        for (long c = 0; c < (long)md->totalOrigens * md->totalDestinos; c++)
+            free(md->caminhos[c]);
+    }
+    free(md->caminhos);
+    free(md->tamCaminhos);
+    free(md->custos);
+    memset(md, 0, sizeof(NavMatriz));
+}
+
+// Calcula a matriz entre os ndices internos de origens e destinos; comCaminhos tambm guarda os
+// caminhos (em IDs originais). As origens so distribudas entre as threads (OpenMP), cada uma
+// com o seu espao de busca. Retorna 1 se bem sucedido, 0 se faltar memria
+static int calcularMatriz(const NavGrafo* g, const int* origens, int totalOrigens, const int* destinos,
+                          int totalDestinos, int comCaminhos, NavMatriz* md) {
+    memset(md, 0, sizeof(NavMatriz));
+    md->totalOrigens = totalOrigens;
+    md->totalDestinos = totalDestinos;
+    long celulas = (long)totalOrigens * totalDestinos;
+    md->custos = malloc((celulas + 1) * sizeof(double));
+    if (comCaminhos) {
+        md->caminhos = calloc(celulas + 1, sizeof(int*));
+        md->tamCaminhos = calloc(celulas + 1, sizeof(int));
+    }
+    if (!md->custos || (comCaminhos && (!md->caminhos || !md->tamCaminhos))) {
+        navLiberarMatriz(md);
+        return 0;
+    }
+
+    int threads = 1;
+#ifdef _OPENMP
+    threads = omp_get_max_threads();
+#endif
+    if (threads > totalOrigens) threads = totalOrigens;
+    if (threads < 1) threads = 1;
+    md->threads = threads;
+
+    EspacoBusca* espacos = calloc(threads, sizeof(EspacoBusca));
+    int ok = espacos != NULL;
+    for (int t = 0; ok && t < threads; t++)
+        ok = alocarEspacoBusca(g, &espacos[t], g->totalArestasDirigidas + 1, FILA_PADRAO);
+    if (!ok) {
+        for (int t = 0; espacos && t < threads; t++) liberarEspacoBusca(&espacos[t]);
+        free(espacos);
+        navLiberarMatriz(md);
+        return 0;
+    }
+
+    int faltouMemoria = 0;
+    long nos = 0;
+    double ini = relogio();
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic) num_threads(threads) reduction(+:nos)
+#endif
+    for (int i = 0; i < totalOrigens; i++) {
+        int t = 0;
+#ifdef _OPENMP
+        t = omp_get_thread_num();
+#endif
+        EspacoBusca* eb = &espacos[t];
+        double* linha = md->custos + (long)i * totalDestinos;
+        nos += dijkstraUmParaMuitos(g, eb, origens[i], destinos, totalDestinos, linha);
+        if (!comCaminhos) continue;
+
+        // Reconstri o caminho at cada destino pela rvore de predecessores desta origem
+        for (int j = 0; j < totalDestinos; j++) {
+            if (linha[j] >= NAV_INF) continue;
+            int tam = 0;
+            for (int v = destinos[j]; v != -1; v = eb->anterior[v]) tam++;
+            NavId* caminho = malloc(tam * sizeof(NavId));
+            if (!caminho) {
+#ifdef _OPENMP
+                #pragma omp atomic write
+#endif
+                faltouMemoria = 1;
+                continue;
+            }
+            int k = tam;
+            for (int v = destinos[j]; v != -1; v = eb->anterior[v]) caminho[--k] = g->vertices[v].id;
+            md->caminhos[(long)i * totalDestinos + j] = caminho;
+            md->tamCaminhos[(long)i * totalDestinos + j] = tam;
+        }
+    }
+    md->tempo = relogio() - ini;
+    md->nosExplorados = nos;
+
+    for (int t = 0; t < threads; t++) liberarEspacoBusca(&espacos[t]);
+    free(espacos);
+    if (faltouMemoria) {
+        navLiberarMatriz(md);
+        return 0;
+    }
+    return 1;
+}
+
+int navMatriz(const NavGrafo* g, const NavId* origensIds, int totalOrigens, const NavId* destinosIds,
+              int totalDestinos, int comCaminhos, NavMatriz* md) {
+    memset(md, 0, sizeof(NavMatriz));
+    int* origens = malloc((totalOrigens + 1) * sizeof(int));
+    int* destinos = malloc((totalDestinos + 1) * sizeof(int));
+    int status = (origens && destinos) ? NAV_OK : NAV_ERRO_MEMORIA;
+    for (int i = 0; status == NAV_OK && i < totalOrigens; i++)
+        if ((origens[i] = indiceDoId(g, origensIds[i])) == -1) status = NAV_ERRO_ID;
+    for (int j = 0; status == NAV_OK && j < totalDestinos; j++)
+        if ((destinos[j] = indiceDoId(g, destinosIds[j])) == -1) status = NAV_ERRO_ID;
+    if (status == NAV_OK) {
+        int paridade;
+        const NavGrafo* vista = entrarLeitura(g, &paridade);
+        if (!calcularMatriz(vista, origens, totalOrigens, destinos, totalDestinos, comCaminhos, md))
+            status = NAV_ERRO_MEMORIA;
+        sairLeitura(g, paridade);
+    }
+    free(origens);
+    free(destinos);
+    return status;
+}
+
+// ------------------------ RVORE DE CAMINHOS MNIMOS E ISCRONA ------------------------ //
+// "Tudo o que est a at D do depsito" com uma s busca: o Dijkstra limitado devolve os vrtices
+// alcanados com custo e predecessor, e o contorno da iscrona  o fecho convexo desses vrtices
+// mais os pontos, ao longo das arestas que saem da regio, onde o limite se esgota
+
+void navLiberarArvore(NavArvore* a) {
+    free(a->ids);
+    free(a->custos);
+    free(a->anterior);
+    free(a->contornoX);
+    free(a->contornoY);
+    memset(a, 0, sizeof(NavArvore));
+}
+
+// Ordena pontos por x e, no empate, por y (qsort do fecho convexo)
+static int compararPontos(const void* a, const void* b) {
+    const double* p = a;
+    const double* q = b;
+    if (p[0] != q[0]) return p[0] < q[0] ? -1 : 1;
+    if (p[1] != q[1]) return p[1] < q[1] ? -1 : 1;
+    return 0;
+}
+
+// Produto vetorial (a - o) x (b - o): positivo se o -> a -> b faz uma curva  esquerda
+static double giro(const double* o, const double* a, const double* b) {
+    return (a[0] - o[0]) * (b[1] - o[1]) - (a[1] - o[1]) * (b[0] - o[0]);
+}
+
+// Fecho convexo pela cadeia montona de Andrew. 'pontos' tem 'total' pares (x, y) e  reordenado;
+// o fecho, no sentido anti-horrio e sem repetir o primeiro ponto,  escrito em 'fecho' (at
+// total + 1 pares). Retorna a quantidade de pontos do fecho
+static int fechoConvexo(double* pontos, int total, double* fecho) {
+    if (total <= 0) return 0;
+    qsort(pontos, total, 2 * sizeof(double), compararPontos);
+    int k = 0;
+    // Cadeia inferior, da esquerda para a direita, e depois a superior, de volta
+    for (int i = 0; i < total; i++) {
+        while (k >= 2 && giro(&fecho[2 * (k - 2)], &fecho[2 * (k - 1)], &pontos[2 * i]) <= 0) k--;
+        fecho[2 * k] = pontos[2 * i];
+        fecho[2 * k + 1] = pontos[2 * i + 1];
+        k++;
+    }
+    for (int i = total - 2, inferior = k + 1; i >= 0; i--) {
+        while (k >= inferior && giro(&fecho[2 * (k - 2)], &fecho[2 * (k - 1)], &pontos[2 * i]) <= 0) k--;
+        fecho[2 * k] = pontos[2 * i];
+        fecho[2 * k + 1] = pontos[2 * i + 1];
+        k++;
+    }
+    return total == 1 ? 1 : k - 1;
+}
+
+// Contorno da iscrona a partir da rvore que est em eb (veja dijkstraLimitado). Retorna 1 se bem
+// sucedido, 0 se faltar memria
+static int contornoIsocrona(const NavGrafo* g, const EspacoBusca* eb, int fechados, double limite, NavArvore* a) {
+    int candidatos = fechados;
+    for (int i = 0; i < fechados; i++) {
+        int u = eb->caminho[i];
+        candidatos += g->inicioAresta[u + 1] - g->inicioAresta[u];
+    }
+    double* pontos = malloc((2 * (long)candidatos + 2) * sizeof(double));
+    double* fecho = malloc((2 * (long)candidatos + 4) * sizeof(double));
+    if (!pontos || !fecho) {
+        free(pontos);
+        free(fecho);
+        return 0;
+    }
+    int total = 0;
+    for (int i = 0; i < fechados; i++) {
+        int u = eb->caminho[i];
+        const Vertice* pu = &g->vertices[u];
+        pontos[2 * total] = pu->x;
+        pontos[2 * total + 1] = pu->y;
+        total++;
+        // Aresta que passa do limite: a regio alcanvel vai at a frao da aresta que ainda cabe
+        for (int e = g->inicioAresta[u]; e < g->inicioAresta[u + 1]; e++) {
+            double sobra = limite - eb->dist[u];
+            if (g->pesoAresta[e] <= sobra || g->pesoAresta[e] <= 0) continue;
+            const Vertice* pv = &g->vertices[g->destinoAresta[e]];
+            double t = sobra / g->pesoAresta[e];
+            pontos[2 * total] = pu->x + t * (pv->x - pu->x);
+            pontos[2 * total + 1] = pu->y + t * (pv->y - pu->y);
+            total++;
+        }
+    }
+    int k = fechoConvexo(pontos, total, fecho);
+    a->contornoX = malloc((k + 1) * sizeof(double));
+    a->contornoY = malloc((k + 1) * sizeof(double));
+    int ok = a->contornoX && a->contornoY;
+    for (int i = 0; ok && i < k; i++) {
+        a->contornoX[i] = fecho[2 * i];
+        a->contornoY[i] = fecho[2 * i + 1];
+    }
+    a->totalContorno = ok ? k : 0;
+    free(pontos);
+    free(fecho);
+    return ok;
+}
+
+// Corpo de navArvore, com o grafo da consulta (veja entrarLeitura) e a origem j validada
+static int calcularArvore(const NavGrafo* g, NavEspaco* e, int origem, double limite, int comContorno, NavArvore* a) {
+    double ini = relogio();
+    int fechados = dijkstraLimitado(g, e, origem, limite);
+    a->limite = limite;
+    a->total = fechados;
+    a->nosExplorados = fechados;
+    a->ids = malloc((fechados + 1) * sizeof(NavId));
+    a->custos = malloc((fechados + 1) * sizeof(double));
+    a->anterior = malloc((fechados + 1) * sizeof(int));
+    if (!a->ids || !a->custos || !a->anterior) {
+        navLiberarArvore(a);
+        return NAV_ERRO_MEMORIA;
+    }
+    // eb->visitado deixa de ser necessrio: passa a guardar a posio de cada vrtice na lista
+    for (int i = 0; i < fechados; i++) e->visitado[e->caminho[i]] = i;
+    for (int i = 0; i < fechados; i++) {
+        int v = e->caminho[i];
+        a->ids[i] = g->vertices[v].id;
+        a->custos[i] = e->dist[v];
+        a->anterior[i] = e->anterior[v] == -1 ? -1 : e->visitado[e->anterior[v]];
+    }
+    if (comContorno && !contornoIsocrona(g, e, fechados, limite, a)) {
+        navLiberarArvore(a);
+        return NAV_ERRO_MEMORIA;
+    }
+    a->tempo = relogio() - ini;
+    return NAV_OK;
+}
+
+int navArvore(const NavGrafo* g, NavEspaco* e, NavId origemId, double limite, int comContorno, NavArvore* a) {
+    memset(a, 0, sizeof(NavArvore));
+    if (e->grafo != g) return NAV_ERRO_ESPACO;
+    int origem = indiceDoId(g, origemId);
+    if (origem == -1) return NAV_ERRO_ID;
+    if (!(limite >= 0)) return NAV_ERRO_PARAMETRO;
+    int paridade;
+    const NavGrafo* vista = entrarLeitura(g, &paridade);
+    int status = calcularArvore(vista, e, origem, limite, comContorno, a);
+    sairLeitura(g, paridade);
+    return status;
+}
+
+// Formato do arquivo da rvore (navSalvarArvore), compacto para ser lido por outros programas:
+//   char[8] "NAVARV1", int verso, int total, int totalContorno, int reservado, double limite,
+//   NavId ids[total], double custos[total], double contorno[2 * totalContorno] (pares x, y),
+//   int anterior[total]
+// Os nmeros ficam na representao da mquina que gravou, como no .navg
+#define ASSINATURA_ARVORE "NAVARV1"
+#define VERSAO_ARVORE 1
+
+int navSalvarArvore(const NavArvore* a, const char* arquivo) {
+    FILE* f = fopen(arquivo, "wb");
+    if (!f) return 0;
+    int cabecalho[4] = { VERSAO_ARVORE, a->total, a->totalContorno, 0 };
+    int ok = fwrite(ASSINATURA_ARVORE, 1, 8, f) == 8 && fwrite(cabecalho, sizeof(int), 4, f) == 4
+          && fwrite(&a->limite, sizeof(double), 1, f) == 1
+          && fwrite(a->ids, sizeof(NavId), a->total, f) == (size_t)a->total
+          && fwrite(a->custos, sizeof(double), a->total, f) == (size_t)a->total;
+    for (int i = 0; ok && i < a->totalContorno; i++) {
+        double ponto[2] = { a->contornoX[i], a->contornoY[i] };
+        ok = fwrite(ponto, sizeof(double), 2, f) == 2;
+    }
+    ok = ok && fwrite(a->anterior, sizeof(int), a->total, f) == (size_t)a->total;
+    if (fclose(f) != 0) ok = 0;
+    return ok;
+}
+
+// ------------------------ ROTAS ALTERNATIVAS ------------------------ //
+// Alternativas por plats (choice routing): uma busca a partir da origem e outra, no grafo reverso, a
+// partir do destino, ambas at esticamento * d(origem, destino), do as duas rvores de caminhos
+// mnimos. Um plat  um trecho cujas arestas esto nas duas rvores; o plat que comea no vrtice v
+// d a rota origem -> v pela rvore direta e v -> destino pela reversa, que percorre o plat inteiro.
+// Um plat longo indica uma rota que  a melhor possvel por um trecho grande, ento os candidatos
+// so tentados do maior plat para o menor. Um candidato  aceito se no repete vrtices e se no
+// mximo 'sobreposicaoMaxima' do seu custo passa por arestas das rotas j aceitas. Tudo sai das duas
+// buscas: nenhum Dijkstra  repetido com arestas removidas, como no algoritmo de Yen
+
+typedef struct {
+    int inicio;            // Primeiro vrtice do plat (o vrtice de passagem da rota)
+    double comprimento;    // Custo do trecho do plat
+} PlatoAlternativa;
+
+// Ordena os plats do mais longo para o mais curto (pelo vrtice, no empate, para no depender do qsort)
+static int compararPlatos(const void* a, const void* b) {
+    const PlatoAlternativa* p = (const PlatoAlternativa*)a;
+    const PlatoAlternativa* q = (const PlatoAlternativa*)b;
+    if (p->comprimento != q->comprimento) return p->comprimento > q->comprimento ? -1 : 1;
+    return p->inicio - q->inicio;
+}
+
+// Dijkstra das alternativas: no grafo direto a partir da origem (reverso == 0; preenche dist, visitado
+// e anterior) ou no reverso a partir do destino (reverso == 1; distReversa, visitadoReversa e sucessor).
+// Fecha os vrtices at a menor chave passar de *limite; com alvo != -1, *limite passa a ser
+// esticamento * dist[alvo] quando o alvo  fechado. Retorna a quantidade de vrtices fechados
+static int arvoreAlternativas(const NavGrafo* g, EspacoBusca* eb, int raiz, int reverso, int alvo,
+                              double esticamento, double* limite) {
+    const int* inicio = reverso ? g->inicioArestaReversa : g->inicioAresta;
+    const int* vizinho = reverso ? g->origemArestaReversa : g->destinoAresta;
+    const double* peso = reverso ? g->pesoArestaReversa : g->pesoAresta;
+    double* dist = reverso ? eb->distReversa : eb->dist;
+    int* visitado = reverso ? eb->visitadoReversa : eb->visitado;
+    int* pai = reverso ? eb->sucessor : eb->anterior;
+    FilaPrioridade* fila = reverso ? &eb->heapReversa : &eb->heap;
+    int fechados = 0;
+
+    for (int i = 0; i < g->totalVertices; i++) {
+        dist[i] = NAV_INF;
+        visitado[i] = 0;
+        pai[i] = -1;
+    }
+    dist[raiz] = 0;
+    esvaziarFila(fila);
+    inserirFila(fila, raiz, 0);
+    while (fila->tam > 0) {
+        int u = extrairMinFila(fila);
+        if (visitado[u]) continue;
+        if (dist[u] > *limite) break;
+        visitado[u] = 1;
+        fechados++;
+        if (u == alvo) *limite = esticamento * dist[u];
+
+        for (int e = inicio[u]; e < inicio[u + 1]; e++) {
+            int v = vizinho[e];
+            double d = dist[u] + peso[e];
+            if (!visitado[v] && d <= *limite && d < dist[v]) {
+                dist[v] = d;
+                pai[v] = u;
+                inserirFila(fila, v, d);
+            }
+        }
+    }
+    return fechados;
+}
+
+// Monta em eb->caminho a rota origem -> via (rvore direta) -> destino (rvore reversa). marca[] 
+// carimbada com 'carimbo' nos vrtices da rota para achar repeties. Retorna o tamanho da rota, ou 0
+// se ela passa duas vezes pelo mesmo vrtice
+static int montarRotaAlternativa(const EspacoBusca* eb, int via, int* marca, int carimbo) {
+    int tam = montarCaminhoArvore(eb->anterior, via, eb->caminho);
+    for (int i = 0; i < tam; i++) marca[eb->caminho[i]] = carimbo;
+    for (int w = eb->sucessor[via]; w != -1; w = eb->sucessor[w]) {
+        if (marca[w] == carimbo) return 0;
+        marca[w] = carimbo;
+        eb->caminho[tam++] = w;
+    }
+    return tam;
+}
+
+// Soma o custo das arestas do caminho que tm o bit dado em usadas[] (marcas por aresta dirigida do
+// CSR). *novas recebe quantas arestas do caminho no o tm; com marcar, o bit  ligado em todas
+static double custoCompartilhado(const NavGrafo* g, const int* caminho, int tam, unsigned char* usadas,
+                                 unsigned char bit, int marcar, int* novas) {
+    double compartilhado = 0;
+    *novas = 0;
+    for (int i = 0; i + 1 < tam; i++) {
+        int e = menorAresta(g, caminho[i], caminho[i + 1]);
+        if (usadas[e] & bit) compartilhado += g->pesoAresta[e];
+        else (*novas)++;
+        if (marcar) usadas[e] |= bit;
+    }
+    return compartilhado;
+}
+
+void navLiberarAlternativas(NavAlternativas* a) {
+    free(a->custos);
+    free(a->sobreposicao);
+    free(a->inicio);
+    free(a->ids);
+    memset(a, 0, sizeof(NavAlternativas));
+}
+
+// Corpo de navAlternativas, com o grafo da consulta (veja entrarLeitura) e os parmetros j validados
+static int calcularAlternativas(const NavGrafo* g, NavEspaco* e, int origem, int destino, int k,
+                                double sobreposicaoMaxima, double esticamento, NavAlternativas* a) {
+    double ini = relogio();
+    double limite = NAV_INF;
+    if (caminhoPossivel(g, origem, destino))
+        a->nosExplorados = arvoreAlternativas(g, e, origem, 0, destino, esticamento, &limite);
+    if (a->nosExplorados == 0 || !e->visitado[destino]) {
+        a->tempo = relogio() - ini;
+        return NAV_OK;   // Sem caminho: nenhuma rota
+    }
+    a->nosExplorados += arvoreAlternativas(g, e, destino, 1, -1, esticamento, &limite);
+
+    // Plats: comeam nos vrtices fechados pelas duas buscas, dentro do limite, cuja aresta de
+    // chegada na rvore direta no est na reversa; seguem pela rvore reversa enquanto as arestas
+    // tambm esto na direta
+    int totalPlatos = 0;
+    for (int v = 0; v < g->totalVertices; v++)
+        if (e->visitado[v] && e->visitadoReversa[v]) totalPlatos++;
+    PlatoAlternativa* platos = malloc((totalPlatos + 1) * sizeof(PlatoAlternativa));
+    unsigned char* usadas = calloc(g->totalArestasDirigidas + 1, 1);
+    int* escolhidas = malloc((k + 1) * sizeof(int));
+    int* marca = e->meioAnterior;   // S usado pelo modo ch: serve de carimbo dos vrtices das rotas
+    if (!platos || !usadas || !escolhidas) {
+        free(platos); free(usadas); free(escolhidas);
+        return NAV_ERRO_MEMORIA;
+    }
+    totalPlatos = 0;
+    for (int v = 0; v < g->totalVertices; v++) {
+        marca[v] = 0;
+        if (!e->visitado[v] || !e->visitadoReversa[v] || e->dist[v] + e->distReversa[v] > limite) continue;
+        int p = e->anterior[v];
+        if (p != -1 && e->visitadoReversa[p] && e->sucessor[p] == v) continue;   // v est no meio de um plat
+        int w = v;
+        while (e->sucessor[w] != -1 && e->visitado[e->sucessor[w]] && e->anterior[e->sucessor[w]] == w)
+            w = e->sucessor[w];
+        if (e->dist[w] > e->dist[v]) {
+            platos[totalPlatos].inicio = v;
+            platos[totalPlatos++].comprimento = e->dist[w] - e->dist[v];
+        }
+    }
+    qsort(platos, totalPlatos, sizeof(PlatoAlternativa), compararPlatos);
+
+    // A primeira rota  a de menor custo (via == destino), mesmo que empates a dividam em vrios plats
+    int total = 1, novas;
+    escolhidas[0] = destino;
+    int tam = montarRotaAlternativa(e, destino, marca, 1);
+    custoCompartilhado(g, e->caminho, tam, usadas, 1, 1, &novas);
+    for (int i = 0; i < totalPlatos && total < k; i++) {
+        int v = platos[i].inicio;
+        double custo = e->dist[v] + e->distReversa[v];
+        tam = montarRotaAlternativa(e, v, marca, i + 2);
+        if (tam == 0) continue;
+        double compartilhado = custoCompartilhado(g, e->caminho, tam, usadas, 1, 0, &novas);
+        if (novas == 0 || compartilhado > sobreposicaoMaxima * custo) continue;
+        custoCompartilhado(g, e->caminho, tam, usadas, 1, 1, &novas);
+        escolhidas[total++] = v;
+    }
+    free(platos);
+
+    // As alternativas saem em ordem de custo; a sobreposio de cada uma  medida contra a primeira
+    for (int i = 2; i < total; i++) {
+        int v = escolhidas[i], j = i;
+        for (; j > 1 && e->dist[escolhidas[j - 1]] + e->distReversa[escolhidas[j - 1]] > e->dist[v] + e->distReversa[v]; j--)
+            escolhidas[j] = escolhidas[j - 1];
+        escolhidas[j] = v;
+    }
+    a->custos = malloc(total * sizeof(double));
+    a->sobreposicao = malloc(total * sizeof(double));
+    a->inicio = malloc((total + 1) * sizeof(int));
+    int ok = a->custos && a->sobreposicao && a->inicio;
+    int capacidade = 0;
+    if (ok) a->inicio[0] = 0;
+    for (int i = 0; ok && i < total; i++) {
+        int v = escolhidas[i];
+        tam = montarRotaAlternativa(e, v, marca, -(i + 1));
+        if (a->inicio[i] + tam > capacidade) {
+            capacidade = 2 * (a->inicio[i] + tam);
+            NavId* ids = realloc(a->ids, capacidade * sizeof(NavId));
+            if (!ids) { ok = 0; break; }
+            a->ids = ids;
+        }
+        for (int j = 0; j < tam; j++) a->ids[a->inicio[i] + j] = g->vertices[e->caminho[j]].id;
+        a->inicio[i + 1] = a->inicio[i] + tam;
+        a->custos[i] = e->dist[v] + e->distReversa[v];
+        double compartilhado = custoCompartilhado(g, e->caminho, tam, usadas, 2, i == 0, &novas);
+        a->sobreposicao[i] = i == 0 || a->custos[i] <= 0 ? 1 : compartilhado / a->custos[i];
+    }
+    free(usadas);
+    free(escolhidas);
+    if (!ok) {
+        navLiberarAlternativas(a);
+        return NAV_ERRO_MEMORIA;
+    }
+    a->total = total;
+    a->tempo = relogio() - ini;
+    return NAV_OK;
+}
+
+int navAlternativas(const NavGrafo* g, NavEspaco* e, NavId origemId, NavId destinoId, int k,
+                    double sobreposicaoMaxima, double esticamento, NavAlternativas* a) {
+    memset(a, 0, sizeof(NavAlternativas));
+    if (e->grafo != g) return NAV_ERRO_ESPACO;
+    int origem = indiceDoId(g, origemId), destino = indiceDoId(g, destinoId);
+    if (origem == -1 || destino == -1) return NAV_ERRO_ID;
+    if (k < 1 || !(sobreposicaoMaxima >= 0 && sobreposicaoMaxima <= 1) || !(esticamento >= 1)) return NAV_ERRO_PARAMETRO;
+    int paridade;
+    const NavGrafo* vista = entrarLeitura(g, &paridade);
+    int status = calcularAlternativas(vista, e, origem, destino, k, sobreposicaoMaxima, esticamento, a);
+    sairLeitura(g, paridade);
+    return status;
+}
+
+// ------------------------ PESOS DINMICOS ------------------------ //
+// Trnsito e interdies sem recarregar o mapa: o peso de cada aresta do .poly vira o peso original
+// (comprimento / velocidade) vezes um fator >= 1, nos dois sentidos da via e nas duas cpias de cada
+// aresta dirigida (CSR direto e reverso). Como os pesos s crescem em relao aos originais, a
+// heurstica Euclidiana (com g->fatorHeuristica) e os landmarks do .alt continuam limites inferiores
+// vlidos; a hierarquia do modo ch depende dos pesos exatos e tem os pesos recalculados sobre uma
+// topologia fixa (recustomizarHierarquia). Nada  escrito no lugar: os pesos e a hierarquia novos so
+// montados em vetores novos e publicados de uma vez para as consultas (veja PUBLICAO DOS PESOS).
+// Uma aresta interditada fica com peso NAV_INF, que nenhuma busca relaxa (dist + NAV_INF nunca  menor
+// que o NAV_INF inicial). No .navg, os pesos mapeados deixam de ser usados na primeira alterao
+
+// Peso da aresta i do .poly com o fator dado (NAV_INF se o fator interdita a aresta)
+static double pesoComFator(const NavGrafo* g, int i, double fator) {
+    double peso = g->pesoOriginal[i] * fator;
+    return fator >= NAV_INF || peso >= NAV_INF ? NAV_INF : peso;
+}
+
+// Grava o peso nas posies da aresta i do .poly nos CSRs direto e reverso
+static void definirPesoAresta(NavGrafo* g, int i, double peso) {
+    for (int k = 0; k < 2; k++) {
+        int e = g->dirigidaDaAresta[2 * i + k];
+        if (e == -1) continue;
+        g->pesoAresta[e] = peso;
+        g->pesoArestaReversa[g->reversaDaDirigida[e]] = peso;
+    }
+}
+
+// Monta a vista com os pesos do lote (ndices j validados) e a hierarquia recustomizada, publica e,
+// quando nenhuma consulta usa mais os vetores antigos, passa os novos para o prprio grafo
+// NAV_OK ou NAV_ERRO_MEMORIA (nesse caso nada muda)
+static int publicarPesos(NavGrafo* g, const int* indices, const double* fatores, int total) {
+    size_t bytes = ((size_t)g->totalArestasDirigidas + 1) * sizeof(double);
+    NavGrafo* vista = malloc(sizeof(NavGrafo));
+    double* direto = malloc(bytes);
+    double* reverso = malloc(bytes);
+    if (!vista || !direto || !reverso) {
+        free(vista); free(direto); free(reverso);
+        return NAV_ERRO_MEMORIA;
+    }
+    *vista = *g;
+    memcpy(direto, g->pesoAresta, (size_t)g->totalArestasDirigidas * sizeof(double));
+    memcpy(reverso, g->pesoArestaReversa, (size_t)g->totalArestasDirigidas * sizeof(double));
+    vista->pesoAresta = direto;
+    vista->pesoArestaReversa = reverso;
+    // Na ordem do lote, para que o ltimo fator de um ID repetido prevalea
+    for (int j = 0; j < total; j++) definirPesoAresta(vista, indices[j], pesoComFator(g, indices[j], fatores[j]));
+    HierarquiaCH ch;
+    if (g->ch.carregada) {
+        if (!recustomizarHierarquia(vista, &ch)) {
+            free(vista); free(direto); free(reverso);
+            return NAV_ERRO_MEMORIA;
+        }
+        vista->ch = ch;
+        CONTAR_BYTES(vista, BYTES_ATALHOS(ch) - BYTES_ATALHOS(g->ch));
+    }
+    if (g->mapeamento && !g->pesosCopiados) {
+        vista->pesosCopiados = 1;
+        CONTAR_BYTES(vista, 2 * bytes);
+    }
+    vista->pesosAlterados = 1;
+    vista->versao++;   // Invalida as rvores dos caches dos espaos de busca
+
+    publicarVista(g, vista);
+    if (!g->mapeamento || g->pesosCopiados) {
+        free(g->pesoAresta);
+        free(g->pesoArestaReversa);
+    }
+    if (g->ch.carregada) trocarHierarquia(g, &ch);
+    g->pesoAresta = vista->pesoAresta;
+    g->pesoArestaReversa = vista->pesoArestaReversa;
+    g->pesosCopiados = vista->pesosCopiados;
+    g->pesosAlterados = 1;
+    g->versao = vista->versao;
+    g->bytesAlocados = vista->bytesAlocados;
+    return NAV_OK;
+}
+
+int navAtualizarPesos(NavGrafo* g, const NavId* arestas, const double* fatores, int total) {
+    if (total < 0) return NAV_ERRO_PARAMETRO;
+    int* indices = malloc((total + 1) * sizeof(int));
+    if (!indices) return NAV_ERRO_MEMORIA;
+
+    // Valida o lote inteiro antes de mudar qualquer peso
+    int r = NAV_OK;
+    for (int j = 0; j < total && r == NAV_OK; j++) {
+        indices[j] = buscarId(&g->idArestaParaIndice, arestas[j]);
+        if (indices[j] == -1) r = NAV_ERRO_ID;
+        else if (!(fatores[j] >= 1)) r = NAV_ERRO_PARAMETRO;   // Tambm recusa NaN
+    }
+
+    if (r == NAV_OK && total > 0) {
+        entrarEscrita(g);
+        r = publicarPesos(g, indices, fatores, total);
+        sairEscrita(g);
+    }
+    free(indices);
+    return r;
+}
+
+// ------------------------ CARGA E INFORMAES ------------------------ //
+NavGrafo* navCarregarGrafo(const char* arquivoPoly) {
+    return navCarregarGrafoComOrdem(arquivoPoly, ORDEM_ARQUIVO);
+}
+
+NavGrafo* navCarregarGrafoComOrdem(const char* arquivoPoly, int ordem) {
+    if (ordem < 0 || ordem >= TOTAL_ORDENS_VERTICES) return NULL;
+    NavGrafo* g = calloc(1, sizeof(NavGrafo));
+    if (!g) return NULL;
+    g->publicacao = calloc(1, sizeof(PublicacaoPesos));
+    // O formato  reconhecido pela assinatura, no pela extenso
+    int ok = g->publicacao != NULL
+          && (ehArquivoBinario(arquivoPoly) ? abrirArquivoBinario(g, arquivoPoly) : lerArquivoPoly(g, arquivoPoly, ordem));
+    if (!ok) {
+        navLiberarGrafo(g);
+        return NULL;
+    }
+    return g;
+}
+
+NavGrafo* navCriarGrafo(int totalVertices, const NavId* ids, const double* x, const double* y,
+                        int totalArestas, const NavId* origens, const NavId* destinos, const int* direcoes,
+                        int ordem) {
+    if (totalVertices < 0 || totalArestas < 0 || ordem < 0 || ordem >= TOTAL_ORDENS_VERTICES) return NULL;
+    NavGrafo* g = calloc(1, sizeof(NavGrafo));
+    if (!g) return NULL;
+    double ini = relogio();
+    g->totalVertices = totalVertices;
+    g->totalArestas = totalArestas;
+    g->publicacao = calloc(1, sizeof(PublicacaoPesos));
+    g->vertices = malloc((totalVertices + 1) * sizeof(Vertice));
+    int* o = malloc((totalArestas + 1) * sizeof(int));
+    int* d = malloc((totalArestas + 1) * sizeof(int));
+    int ok = g->publicacao && g->vertices && o && d && alocarTabelaIds(&g->idParaIndice, totalVertices);
+    CONTAR_BYTES(g, (totalVertices + 1) * sizeof(Vertice) + 2 * (totalArestas + 1) * sizeof(int)
+                    + (g->idParaIndice.mascara + 1) * (sizeof(NavId) + sizeof(int)));
+    for (int i = 0; ok && i < totalVertices; i++) {
+        g->vertices[i].id = ids[i];
+        g->vertices[i].x = x[i];
+        g->vertices[i].y = y[i];
+        ok = inserirId(&g->idParaIndice, ids[i], i);   // IDs duplicados so rejeitados, como no .poly
+    }
+    for (int i = 0; ok && i < totalArestas; i++) {
+        o[i] = buscarId(&g->idParaIndice, origens[i]);
+        d[i] = buscarId(&g->idParaIndice, destinos[i]);
+        ok = o[i] != -1 && d[i] != -1;
+    }
+    double meio = relogio();
+    ok = ok && reordenarVertices(g, ordem, o, d, totalArestas) && construirCSR(g, o, d, direcoes, NULL, totalArestas)
+            && construirCSRReverso(g) && registrarArestas(g, NULL) && calcularComponentes(g) && construirGrade(g);
+    free(o);
+    free(d);
+    if (ok) calcularFatorHeuristica(g);
+    if (!ok) {
+        navLiberarGrafo(g);
+        return NULL;
+    }
+    g->tempoLeitura = meio - ini;
+    g->tempoConstrucaoCSR = relogio() - meio;
+    return g;
+}
+
+NavGrafo* navCarregarMapa(const char* arquivoPoly) {
+    return navCarregarMapaComOrdem(arquivoPoly, ORDEM_ARQUIVO);
+}
+
+NavGrafo* navCarregarMapaComOrdem(const char* arquivoPoly, int ordem) {
+    char nome[4096];
+    NavGrafo* g = navCarregarGrafoComOrdem(arquivoPoly, ordem);
+    if (!g) return NULL;
+    navNomeArquivoAuxiliar(arquivoPoly, ".ch", nome, sizeof(nome));
+    carregarHierarquia(g, nome);
+    navNomeArquivoAuxiliar(arquivoPoly, ".alt", nome, sizeof(nome));
+    carregarLandmarks(g, nome);
+    return g;
+}
+
+void navLiberarGrafo(NavGrafo* g) {
+    if (!g) return;
+    if (g->publicacao) free(g->publicacao->vista);
+    free(g->publicacao);
+    liberarHierarquia(g);
+    liberarLandmarks(g);
+    if (g->mapeamento) {
+        // Os vetores apontam para dentro do arquivo mapeado, menos os pesos copiados por navAtualizarPesos
+        if (g->pesosCopiados) {
+            free(g->pesoAresta);
+            free(g->pesoArestaReversa);
+        }
+        desmapearArquivo(g->mapeamento, g->tamanhoMapeamento);
+        free(g);
+        return;
+    }
+    free(g->vertices);
+    liberarTabelaIds(&g->idParaIndice);
+    free(g->inicioAresta);
+    free(g->destinoAresta);
+    free(g->pesoAresta);
+    free(g->inicioArestaReversa);
+    free(g->origemArestaReversa);
+    free(g->pesoArestaReversa);
+    free(g->componenteForte);
+    free(g->componenteFraca);
+    free(g->grade.inicioVertices);
+    free(g->grade.verticeCelula);
+    free(g->grade.inicioArestas);
+    free(g->grade.arestaCelula);
+    free(g->inicioGeometria);
+    free(g->pontosGeometria);
+    free(g->indiceDoArquivo);
+    liberarTabelaIds(&g->idArestaParaIndice);
+    free(g->dirigidaDaAresta);
+    free(g->reversaDaDirigida);
+    free(g->pesoOriginal);
+    free(g);
+}
+
+int navSalvarBinario(const NavGrafo* g, const char* arquivo) {
+    return !g->pesosAlterados && salvarBinario(g, arquivo);
+}
+
+// O .ch foi gerado com os pesos originais: depois de navAtualizarPesos,  recustomizado ao carregar
+int navCarregarHierarquia(NavGrafo* g, const char* arquivo) {
+    descartarVista(g);
+    if (!carregarHierarquia(g, arquivo)) return 0;
+    if (g->pesosAlterados) {
+        HierarquiaCH ch;
+        if (!recustomizarHierarquia(g, &ch)) {
+            liberarHierarquia(g);
+            return 0;
+        }
+        CONTAR_BYTES(g, BYTES_ATALHOS(ch) - BYTES_ATALHOS(g->ch));
+        trocarHierarquia(g, &ch);
+    }
+    return 1;
+}
+
+int navGerarHierarquia(NavGrafo* g) {
+    descartarVista(g);
+    return construirHierarquia(g);
+}
+
+int navSalvarHierarquia(const NavGrafo* g, const char* arquivo) {
+    return g->ch.carregada && !g->pesosAlterados && salvarHierarquia(g, arquivo);
+}
+
+int navCarregarLandmarks(NavGrafo* g, const char* arquivo) {
+    descartarVista(g);
+    return carregarLandmarks(g, arquivo);
+}
+
+int navGerarLandmarks(NavGrafo* g, int k) {
+    EspacoBusca eb;
+    if (g->pesosAlterados) return 0;   // Landmarks com pesos aumentados no limitariam os pesos originais
+    if (k <= 0) k = LANDMARKS_PADRAO;
+    if (!alocarEspacoBusca(g, &eb, g->totalArestasDirigidas + 1, FILA_PADRAO)) return 0;
+    int ok = construirLandmarks(g, &eb, k);
+    liberarEspacoBusca(&eb);
+    return ok && g->alt.carregada;
+}
+
+int navSalvarLandmarks(const NavGrafo* g, const char* arquivo) {
+    return g->alt.carregada && salvarLandmarks(g, arquivo);
+}
+
+void navNomeArquivoAuxiliar(const char* arquivoPoly, const char* extensao, char* saida, int tam) {
+    size_t n = strlen(arquivoPoly);
+    if (n >= 5 && (strcmp(arquivoPoly + n - 5, ".poly") == 0 || strcmp(arquivoPoly + n - 5, ".navg") == 0)) n -= 5;
+    snprintf(saida, tam, "%.*s%s", (int)n, arquivoPoly, extensao);
+}
+
+void navInfo(const NavGrafo* grafo, NavInfo* info) {
+    int paridade;
+    const NavGrafo* g = entrarLeitura(grafo, &paridade);
+    info->totalVertices = g->totalVertices;
+    info->totalArestas = g->totalArestas;
+    info->totalArestasDirigidas = g->totalArestasDirigidas;
+    info->temHierarquia = g->ch.carregada;
+    info->arestasSubida = g->ch.subida.total;
+    info->arestasDescida = g->ch.descida.total;
+    info->totalLandmarks = g->alt.carregada ? g->alt.total : 0;
+    info->tempoLeitura = g->tempoLeitura;
+    info->tempoConstrucaoCSR = g->tempoConstrucaoCSR;
+    info->bytesAlocados = g->bytesAlocados;
+    info->totalComponentesFortes = g->totalComponentesFortes;
+    info->totalComponentesFracas = g->totalComponentesFracas;
+    info->pontosGeometria = g->inicioGeometria ? g->totalPontosGeometria : 0;
+    info->fatorHeuristica = g->fatorHeuristica;
+    info->ordemVertices = g->ordemVertices;
+    sairLeitura(grafo, paridade);
+}
+
+int navContemId(const NavGrafo* g, NavId id) {
+    return indiceDoId(g, id) != -1;
+}
+
+int navIdVertice(const NavGrafo* g, int indice, NavId* id) {
+    if (indice < 0 || indice >= g->totalVertices) return 0;
+    *id = g->vertices[g->indiceDoArquivo ? g->indiceDoArquivo[indice] : indice].id;
+    return 1;
+}
+
+int navCoordenadas(const NavGrafo* g, NavId id, double* x, double* y) {
+    int i = indiceDoId(g, id);
+    if (i == -1) return 0;
+    *x = g->vertices[i].x;
+    *y = g->vertices[i].y;
+    return 1;
+}
+
+int navComponente(const NavGrafo* g, NavId id, int* forte, int* fraca) {
+    int v = indiceDoId(g, id);
+    if (v == -1) return 0;
+    *forte = g->componenteForte[v];
+    *fraca = g->componenteFraca[v];
+    return 1;
+}
+
+void navComponentesVertices(const NavGrafo* g, int* fortes, int* fracas) {
+    for (int i = 0; i < g->totalVertices; i++) {
+        int v = g->indiceDoArquivo ? g->indiceDoArquivo[i] : i;
+        fortes[i] = g->componenteForte[v];
+        fracas[i] = g->componenteFraca[v];
+    }
+}
+
+int navCaminhoPossivel(const NavGrafo* g, NavId origemId, NavId destinoId) {
+    int origem = indiceDoId(g, origemId);
+    int destino = indiceDoId(g, destinoId);
+    if (origem == -1 || destino == -1) return NAV_ERRO_ID;
+    return caminhoPossivel(g, origem, destino);
+}
+
+int navVerticeProximo(const NavGrafo* g, double x, double y, NavId* id, double* distancia) {
+    int v = -1;
+    double d = maisProximoNaGrade(g, x, y, 0, &v, NULL, NULL);
+    if (v == -1) return 0;
+    *id = g->vertices[v].id;
+    if (distancia) *distancia = d;
+    return 1;
+}
+
+int navArestaProxima(const NavGrafo* g, double x, double y, NavPontoAresta* p) {
+    int u = -1, v = -1;
+    double fracao = 0;
+    double d = maisProximoNaGrade(g, x, y, 1, &u, &v, &fracao);
+    if (u == -1) return 0;
+    const Vertice* a = &g->vertices[u];
+    const Vertice* b = &g->vertices[v];
+    p->origem = a->id;
+    p->destino = b->id;
+    p->x = a->x + fracao * (b->x - a->x);
+    p->y = a->y + fracao * (b->y - a->y);
+    p->fracao = fracao;
+    p->distancia = d;
+    return 1;
+}
+
+int navVerticesNaRegiao(const NavGrafo* g, double x1, double y1, double x2, double y2, NavId* ids, int max) {
+    return elementosNaRegiao(g, x1, y1, x2, y2, 0, ids, NULL, max);
+}
+
+int navArestasNaRegiao(const NavGrafo* g, double x1, double y1, double x2, double y2,
+                       NavId* origens, NavId* destinos, int max) {
+    return elementosNaRegiao(g, x1, y1, x2, y2, 1, origens, destinos, max);
+}
+
+int navGeometriaCaminho(const NavGrafo* g, const NavId* caminho, int tamanho, double* x, double* y, int max) {
+    int total = 0, anterior = -1;
+    for (int i = 0; i < tamanho; i++) {
+        int v = indiceDoId(g, caminho[i]);
+        if (v == -1) return NAV_ERRO_ID;
+        if (anterior != -1) {
+            int k = pontosDaAresta(g, anterior, v, x, y, total, max);
+            if (k < 0) return NAV_ERRO_PARAMETRO;
+            total += k;
+        }
+        if (total < max) {
+            x[total] = g->vertices[v].x;
+            y[total] = g->vertices[v].y;
+        }
+        total++;
+        anterior = v;
+    }
+    return total;
+}
@@ -0,0 +1,310 @@
+/*
+    Projeto Final - AED2 - INF/UFG 2025-1
+    Tema: Sistema de Navegao Primitivo
+    Biblioteca de rotas (libnav): interface pblica
+    Autores: Ana Luisa, Isadora, Lucas e Vernica
+    Professor: Andr Luiz Moura
+
+    Uso:
+      1. navCarregarMapa() l o .poly ou o binrio .navg (e os arquivos .ch/.alt ao lado dele, se
+         existirem; o .poly tambm leva o .geo, se existir) e devolve um NavGrafo. O .navg, gerado por navSalvarBinario(),  aberto com mmap
+         em tempo constante. Os pr-processamentos (navGerarHierarquia, navGerarLandmarks...) tambm s
+         podem ser feitos nesta fase, antes de o grafo ser compartilhado.
+      2. Depois de carregado, o grafo s  alterado por navAtualizarPesos (pesos de trnsito), que
+         monta os pesos e a hierarquia novos  parte e os publica de uma vez. Ela pode rodar ao mesmo
+         tempo que as consultas, sem trava externa: cada consulta usa os pesos que encontrou ao
+         comear, e os vetores antigos s so liberados quando as consultas que os usavam terminam.
+         Vrias threads podem consultar o grafo ao mesmo tempo, cada uma com o seu NavEspaco (criado
+         com navCriarEspaco). As funes de carga e pr-processamento do item 1 continuam exigindo que
+         nenhuma consulta nem atualizao esteja em andamento.
+      3. navRota() responde uma consulta usando o espao de busca informado.
+
+    Compilao:
+      gcc -O2 -fPIC -shared nav.c -o libnav.so -lm      (Linux)
+      gcc -O2 -shared nav.c -o nav.dll -lm              (Windows)
+    Com -DNAV_METRICAS, as buscas e a carga tambm contam arestas relaxadas, operaes das filas e
+    bytes alocados (veja navMetricas); sem a opo esses contadores nem entram no cdigo compilado.
+*/
+
+#ifndef NAV_H
+#define NAV_H
+
+#define NAV_INF 1e9     // Custo devolvido quando no existe caminho
+
+// ID de vrtice como aparece no arquivo .poly. Usa 64 bits e no precisa ser denso, de modo que
+// os IDs de ns do OpenStreetMap podem ser usados diretamente
+typedef long long NavId;
+
+// Cdigos de retorno das funes de consulta (NAV_OK == 1, erros so negativos)
+#define NAV_OK                      1
+#define NAV_ERRO_ID                -1   // Origem ou destino no pertencem ao grafo
+#define NAV_ERRO_MODO              -2   // Modo de busca desconhecido
+#define NAV_ERRO_PRE_PROCESSAMENTO -3   // O modo depende de um arquivo .ch/.alt que no foi carregado
+#define NAV_ERRO_ESPACO            -4   // O espao de busca foi criado para outro grafo
+#define NAV_ERRO_MEMORIA           -5   // Memria insuficiente
+#define NAV_ERRO_PARAMETRO         -6   // Parmetro fora do intervalo vlido (ex.: limite negativo)
+
+// Algoritmos de busca disponveis, escolhidos a cada consulta
+typedef enum {
+    BUSCA_DIJKSTRA = 0,    // Dijkstra clssico: explora todo o componente alcanvel pela origem
+    BUSCA_PARADA,          // Dijkstra com parada antecipada assim que o destino  extrado da heap
+    BUSCA_ASTAR,           // A* com heurstica Euclidiana e parada antecipada no destino
+    BUSCA_BIDIRECIONAL,    // Dijkstra simultneo a partir da origem e (no grafo reverso) do destino
+    BUSCA_ASTAR_BIDIRECIONAL, // Busca bidirecional guiada por potenciais Euclidianos
+    BUSCA_CH,              // Busca bidirecional na Contraction Hierarchy pr-calculada (arquivo .ch)
+    BUSCA_ALT,             // A* com limites por landmarks e desigualdade triangular (arquivo .alt)
+    TOTAL_MODOS_BUSCA
+} ModoBusca;
+
+// Filas de prioridade das buscas, escolhidas por espao de busca (navDefinirFila)
+typedef enum {
+    FILA_BINARIA = 0,      // Heap binria com remoo preguiosa: uma entrada nova a cada melhoria (padro)
+    FILA_QUATERNARIA,      // Heap 4-ria indexada com diminuio de chave: cada vrtice no mximo uma vez
+    FILA_RADIX,            // Radix heap montona sobre chaves quantizadas em 1e-6 (exata para pesos inteiros)
+    TOTAL_TIPOS_FILA
+} TipoFila;
+
+// Ordem dos vrtices na memria, escolhida na carga (navCarregarGrafoComOrdem). Vrtices prximos
+// no mapa em posies prximas dos vetores fazem as buscas acessarem menos linhas de cache
+typedef enum {
+    ORDEM_ARQUIVO = 0,     // A ordem do .poly (padro)
+    ORDEM_HILBERT,         // Ao longo de uma curva de Hilbert sobre as coordenadas
+    ORDEM_BFS,             // Busca em largura pelas arestas, componente a componente
+    TOTAL_ORDENS_VERTICES
+} OrdemVertices;
+
+// Operaes feitas pelas filas de um espao de busca (direta e reversa somadas)
+typedef struct {
+    long insercoes;        // Entradas novas na fila
+    long diminuicoes;      // Diminuies de chave (s na fila indexada; nas outras viram inseres)
+    long extracoes;        // Extraes do mnimo, incluindo entradas antigas descartadas
+    long maiorTamanho;     // Maior quantidade de entradas em uma fila ao mesmo tempo
+} NavContadoresFila;
+
+// Mtricas da ltima consulta feita com um espao de busca (navMetricas). Os tempos so sempre
+// medidos; os contadores s so coletados com a biblioteca compilada com -DNAV_METRICAS
+typedef struct {
+    int coletadas;            // 1 se a biblioteca foi compilada com NAV_METRICAS (seno, contadores zerados)
+    long arestasRelaxadas;    // Arestas (ou atalhos da CH) examinadas a partir dos vrtices fechados
+    long insercoes;           // Entradas colocadas nas filas
+    long diminuicoes;         // Diminuies de chave (s na fila quaternaria)
+    long extracoes;           // Extraes do mnimo, incluindo as obsoletas
+    long extracoesObsoletas;  // Extraes descartadas por serem de vrtices j fechados
+    long maiorFila;           // Maior quantidade de entradas em uma fila durante a consulta
+    long long bytesEspaco;    // Bytes alocados pelo espao de busca (vetores e filas)
+    double tempoBusca;        // Segundos na busca propriamente dita
+    double tempoCaminho;      // Segundos montando o caminho (desempacotamento da CH e converso para IDs)
+    int cache;                // Uso do cache de rvores: 0 no usado, 1 acerto, 2 busca retomada, 3 falta
+} NavMetricas;
+
+// Uso do cache de rvores de um espao de busca (navDefinirCache), acumulado desde a criao
+typedef struct {
+    long acertos;          // Consultas respondidas s reconstruindo o caminho
+    long retomadas;        // Consultas que continuaram uma busca guardada que parou antes do destino
+    long faltas;           // Consultas sem rvore guardada para a origem (a rvore nova passa a ser guardada)
+    long descartes;        // rvores descartadas (as usadas h mais tempo) para respeitar o limite de memria
+    int arvores;           // rvores guardadas agora
+    long long bytes;       // Memria ocupada por elas
+} NavContadoresCache;
+
+// Ponto de uma aresta mais prximo de uma coordenada (navArestaProxima)
+typedef struct {
+    NavId origem;          // Aresta como est no grafo; as de mo dupla vm com o menor ndice interno
+    NavId destino;         // como origem
+    double x, y;           // Ponto da aresta mais prximo da coordenada
+    double fracao;         // Posio desse ponto: 0 na origem, 1 no destino
+    double distancia;      // Distncia da coordenada at o ponto
+} NavPontoAresta;
+
+// Grafo carregado (opaco); imutvel depois da fase de carga
+typedef struct NavGrafo NavGrafo;
+
+// Estado de busca de uma thread (opaco): vetores por vrtice e heaps reaproveitados entre consultas
+typedef struct NavEspaco NavEspaco;
+
+// Resultado de uma consulta
+typedef struct {
+    double custo;          // Custo total do caminho (>= NAV_INF se no existe caminho)
+    int nosExplorados;     // Quantidade de ns visitados pela busca
+    double tempo;          // Tempo da consulta em segundos (busca e montagem do caminho)
+    int tamCaminho;        // Quantidade de vrtices no caminho
+    const NavId* caminho;  // IDs originais dos vrtices, da origem at o destino; aponta para o
+                           // espao de busca e vale at a prxima consulta feita com ele
+} NavResultado;
+
+// Matriz de distncias origens x destinos
+typedef struct {
+    int totalOrigens;
+    int totalDestinos;
+    double* custos;        // custos[i * totalDestinos + j]: custo da origem i ao destino j (>= NAV_INF se no h caminho)
+    NavId** caminhos;      // Caminho de cada par em IDs originais, ou NULL se no foram pedidos
+    int* tamCaminhos;      // Quantidade de vrtices de cada caminho (0 se no h caminho)
+    long nosExplorados;    // Soma dos ns explorados por todas as buscas
+    double tempo;          // Tempo decorrido (relgio de parede) em segundos
+    int threads;           // Quantidade de threads usadas
+} NavMatriz;
+
+// rvore de caminhos mnimos a partir de uma origem, limitada por custo (navArvore)
+typedef struct {
+    double limite;         // Custo mximo pedido
+    int total;             // Vrtices alcanados com custo <= limite, incluindo a origem
+    NavId* ids;            // IDs dos vrtices alcanados, em ordem crescente de custo (a origem primeiro)
+    double* custos;        // custos[i]: custo da origem at ids[i]
+    int* anterior;         // anterior[i]: posio em ids do predecessor de ids[i] no caminho mnimo
+                           // (-1 na origem); pela ordem de custo, anterior[i] < i
+    int totalContorno;     // Vrtices do contorno da iscrona (0 se no foi pedido)
+    double* contornoX;     // Contorno: fecho convexo, no sentido anti-horrio, dos vrtices alcanados e
+    double* contornoY;     // dos pontos das arestas de sada onde o limite se esgota
+    int nosExplorados;     // Vrtices fechados pela busca (== total)
+    double tempo;          // Tempo da busca e da montagem em segundos
+} NavArvore;
+
+// Rotas alternativas entre dois vrtices (navAlternativas)
+typedef struct {
+    int total;             // Rotas encontradas (0 se no existe caminho); a primeira  a de menor custo
+                           // e as demais vm em ordem crescente de custo
+    double* custos;        // custos[i]: custo da rota i
+    double* sobreposicao;  // Frao do custo da rota i em arestas da rota 0 (1 na prpria rota 0)
+    int* inicio;           // A rota i ocupa ids[inicio[i]] .. ids[inicio[i + 1] - 1] (total + 1 posies)
+    NavId* ids;            // IDs dos vrtices das rotas, em sequncia
+    int nosExplorados;     // Vrtices fechados pelas duas buscas
+    double tempo;          // Tempo das buscas e da montagem em segundos
+} NavAlternativas;
+
+// Informaes do grafo carregado
+typedef struct {
+    int totalVertices;
+    int totalArestas;          // Arestas do arquivo .poly
+    int totalArestasDirigidas; // Arestas bidirecionais contam duas vezes
+    int temHierarquia;         // 1 se o modo "ch" est disponvel
+    int arestasSubida;         // Arestas (com atalhos) da hierarquia, se carregada
+    int arestasDescida;
+    int totalLandmarks;        // Landmarks do modo "alt" (0 se no carregados)
+    double tempoLeitura;       // Tempo de leitura do .poly em segundos
+    double tempoConstrucaoCSR; // Tempo de montagem da adjacncia em segundos
+    long long bytesAlocados;   // Bytes alocados na carga e nos pr-processamentos, incluindo vetores
+                               // temporrios (s com NAV_METRICAS; o .navg mapeado no conta)
+    int totalComponentesFortes; // Componentes fortemente conexas (respeitando o sentido das vias)
+    int totalComponentesFracas; // Componentes conexas ignorando o sentido das vias
+    int pontosGeometria;        // Pontos intermedirios das arestas lidos do .geo (0 sem .geo)
+    double fatorHeuristica;     // Fator das heursticas de distncia (menor razo peso / comprimento, at 1)
+    int ordemVertices;          // OrdemVertices usada na carga (no .navg, a da converso)
+} NavInfo;
+
+// ---- Carga e pr-processamento (antes de compartilhar o grafo entre threads) ----
+NavGrafo* navCarregarGrafo(const char* arquivoPoly);      // S o .poly (ou .navg); NULL se falhar
+NavGrafo* navCarregarMapa(const char* arquivoPoly);       // O .poly/.navg e os .ch/.alt ao lado, se existirem
+// As mesmas cargas com os vrtices do .poly na OrdemVertices dada (as de cima usam ORDEM_ARQUIVO; o .navg
+// mantm a da converso). Os IDs e as respostas no mudam; os .ch/.alt s valem para a ordem em que foram
+// gerados. NULL tambm se a ordem for invlida
+NavGrafo* navCarregarGrafoComOrdem(const char* arquivoPoly, int ordem);
+NavGrafo* navCarregarMapaComOrdem(const char* arquivoPoly, int ordem);
+void navLiberarGrafo(NavGrafo* g);
+// Monta o grafo a partir de vetores na memria, com o mesmo contedo do .poly (direcoes: 0 = mo dupla,
+// 1 = mo nica; o ID de cada aresta  a sua posio nos vetores); NULL se um ID for repetido, uma aresta
+// citar um vrtice inexistente, a OrdemVertices for invlida ou faltar memria
+NavGrafo* navCriarGrafo(int totalVertices, const NavId* ids, const double* x, const double* y,
+                        int totalArestas, const NavId* origens, const NavId* destinos, const int* direcoes,
+                        int ordem);
+int navSalvarBinario(const NavGrafo* g, const char* arquivo);    // Grava o .navg; 1 se bem sucedido
+int navCarregarHierarquia(NavGrafo* g, const char* arquivo);     // 1 se bem sucedido
+int navGerarHierarquia(NavGrafo* g);                             // Atalhos criados, ou -1
+int navSalvarHierarquia(const NavGrafo* g, const char* arquivo);
+int navCarregarLandmarks(NavGrafo* g, const char* arquivo);
+int navGerarLandmarks(NavGrafo* g, int k);                       // k <= 0 usa 8; 1 se bem sucedido
+int navSalvarLandmarks(const NavGrafo* g, const char* arquivo);
+
+// ---- Pesos dinmicos (trnsito e interdies, sem recarregar o mapa) ----
+// Multiplica o peso original (comprimento / velocidade) de cada aresta arestas[i], pelo ID do .poly,
+// por fatores[i] >= 1, nos dois sentidos da via: 1 restaura o peso original e NAV_INF ou mais interdita
+// a aresta. O lote inteiro  validado antes de mudar qualquer peso e, com o modo "ch" carregado, a
+// hierarquia  recustomizada na mesma chamada: na primeira, ela troca os atalhos da contrao por uma
+// topologia fixa que no depende dos pesos (veja PESOS DINMICOS em nav.c), e em todas s os pesos dos
+// atalhos so recalculados. Os landmarks do modo "alt" continuam vlidos.
+// Os pesos e a hierarquia novos so montados  parte e publicados de uma vez: a chamada pode rodar junto
+// com consultas de outras threads (veja o item 2 do incio do arquivo), e chamadas simultneas so feitas
+// uma por vez. Ela s volta depois que as consultas que usavam os pesos anteriores terminam. As consultas
+// que comeam depois veem todo o lote. NAV_OK, NAV_ERRO_ID (aresta inexistente), NAV_ERRO_PARAMETRO
+// (fator < 1) ou NAV_ERRO_MEMORIA (os pesos anteriores so mantidos). Depois da primeira atualizao,
+// navSalvarBinario, navSalvarHierarquia e navGerarLandmarks recusam (retornam 0), pois gravariam ou
+// calculariam dados com pesos que no so os do .poly
+int navAtualizarPesos(NavGrafo* g, const NavId* arestas, const double* fatores, int total);
+
+// Monta o nome do arquivo auxiliar trocando a extenso .poly/.navg por 'extensao' (ex.: ".ch")
+void navNomeArquivoAuxiliar(const char* arquivoPoly, const char* extensao, char* saida, int tam);
+
+// ---- Consultas (vrias threads, um NavEspaco por thread) ----
+NavEspaco* navCriarEspaco(const NavGrafo* g);                    // NULL se faltar memria
+void navLiberarEspaco(NavEspaco* e);
+int navDefinirFila(NavEspaco* e, int tipo);                      // NAV_OK, NAV_ERRO_MODO ou NAV_ERRO_MEMORIA
+void navContadoresFila(const NavEspaco* e, NavContadoresFila* c); // Acumulados desde a criao ou o ltimo zerar
+void navZerarContadoresFila(NavEspaco* e);
+void navMetricas(const NavEspaco* e, NavMetricas* m);            // Da ltima consulta feita com navRota
+// Cache LRU das rvores do Dijkstra por origem (modos dijkstra e parada), com at bytesMaximos de
+// memria; 0 desliga e libera as rvores (padro). Uma origem repetida s reconstri o caminho e uma
+// busca do modo parada que no chegou ao novo destino continua de onde parou. NAV_OK ou NAV_ERRO_MEMORIA
+int navDefinirCache(NavEspaco* e, long long bytesMaximos);
+void navContadoresCache(const NavEspaco* e, NavContadoresCache* c);
+// Se a hierarquia ganhou atalhos depois de navCriarEspaco (navAtualizarPesos, navGerarHierarquia...), as
+// filas do espao crescem na prpria consulta; NAV_ERRO_MEMORIA se faltar memria para isso
+int navRota(const NavGrafo* g, NavEspaco* e, NavId origemId, NavId destinoId, int modo, NavResultado* r);
+int navMatriz(const NavGrafo* g, const NavId* origensIds, int totalOrigens, const NavId* destinosIds,
+              int totalDestinos, int comCaminhos, NavMatriz* md);
+void navLiberarMatriz(NavMatriz* md);
+// Todos os vrtices a custo <= limite da origem (uma s busca, que para ao passar do limite); com
+// comContorno, tambm o contorno da iscrona. NAV_OK, NAV_ERRO_ID, NAV_ERRO_PARAMETRO, NAV_ERRO_ESPACO ou
+// NAV_ERRO_MEMORIA; com NAV_OK, libere com navLiberarArvore
+int navArvore(const NavGrafo* g, NavEspaco* e, NavId origemId, double limite, int comContorno, NavArvore* a);
+void navLiberarArvore(NavArvore* a);
+int navSalvarArvore(const NavArvore* a, const char* arquivo);   // Grava o formato binrio descrito em nav.c; 1 se bem sucedido
+// At k rotas sem vrtices repetidos, a primeira a de menor custo, a partir de uma busca de cada ponta
+// (plats das duas rvores; veja nav.c). Cada alternativa custa no mximo esticamento (>= 1) vezes a
+// menor e tem no mximo sobreposicaoMaxima (de 0 a 1) do seu custo em arestas das rotas escolhidas
+// antes. NAV_OK (a->total == 0 se no h caminho), NAV_ERRO_ID, NAV_ERRO_PARAMETRO, NAV_ERRO_ESPACO ou
+// NAV_ERRO_MEMORIA; com NAV_OK, libere com navLiberarAlternativas
+int navAlternativas(const NavGrafo* g, NavEspaco* e, NavId origemId, NavId destinoId, int k,
+                    double sobreposicaoMaxima, double esticamento, NavAlternativas* a);
+void navLiberarAlternativas(NavAlternativas* a);
+
+// ---- Informaes ----
+void navInfo(const NavGrafo* g, NavInfo* info);
+int navContemId(const NavGrafo* g, NavId id);                    // 1 se o ID pertence ao grafo
+int navCoordenadas(const NavGrafo* g, NavId id, double* x, double* y); // 1 se o ID pertence ao grafo
+int navIdVertice(const NavGrafo* g, int indice, NavId* id);      // ID do indice-simo vrtice do arquivo; 1 se existe
+                                                                 // (em qualquer ordem de carga)
+// Componentes calculadas na carga. As fortes so numeradas em ordem topolgica reversa: s pode haver
+// caminho de s a t se fraca(s) == fraca(t) e forte(s) >= forte(t); navRota recusa os outros pares
+// sem buscar (custo NAV_INF e 0 ns explorados)
+int navComponente(const NavGrafo* g, NavId id, int* forte, int* fraca); // 1 se o ID pertence ao grafo
+void navComponentesVertices(const NavGrafo* g, int* fortes, int* fracas); // Vetores de totalVertices, na ordem do arquivo
+int navCaminhoPossivel(const NavGrafo* g, NavId origemId, NavId destinoId); // 0 se certamente no h caminho, 1 se pode
+                                                                          // haver, NAV_ERRO_ID
+
+// ---- Consultas espaciais (grade uniforme montada na carga, gravada tambm no .navg) ----
+// Vrtice ou ponto de aresta mais prximo de (x, y): 1 se bem sucedido, 0 se o grafo no tem vrtices/arestas
+// ou a coordenada no  finita
+int navVerticeProximo(const NavGrafo* g, double x, double y, NavId* id, double* distancia);
+int navArestaProxima(const NavGrafo* g, double x, double y, NavPontoAresta* p);
+// Elementos no retngulo de cantos (x1, y1) e (x2, y2): gravam at 'max' resultados e retornam quantos
+// existem ao todo (chame de novo com vetores maiores se passar de 'max'). Uma aresta entra se algum
+// ponto dela est no retngulo, mesmo com as duas pontas fora, e as de mo dupla aparecem uma vez
+int navVerticesNaRegiao(const NavGrafo* g, double x1, double y1, double x2, double y2, NavId* ids, int max);
+int navArestasNaRegiao(const NavGrafo* g, double x1, double y1, double x2, double y2,
+                       NavId* origens, NavId* destinos, int max);
+
+// ---- Geometria das arestas (arquivo .geo do conversor com --compactar) ----
+// Pontos para desenhar um caminho (IDs de vrtices consecutivos, como em NavResultado): os vrtices e,
+// entre eles, os pontos intermedirios de cada aresta; sem .geo, s os vrtices. Grava at 'max'
+// pontos em x/y e retorna quantos existem ao todo, NAV_ERRO_ID se um ID no pertence ao grafo ou
+// NAV_ERRO_PARAMETRO se dois vrtices consecutivos no so ligados por uma aresta
+int navGeometriaCaminho(const NavGrafo* g, const NavId* caminho, int tamanho, double* x, double* y, int max);
+
+int navModoDoNome(const char* nome);                             // -1 se desconhecido
+const char* navNomeModo(int modo);                               // NULL se desconhecido
+int navTipoFilaDoNome(const char* nome);                         // -1 se desconhecido
+const char* navNomeTipoFila(int tipo);                           // NULL se desconhecido
+int navOrdemDoNome(const char* nome);                            // "arquivo", "hilbert" ou "bfs"; -1 se desconhecido
+const char* navNomeOrdem(int ordem);                             // NULL se desconhecido
+double navRelogio(void);                                         // Relgio monotnico de alta resoluo, em segundos
+
+#endif
@@ -7,6 +7,11 @@ import math
 import platform
 import subprocess
 import io
+import json
+import struct
+import array
+import mmap
+import ctypes
 import tkinter as tk
 from tkinter import filedialog
 
@@ -24,13 +29,14 @@ if platform.system() == "Windows":
 
 LARGURA, ALTURA = 1360, 685
 LARGURA_MENU = 320
-ALTURA_CAIXA_TEXTO = 360
+ALTURA_CAIXA_TEXTO = 315
 
 COR_VERTICE = (255, 105, 180)        # Rosa escuro (flat elegante)
 COR_ARESTA = (136, 14, 79)          # Tom roxo escuro, discreto
 COR_ARESTA_UNICA = (195, 65, 224)     # Roxo claro para destaque
 COR_ORIGEM = (255, 255, 0)          # Amarelo vivo para origem
 COR_DESTINO = (38, 255, 0)           # Verde para destino
+COR_INALCANCAVEL = (205, 190, 198)   # Cinza rosado para vértices que a origem não alcança
 COR_CAMINHO = (14, 21, 232)         # Azul, visível sobre fundo
 FUNDO = (252, 228, 236)              # Rosa claríssimo - fundo principal
 COR_MENU = (248, 187, 208)           # Rosa opaco - menu lateral
@@ -47,18 +53,49 @@ CAIXA_TEXTO_BORDA = (173, 20, 87)   # Borda da caixa de texto
 
 RAIO_VERTICE = 3
 
+# Algoritmos de busca do backend: (nome no protocolo, rótulo no botão)
+MODOS_BUSCA = [
+    ("dijkstra", "Dijkstra"),
+    ("parada", "Dijkstra com parada"),
+    ("astar", "A*"),
+    ("bidirecional", "Dijkstra bidirecional"),
+    ("astar_bidirecional", "A* bidirecional"),
+    ("ch", "Contraction Hierarchies"),
+    ("alt", "A* com landmarks (ALT)"),
+]
+
 # ----------------------------
 # VARIÁVEIS GLOBAIS
 # ----------------------------
 
 vertices = []           # Lista de tuplas (id, x, y) dos vértices
-arestas = []            # Lista de tuplas (origem, destino, direção)
-matriz_adj = []         # Matriz de adjacência com pesos (distâncias)
+arestas = []            # Lista de tuplas (origem, destino, direção), em índices de 'vertices'
+indice_do_id = {}       # ID do vértice no arquivo .poly -> índice em 'vertices' (os IDs podem ser esparsos)
+peso_aresta = array.array("d")  # Posição em 'arestas' -> peso (comprimento / velocidade, como no back-end)
+# Adjacência esparsa em CSR: as arestas que saem do vértice v (as de mão dupla nos dois sentidos) ocupam
+# as posições inicio_adj[v] .. inicio_adj[v + 1] - 1 de vizinho_adj (o outro vértice) e aresta_adj (a
+# posição em 'arestas'); O(n + m) de memória, em vez da matriz n x n
+inicio_adj = array.array("i")
+vizinho_adj = array.array("i")
+aresta_adj = array.array("i")
+geometria_aresta = {}   # Posição em 'arestas' -> pontos intermediários (x, y) da aresta, do .geo ou do .navg
+velocidade_aresta = {}  # Posição em 'arestas' -> velocidade da via (quinta coluna do .poly, se houver)
 arquivo_poly = ""       # Nome do arquivo .poly carregado
+processo_backend = None # Processo do backend em modo servidor, mantido durante toda a sessão
+poly_no_backend = ""    # Arquivo .poly atualmente carregado no servidor
+formato_binario = False # Se o servidor responde ROTA com quadros binários (comando FORMATO)
+biblioteca_nav = None   # libnav carregada via ctypes (False se indisponível: usa o servidor)
+grafo_nav = None        # NavGrafo* do .poly carregado na biblioteca
+espaco_nav = None       # NavEspaco* usado pelas consultas na biblioteca
+poly_na_biblioteca = "" # Arquivo .poly atualmente carregado na biblioteca
+componentes = None      # (fortes, fracas): componentes conexas de cada vértice, lidas do back-end
+visiveis = None         # (vista, vértices, posições das arestas) na área do grafo, do índice espacial do back-end
+camada_arestas = None   # (chave, Surface): arestas já desenhadas para a vista atual, refeitas só quando ela muda
+camada_vertices = None  # (chave, Surface): o mesmo para os vértices, com fundo transparente
 
 origem_selecionada = None
 destino_selecionada = None
-caminho = []            # Lista de índices dos vértices no caminho calculado
+caminho = []            # Lista de índices (em 'vertices') dos vértices no caminho calculado
 
 info_text = "Carregue um arquivo .poly para começar."  # Texto informativo na interface
 scroll_offset = 0       # Controle de scroll da caixa de texto
@@ -69,18 +106,29 @@ offset_y = 0
 
 mostrar_numeros = False
 mostrar_pesos = False
+modo_busca = 0          # Índice em MODOS_BUSCA do algoritmo usado em "Traçar menor caminho"
 
 # ----------------------------
 # FUNÇÕES DE MANIPULAÇÃO DO GRAFO
 # ----------------------------
 
 def ler_poly(nome_arquivo):
-    global vertices, arestas, matriz_adj, arquivo_poly, info_text
+    global vertices, arestas, arquivo_poly, info_text, componentes, visiveis, camada_arestas, camada_vertices
     global origem_selecionada, destino_selecionada, caminho
     try:
         arquivo_poly = nome_arquivo
+        componentes = None
+        visiveis = camada_arestas = camada_vertices = None
         vertices.clear()
         arestas.clear()
+        indice_do_id.clear()
+        geometria_aresta.clear()
+        velocidade_aresta.clear()
+        del peso_aresta[:]
+        # O .navg atualizado ao lado do .poly traz o grafo já montado; lê direto os vetores dele
+        binario = arquivo_para_backend()
+        if binario != nome_arquivo and ler_navg(binario):
+            return concluir_carga(nome_arquivo)
         with open(nome_arquivo, 'r') as f:
             linha1 = f.readline().strip().split()
             if len(linha1) < 4:
@@ -94,6 +142,7 @@ def ler_poly(nome_arquivo):
                     info_text = "Erro: Formato incorreto de vértice no arquivo."
                     return False
                 idv, x, y = linha_v
+                indice_do_id[int(idv)] = len(vertices)
                 vertices.append((int(idv), float(x), float(y)))
 
             linha2 = f.readline().strip().split()
@@ -104,32 +153,168 @@ def ler_poly(nome_arquivo):
 
             for _ in range(n_arestas):
                 linha_a = f.readline().strip().split()
-                if len(linha_a) != 4:
+                if len(linha_a) not in (4, 5):
                     info_text = "Erro: Formato incorreto de aresta no arquivo."
                     return False
-                _, o, d, dir_a = linha_a
-                arestas.append((int(o), int(d), int(dir_a)))
-
-        atualizar_matriz()
-        origem_selecionada = None
-        destino_selecionada = None
-        caminho.clear()
-        info_text = f"Arquivo carregado: {os.path.basename(nome_arquivo)}"
-        ajustar_escala()
-        return True
+                _, o, d, dir_a = linha_a[:4]
+                if len(linha_a) == 5:
+                    velocidade_aresta[len(arestas)] = float(linha_a[4])
+                if int(o) not in indice_do_id or int(d) not in indice_do_id:
+                    info_text = "Erro: Aresta com vértice inexistente no arquivo."
+                    return False
+                arestas.append((indice_do_id[int(o)], indice_do_id[int(d)], int(dir_a)))
+
+        ler_geometria(nome_arquivo)
+        calcular_pesos()
+        return concluir_carga(nome_arquivo)
     except Exception as e:
         info_text = f"Erro ao ler arquivo: {str(e)}"
         return False
 
-def atualizar_matriz():
-    global matriz_adj
+def concluir_carga(nome_arquivo):
+    """Monta a adjacência e reinicia a seleção e a vista depois de ler o grafo."""
+    global origem_selecionada, destino_selecionada, info_text
+    montar_adjacencia()
+    origem_selecionada = None
+    destino_selecionada = None
+    caminho.clear()
+    info_text = f"Arquivo carregado: {os.path.basename(nome_arquivo)}"
+    ajustar_escala()
+    return True
+
+def ler_geometria(nome_arquivo):
+    """Lê o .geo ao lado do .poly (gerado pelo conversor com --compactar), se existir: pontos
+    intermediários das arestas, da origem para o destino, pela posição da aresta no .poly."""
+    nome_geo = os.path.splitext(nome_arquivo)[0] + ".geo"
+    if not os.path.exists(nome_geo):
+        return
+    with open(nome_geo, 'r') as f:
+        for _ in range(int(f.readline())):
+            campos = f.readline().split()
+            k = int(campos[1])
+            geometria_aresta[int(campos[0])] = [(float(campos[2 + 2 * j]), float(campos[3 + 2 * j])) for j in range(k)]
+
+def calcular_pesos():
+    """Peso de cada aresta lida do .poly: o comprimento da poligonal (a reta entre as pontas, sem .geo)
+    dividido pela velocidade da via, se o .poly tiver, como nas buscas do back-end."""
+    for k, (o, d, _) in enumerate(arestas):
+        trajeto = [vertices[o][1:]] + geometria_aresta.get(k, []) + [vertices[d][1:]]
+        dist = sum(math.dist(trajeto[i], trajeto[i + 1]) for i in range(len(trajeto) - 1))
+        peso_aresta.append(dist / velocidade_aresta.get(k, 1))
+
+def montar_adjacencia():
+    """Monta o CSR de 'arestas' (contagem por vértice, soma prefixada e preenchimento)."""
+    global inicio_adj, vizinho_adj, aresta_adj
     n = len(vertices)
-    matriz_adj = [[float('inf')] * n for _ in range(n)]
+    inicio_adj = array.array("i", bytes(4 * (n + 1)))
     for o, d, dir_a in arestas:
-        dist = math.dist(vertices[o][1:], vertices[d][1:])
-        matriz_adj[o][d] = dist
+        inicio_adj[o + 1] += 1
         if dir_a == 0:
-            matriz_adj[d][o] = dist
+            inicio_adj[d + 1] += 1
+    for v in range(n):
+        inicio_adj[v + 1] += inicio_adj[v]
+    vizinho_adj = array.array("i", bytes(4 * inicio_adj[n]))
+    aresta_adj = array.array("i", bytes(4 * inicio_adj[n]))
+    cursor = inicio_adj[:n]
+    for k, (o, d, dir_a) in enumerate(arestas):
+        vizinho_adj[cursor[o]], aresta_adj[cursor[o]] = d, k
+        cursor[o] += 1
+        if dir_a == 0:
+            vizinho_adj[cursor[d]], aresta_adj[cursor[d]] = o, k
+            cursor[d] += 1
+
+def aresta_entre(o, d):
+    """Posição em 'arestas' da aresta de menor peso de o para d, ou None se não há nenhuma."""
+    melhor = None
+    for j in range(inicio_adj[o], inicio_adj[o + 1]):
+        if vizinho_adj[j] == d and (melhor is None or peso_aresta[aresta_adj[j]] < peso_aresta[melhor]):
+            melhor = aresta_adj[j]
+    return melhor
+
+# Cabeçalho do .navg (struct CabecalhoBinario de nav.c, na ordem de bytes e alinhamento da máquina):
+# assinatura, 12 inteiros (versão, marca da ordem dos bytes, vértices, arestas, arestas dirigidas,
+# componentes fortes e fracas, colunas, linhas e pares da grade, pontos da geometria e ordem dos
+# vértices), as duas máscaras das tabelas de IDs, 4 doubles e o início e o tamanho das 23 seções
+CABECALHO_NAVG = struct.Struct("@8s12i2Q4d23q23q")
+VERSAO_NAVG = 7
+MARCA_ORDEM_BYTES = 0x01020304
+# Seções usadas pelo front-end (posições no enum de nav.c)
+(SECAO_VERTICES, SECAO_DESTINO, SECAO_ORIGEM_REVERSA, SECAO_INICIO_GEOMETRIA, SECAO_PONTOS_GEOMETRIA,
+ SECAO_INDICE_DO_ARQUIVO, SECAO_DIRIGIDA_DA_ARESTA, SECAO_REVERSA_DA_DIRIGIDA, SECAO_PESO_ORIGINAL) = (
+    0, 2, 5, 15, 16, 17, 20, 21, 22)
+
+def ler_navg(nome_arquivo):
+    """Lê vértices, arestas, pesos e geometria direto das seções do .navg gerado pelo back-end, sem
+    converter texto; devolve False (e o .poly é lido) se o arquivo for de outra versão ou máquina."""
+    with open(nome_arquivo, "rb") as f, mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as mapa:
+        if len(mapa) < CABECALHO_NAVG.size:
+            return False
+        with memoryview(mapa) as dados:
+            return ler_secoes_navg(dados)
+
+def ler_secoes_navg(dados):
+    """Preenche o modelo a partir do arquivo mapeado (as seções são copiadas sem passar por texto)."""
+    campos = CABECALHO_NAVG.unpack_from(dados)
+    assinatura, versao, marca, n, a, m = campos[:6]
+    pontos_geometria = campos[11]
+    inicio, tamanho = campos[19:42], campos[42:65]
+    if assinatura != b"NAVGRF1\0" or versao != VERSAO_NAVG or marca != MARCA_ORDEM_BYTES:
+        return False
+
+    def secao(s, tipo):
+        v = array.array(tipo)
+        v.frombytes(dados[inicio[s]:inicio[s] + tamanho[s]])
+        return v
+
+    destino, origem_reversa = secao(SECAO_DESTINO, "i"), secao(SECAO_ORIGEM_REVERSA, "i")
+    dirigida, reversa = secao(SECAO_DIRIGIDA_DA_ARESTA, "i"), secao(SECAO_REVERSA_DA_DIRIGIDA, "i")
+    if len(destino) != m or len(dirigida) != 2 * a or tamanho[SECAO_VERTICES] != 24 * n:
+        return False
+
+    # Os vértices podem estar renumerados (ordem de Hilbert ou BFS); a interface usa a ordem do
+    # arquivo, como as respostas de navComponentesVertices
+    internos = list(struct.iter_unpack("=qdd", dados[inicio[SECAO_VERTICES]:inicio[SECAO_VERTICES] + 24 * n]))
+    indice_do_arquivo = secao(SECAO_INDICE_DO_ARQUIVO, "i")
+    if len(indice_do_arquivo) == n:
+        vertices.extend(internos[i] for i in indice_do_arquivo)
+        posicao = array.array("i", bytes(4 * n))
+        for p, i in enumerate(indice_do_arquivo):
+            posicao[i] = p
+    else:
+        vertices.extend(internos)
+        posicao = range(n)
+    for i, (idv, _, _) in enumerate(vertices):
+        indice_do_id[idv] = i
+
+    # A aresta k do .poly é a dirigida e = dirigida[2k] do CSR (origem -> destino) e, nas de mão
+    # dupla, também dirigida[2k + 1]; a origem de e vem do CSR reverso
+    for k in range(a):
+        e = dirigida[2 * k]
+        arestas.append((posicao[origem_reversa[reversa[e]]], posicao[destino[e]], int(dirigida[2 * k + 1] == -1)))
+    peso_aresta.extend(secao(SECAO_PESO_ORIGINAL, "d"))
+
+    if pontos_geometria > 0:
+        inicio_geometria, pontos = secao(SECAO_INICIO_GEOMETRIA, "i"), secao(SECAO_PONTOS_GEOMETRIA, "d")
+        for k in range(a):
+            e = dirigida[2 * k]
+            if inicio_geometria[e + 1] > inicio_geometria[e]:
+                trecho = pontos[2 * inicio_geometria[e]:2 * inicio_geometria[e + 1]]
+                geometria_aresta[k] = list(zip(trecho[0::2], trecho[1::2]))
+    return True
+
+def trajeto_na_tela(o, d):
+    """Pontos na tela da aresta o -> d (a de menor peso), com os pontos intermediários da geometria."""
+    k = aresta_entre(o, d)
+    pontos = geometria_aresta.get(k, []) if k is not None else []
+    if pontos and arestas[k][0] != o:
+        pontos = pontos[::-1]
+    return [transformar(*vertices[o][1:])] + [transformar(x, y) for x, y in pontos] + [transformar(*vertices[d][1:])]
+
+def trajeto_da_aresta(k):
+    """Pontos na tela da aresta na posição k de 'arestas', da origem para o destino."""
+    o, d, _ = arestas[k]
+    return ([transformar(*vertices[o][1:])] + [transformar(x, y) for x, y in geometria_aresta.get(k, ())]
+            + [transformar(*vertices[d][1:])])
 
 def ajustar_escala():
     global escala, offset_x, offset_y
@@ -165,6 +350,11 @@ def transformar(x, y):
 
 def clique(pos):
     x, y = pos
+    # Com o back-end disponível, o índice espacial dá o vértice mais próximo sem percorrer todos
+    gx, gy = (x - offset_x) / escala, (y - offset_y) / escala
+    i = vertice_proximo(gx, gy) if vertices else None
+    if i is not None:
+        return i if math.dist((gx, gy), vertices[i][1:]) * escala <= tamanho_ponto else None
     for i, (_, vx, vy) in enumerate(vertices):
         sx, sy = transformar(vx, vy)
         if (x - sx) ** 2 + (y - sy) ** 2 <= tamanho_ponto ** 2:
@@ -199,31 +389,406 @@ def copiar_imagem_para_clipboard(tela):
 # FUNÇÃO DE EXECUÇÃO DO BACKEND
 # ----------------------------
 
-def rodar_dijkstra_backend(origem, destino):
-    global caminho
-    with open("entrada.txt", "w") as f:
-        f.write(f"{origem}\n{destino}\n")
+NAV_INF = 1e9
+# Códigos de retorno da libnav (nav.h)
+NAV_OK = 1
+NAV_ERRO_ID = -1
+NAV_ERRO_PRE_PROCESSAMENTO = -3
+NAV_ERRO_MEMORIA = -5
+CACHE_ARVORES_MB = 64   # Cache de árvores por origem da libnav (o mesmo padrão do modo servidor)
+# saida.txt (rota em texto, vértice a vértice) só é gravado com NAV_SAIDA_TEXTO=1, para depuração
+GRAVAR_SAIDA_TEXTO = os.environ.get("NAV_SAIDA_TEXTO") == "1"
+# Cabeçalho do quadro binário de ROTA (struct QuadroRota de backend.c): assinatura, status, nós
+# explorados, tamanho do caminho, coordenadas, tamanho da mensagem, custo e tempo
+QUADRO_ROTA = struct.Struct("=4s5i2d")
+QUADRO_OK, QUADRO_SEM_CAMINHO, QUADRO_ERRO = 0, 1, 2
+
+class NavResultado(ctypes.Structure):
+    """Espelho da struct NavResultado de nav.h."""
+    _fields_ = [("custo", ctypes.c_double),
+                ("nosExplorados", ctypes.c_int),
+                ("tempo", ctypes.c_double),
+                ("tamCaminho", ctypes.c_int),
+                ("caminho", ctypes.POINTER(ctypes.c_longlong))]
+
+class NavMetricas(ctypes.Structure):
+    """Espelho da struct NavMetricas de nav.h."""
+    _fields_ = [("coletadas", ctypes.c_int),
+                ("arestasRelaxadas", ctypes.c_long),
+                ("insercoes", ctypes.c_long),
+                ("diminuicoes", ctypes.c_long),
+                ("extracoes", ctypes.c_long),
+                ("extracoesObsoletas", ctypes.c_long),
+                ("maiorFila", ctypes.c_long),
+                ("bytesEspaco", ctypes.c_longlong),
+                ("tempoBusca", ctypes.c_double),
+                ("tempoCaminho", ctypes.c_double),
+                ("cache", ctypes.c_int)]
+
+class NavInfo(ctypes.Structure):
+    """Espelho da struct NavInfo de nav.h."""
+    _fields_ = [("totalVertices", ctypes.c_int),
+                ("totalArestas", ctypes.c_int),
+                ("totalArestasDirigidas", ctypes.c_int),
+                ("temHierarquia", ctypes.c_int),
+                ("arestasSubida", ctypes.c_int),
+                ("arestasDescida", ctypes.c_int),
+                ("totalLandmarks", ctypes.c_int),
+                ("tempoLeitura", ctypes.c_double),
+                ("tempoConstrucaoCSR", ctypes.c_double),
+                ("bytesAlocados", ctypes.c_longlong),
+                ("totalComponentesFortes", ctypes.c_int),
+                ("totalComponentesFracas", ctypes.c_int),
+                ("pontosGeometria", ctypes.c_int),
+                ("fatorHeuristica", ctypes.c_double),
+                ("ordemVertices", ctypes.c_int)]
+
+def arquivo_para_backend():
+    """Prefere o binário .navg (gerado com 'backend --converter') ao lado do .poly, se estiver atualizado."""
+    binario = os.path.splitext(arquivo_poly)[0] + ".navg"
+    if os.path.exists(binario) and os.path.getmtime(binario) >= os.path.getmtime(arquivo_poly):
+        return binario
+    return arquivo_poly
+
+def carregar_biblioteca():
+    """Carrega a libnav (libnav.so / nav.dll) ao lado do programa; devolve None se indisponível."""
+    global biblioteca_nav
+    if biblioteca_nav is None:
+        nome = "nav.dll" if os.name == "nt" else "libnav.so"
+        caminho_lib = os.path.abspath(nome)
+        biblioteca_nav = False
+        if os.path.exists(caminho_lib):
+            try:
+                lib = ctypes.CDLL(caminho_lib)
+            except OSError:
+                lib = None
+            if lib is not None:
+                lib.navCarregarMapa.restype = ctypes.c_void_p
+                lib.navCarregarMapa.argtypes = [ctypes.c_char_p]
+                lib.navLiberarGrafo.argtypes = [ctypes.c_void_p]
+                lib.navCriarEspaco.restype = ctypes.c_void_p
+                lib.navCriarEspaco.argtypes = [ctypes.c_void_p]
+                lib.navLiberarEspaco.argtypes = [ctypes.c_void_p]
+                lib.navModoDoNome.argtypes = [ctypes.c_char_p]
+                lib.navRota.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_longlong, ctypes.c_longlong,
+                                        ctypes.c_int, ctypes.POINTER(NavResultado)]
+                lib.navMetricas.argtypes = [ctypes.c_void_p, ctypes.POINTER(NavMetricas)]
+                lib.navInfo.argtypes = [ctypes.c_void_p, ctypes.POINTER(NavInfo)]
+                lib.navComponentesVertices.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_int),
+                                                       ctypes.POINTER(ctypes.c_int)]
+                lib.navVerticeProximo.argtypes = [ctypes.c_void_p, ctypes.c_double, ctypes.c_double,
+                                                  ctypes.POINTER(ctypes.c_longlong), ctypes.POINTER(ctypes.c_double)]
+                lib.navVerticesNaRegiao.argtypes = [ctypes.c_void_p] + [ctypes.c_double] * 4 + [
+                    ctypes.POINTER(ctypes.c_longlong), ctypes.c_int]
+                lib.navArestasNaRegiao.argtypes = [ctypes.c_void_p] + [ctypes.c_double] * 4 + [
+                    ctypes.POINTER(ctypes.c_longlong), ctypes.POINTER(ctypes.c_longlong), ctypes.c_int]
+                lib.navDefinirCache.argtypes = [ctypes.c_void_p, ctypes.c_longlong]
+                biblioteca_nav = lib
+    return biblioteca_nav or None
+
+def liberar_grafo_biblioteca():
+    global grafo_nav, espaco_nav, poly_na_biblioteca
+    if biblioteca_nav:
+        biblioteca_nav.navLiberarEspaco(espaco_nav)
+        biblioteca_nav.navLiberarGrafo(grafo_nav)
+    grafo_nav = espaco_nav = None
+    poly_na_biblioteca = ""
+
+def carregar_mapa_na_biblioteca():
+    """Garante que o .poly atual está carregado na libnav; retorna False se a leitura falhar."""
+    global grafo_nav, espaco_nav, poly_na_biblioteca
+    lib = carregar_biblioteca()
+    if poly_na_biblioteca != arquivo_poly:
+        liberar_grafo_biblioteca()
+        grafo_nav = lib.navCarregarMapa(arquivo_para_backend().encode())
+        espaco_nav = lib.navCriarEspaco(grafo_nav) if grafo_nav else None
+        if not espaco_nav:
+            liberar_grafo_biblioteca()
+            return False
+        lib.navDefinirCache(espaco_nav, CACHE_ARVORES_MB * 1024 * 1024)
+        poly_na_biblioteca = arquivo_poly
+    return True
+
+def rota_pela_biblioteca(origem, destino):
+    """Consulta a rota chamando a libnav; devolve (resposta, caminho) no formato do modo servidor."""
+    lib = carregar_biblioteca()
+    if not carregar_mapa_na_biblioteca():
+        return "ERRO falha ao ler o arquivo", []
+
+    nome_modo = MODOS_BUSCA[modo_busca][0]
+    r = NavResultado()
+    status = lib.navRota(grafo_nav, espaco_nav, origem, destino, lib.navModoDoNome(nome_modo.encode()),
+                         ctypes.byref(r))
+    if status == NAV_ERRO_ID:
+        return "ERRO origem ou destino nao encontrados no grafo", []
+    if status == NAV_ERRO_PRE_PROCESSAMENTO:
+        return f"ERRO pre-processamento nao carregado (gere com --gerar-{nome_modo})", []
+    if status == NAV_ERRO_MEMORIA:
+        return "ERRO memoria insuficiente", []
+    if status != NAV_OK:
+        return f"ERRO falha na consulta (codigo {status})", []
+    if r.custo >= NAV_INF:
+        return f"SEM_CAMINHO {r.nosExplorados} {r.tempo:.6f}", []
+    return f"OK {r.custo:.6f} {r.nosExplorados} {r.tempo:.6f} {r.tamCaminho}", r.caminho[:r.tamCaminho]
+
+def metricas_da_consulta():
+    """Tempos e contadores da última rota, na ordem da resposta do comando METRICAS do servidor."""
+    if biblioteca_nav and espaco_nav:
+        m, info = NavMetricas(), NavInfo()
+        biblioteca_nav.navMetricas(espaco_nav, ctypes.byref(m))
+        biblioteca_nav.navInfo(grafo_nav, ctypes.byref(info))
+        return [m.coletadas, m.arestasRelaxadas, m.insercoes, m.diminuicoes, m.extracoes, m.extracoesObsoletas,
+                m.maiorFila, m.bytesEspaco, info.bytesAlocados, info.tempoLeitura, info.tempoConstrucaoCSR,
+                m.tempoBusca, m.tempoCaminho]
+    resposta = enviar_comando("METRICAS")
+    if resposta is None or not resposta.startswith("OK"):
+        return None
+    campos = resposta.split()[1:]
+    return [int(v) for v in campos[:9]] + [float(v) for v in campos[9:]]
+
+def escrever_saida_json(origem, destino, custo, nos, tempo, caminho_ids):
+    """Grava saida.json com a rota e as métricas da busca (formato do back-end)."""
+    dados = {"origem": origem, "destino": destino, "algoritmo": MODOS_BUSCA[modo_busca][0],
+             "existe_caminho": custo is not None, "custo": custo, "nos_explorados": nos, "caminho": caminho_ids}
+    m = metricas_da_consulta()
+    if m is not None:
+        dados["tempos_s"] = {"leitura": m[9], "construcao_csr": m[10], "busca": m[11], "caminho": m[12],
+                             "consulta": tempo}
+        dados["contadores"] = {"coletados": bool(m[0]), "arestas_relaxadas": m[1], "insercoes": m[2],
+                               "diminuicoes": m[3], "extracoes": m[4], "extracoes_obsoletas": m[5],
+                               "maior_fila": m[6]}
+        dados["memoria_bytes"] = {"grafo": m[8], "espaco_busca": m[7]}
+    else:
+        dados["tempos_s"] = {"consulta": tempo}
+    with open("saida.json", "w") as f:
+        json.dump(dados, f, indent=2)
+
+def iniciar_backend():
+    """Inicia (uma única vez por sessão) o backend em modo servidor, com as rotas em quadros binários."""
+    global processo_backend, poly_no_backend, formato_binario
+    if processo_backend is not None and processo_backend.poll() is None:
+        return processo_backend
 
     backend_exe = "backend.exe" if os.name == "nt" else "./backend"
     if not os.path.exists(backend_exe):
-        return "Erro: backend não encontrado. Compile o backend."
-
+        return None
+
+    processo_backend = subprocess.Popen([backend_exe, "--servidor"], stdin=subprocess.PIPE,
+                                        stdout=subprocess.PIPE)
+    poly_no_backend = ""
+    # Um back-end antigo responde ERRO; nesse caso as rotas continuam chegando em texto
+    processo_backend.stdin.write(b"FORMATO binario\n")
+    processo_backend.stdin.flush()
+    formato_binario = ler_linha_backend() == "OK"
+    return processo_backend
+
+def ler_linha_backend():
+    """Próxima linha de texto da resposta do servidor (o pipe é binário por causa dos quadros de ROTA)."""
+    return processo_backend.stdout.readline().decode().strip()
+
+def enviar_comando(comando):
+    """Envia uma linha ao backend e devolve a primeira linha da resposta (ou None se indisponível)."""
+    global processo_backend
+    proc = iniciar_backend()
+    if proc is None:
+        return None
+    try:
+        proc.stdin.write((comando + "\n").encode())
+        proc.stdin.flush()
+        resposta = proc.stdout.readline()
+    except (BrokenPipeError, OSError):
+        resposta = b""
+    if not resposta:
+        processo_backend = None
+        return None
+    return resposta.decode().strip()
+
+def rota_pelo_servidor(origem, destino):
+    """Consulta a rota no servidor; devolve (resposta, caminho) como rota_pela_biblioteca."""
+    global processo_backend
+    if iniciar_backend() is None:
+        return None, []
+    comando = f"ROTA {origem} {destino} {MODOS_BUSCA[modo_busca][0]}"
+    if not formato_binario:
+        resposta = enviar_comando(comando)
+        if resposta is None:
+            return None, []
+        return resposta, ler_linha_backend().split() if resposta.startswith("OK") else []
     try:
-        subprocess.run([backend_exe, arquivo_poly], check=True)
-    except subprocess.CalledProcessError:
+        processo_backend.stdin.write((comando + "\n").encode())
+        processo_backend.stdin.flush()
+        cabecalho = processo_backend.stdout.read(QUADRO_ROTA.size)
+    except (BrokenPipeError, OSError):
+        cabecalho = b""
+    if len(cabecalho) < QUADRO_ROTA.size:
+        processo_backend = None
+        return None, []
+    _, status, nos, tam, coordenadas, tam_mensagem, custo, tempo = QUADRO_ROTA.unpack(cabecalho)
+    # Os IDs chegam como um bloco de inteiros de 8 bytes, convertido de uma vez
+    caminho_rota = array.array("q")
+    caminho_rota.frombytes(processo_backend.stdout.read(8 * tam))
+    processo_backend.stdout.read(16 * tam * coordenadas)
+    mensagem = processo_backend.stdout.read(tam_mensagem).decode()
+    if status == QUADRO_ERRO:
+        return f"ERRO {mensagem}", []
+    if status == QUADRO_SEM_CAMINHO:
+        return f"SEM_CAMINHO {nos} {tempo:.6f}", []
+    return f"OK {custo:.6f} {nos} {tempo:.6f} {tam}", caminho_rota
+
+def carregar_mapa_no_backend():
+    """Garante que o .poly atual está carregado no servidor; retorna mensagem de erro ou None."""
+    global poly_no_backend
+    if poly_no_backend == arquivo_poly:
+        return None
+    resposta = enviar_comando(f"CARREGAR {arquivo_para_backend()}")
+    if resposta is None:
+        return "Erro: backend não encontrado. Compile o backend."
+    if not resposta.startswith("OK"):
         return "Erro na execução do backend."
+    poly_no_backend = arquivo_poly
+    return None
+
+def encerrar_backend():
+    global processo_backend
+    liberar_grafo_biblioteca()
+    if processo_backend is not None and processo_backend.poll() is None:
+        try:
+            processo_backend.stdin.write(b"SAIR\n")
+            processo_backend.stdin.flush()
+            processo_backend.wait(timeout=2)
+        except (OSError, subprocess.TimeoutExpired):
+            processo_backend.kill()
+    processo_backend = None
+
+def carregar_componentes():
+    """Lê as componentes conexas de cada vértice (na ordem de 'vertices'), pela libnav ou pelo servidor."""
+    global componentes
+    if componentes is not None or not vertices:
+        return
+    if carregar_biblioteca() is not None:
+        if not carregar_mapa_na_biblioteca():
+            return
+        fortes, fracas = (ctypes.c_int * len(vertices))(), (ctypes.c_int * len(vertices))()
+        biblioteca_nav.navComponentesVertices(grafo_nav, fortes, fracas)
+        componentes = (list(fortes), list(fracas))
+    elif carregar_mapa_no_backend() is None:
+        resposta = enviar_comando("COMPONENTES")
+        if resposta is None or not resposta.startswith("OK"):
+            return
+        fortes = [int(c) for c in ler_linha_backend().split()]
+        fracas = [int(c) for c in ler_linha_backend().split()]
+        componentes = (fortes, fracas)
+
+def alcance_possivel(destino):
+    """False se as componentes garantem que não há caminho da origem selecionada até 'destino'."""
+    if origem_selecionada is None or componentes is None:
+        return True
+    fortes, fracas = componentes
+    # As componentes fortes vêm numeradas em ordem topológica reversa (veja nav.h)
+    return fracas[origem_selecionada] == fracas[destino] and fortes[origem_selecionada] >= fortes[destino]
+
+def vertice_proximo(x, y):
+    """Índice do vértice mais próximo de (x, y) pelo índice espacial do back-end; None se indisponível."""
+    if carregar_biblioteca() is not None:
+        if not carregar_mapa_na_biblioteca():
+            return None
+        id_v, distancia = ctypes.c_longlong(), ctypes.c_double()
+        if not biblioteca_nav.navVerticeProximo(grafo_nav, x, y, ctypes.byref(id_v), ctypes.byref(distancia)):
+            return None
+        return indice_do_id.get(id_v.value)
+    if carregar_mapa_no_backend() is not None:
+        return None
+    resposta = enviar_comando(f"PROXIMO {x!r} {y!r}")
+    if resposta is None or not resposta.startswith("OK"):
+        return None
+    return indice_do_id.get(int(resposta.split()[1]))
+
+def elementos_na_regiao(x1, y1, x2, y2):
+    """(índices dos vértices, posições em 'arestas') no retângulo, pelo back-end; None se indisponível."""
+    if carregar_biblioteca() is not None:
+        if not carregar_mapa_na_biblioteca():
+            return None
+        lib = biblioteca_nav
+        ids = (ctypes.c_longlong * max(1, len(vertices)))()
+        total_v = lib.navVerticesNaRegiao(grafo_nav, x1, y1, x2, y2, ids, len(ids))
+        ids_vertices = ids[:total_v]
+        # Arestas duplicadas no arquivo podem passar do tamanho de 'arestas'; nesse caso repete com o total
+        total_a, capacidade = 0, len(arestas)
+        while True:
+            origens = (ctypes.c_longlong * max(1, capacidade))()
+            destinos = (ctypes.c_longlong * max(1, capacidade))()
+            total_a = lib.navArestasNaRegiao(grafo_nav, x1, y1, x2, y2, origens, destinos, len(origens))
+            if total_a <= len(origens):
+                break
+            capacidade = total_a
+        pares = list(zip(origens[:total_a], destinos[:total_a]))
+    else:
+        if carregar_mapa_no_backend() is not None:
+            return None
+        resposta = enviar_comando(f"REGIAO {x1!r} {y1!r} {x2!r} {y2!r}")
+        if resposta is None or not resposta.startswith("OK"):
+            return None
+        ids_vertices = [int(t) for t in ler_linha_backend().split()]
+        numeros = [int(t) for t in ler_linha_backend().split()]
+        pares = list(zip(numeros[0::2], numeros[1::2]))
+    indices = [indice_do_id[i] for i in ids_vertices]
+    visiveis_arestas = [k for k in (aresta_entre(indice_do_id[o], indice_do_id[d]) for o, d in pares) if k is not None]
+    return indices, visiveis_arestas
+
+def elementos_visiveis():
+    """Vértices e arestas na área do grafo na tela; sem o back-end, todos. Só consulta quando a vista muda."""
+    global visiveis
+    vista = (arquivo_poly, escala, offset_x, offset_y, tamanho_ponto)
+    if visiveis is None or visiveis[0] != vista:
+        # Margem para os círculos dos vértices logo fora da borda, que ainda aparecem em parte
+        margem = tamanho_ponto + 2
+        regiao = None
+        if vertices:
+            regiao = elementos_na_regiao((LARGURA_MENU - margem - offset_x) / escala, (-margem - offset_y) / escala,
+                                         (LARGURA + margem - offset_x) / escala, (ALTURA + margem - offset_y) / escala)
+        visiveis = (vista,) + (regiao or (range(len(vertices)), range(len(arestas))))
+    return visiveis[1], visiveis[2]
+
+def rodar_dijkstra_backend(origem, destino):
+    global caminho
+    # A interface trabalha com índices em 'vertices'; o back-end, com os IDs do arquivo .poly
+    origem, destino = vertices[origem][0], vertices[destino][0]
+    # Com a libnav compilada, a rota é calculada no próprio processo; senão, pelo servidor
+    if carregar_biblioteca() is not None:
+        resposta, caminho_rota = rota_pela_biblioteca(origem, destino)
+    else:
+        erro = carregar_mapa_no_backend()
+        if erro:
+            return erro
+        resposta, caminho_rota = rota_pelo_servidor(origem, destino)
+        if resposta is None:
+            return "Erro na execução do backend."
+    if resposta.startswith("ERRO"):
+        return f"Erro no backend: {resposta[5:]}"
 
     caminho.clear()
-    resultado_texto = ""
-    with open("saida.txt", "r") as f:
-        linhas = f.readlines()
-        for linha in linhas:
-            resultado_texto += linha
-            if linha.startswith("Caminho"):
-                continue
-            if "(" in linha and "x=" in linha and "y=" in linha:
-                idx = int(linha.split()[0])
-                caminho.append(idx)
+    campos = resposta.split()
+    custo = None
+    if campos[0] == "SEM_CAMINHO":
+        resultado_texto = f"Não existe caminho entre {origem} e {destino}\n"
+        nos, tempo = int(campos[1]), float(campos[2])
+    else:
+        custo, nos, tempo = float(campos[1]), int(campos[2]), float(campos[3])
+        caminho.extend(indice_do_id[int(v)] for v in caminho_rota)
+        resultado_texto = f"Custo total do caminho: {custo:.2f} unidades\n"
+        resultado_texto += f"Nós explorados: {nos}\n"
+        resultado_texto += f"Algoritmo: {MODOS_BUSCA[modo_busca][0]}\n"
+        resultado_texto += "\nCaminho (do início ao fim):\n"
+        for idx in caminho:
+            idv, x, y = vertices[idx]
+            resultado_texto += f"{idv} (x={x:.3f}, y={y:.3f})\n"
+    resultado_texto += f"\nTempo de execução: {tempo:.4f} segundos\n"
+
+    # saida.txt, o registro em texto da versão que executava um processo por rota, agora é opcional
+    if GRAVAR_SAIDA_TEXTO:
+        with open("saida.txt", "w") as f:
+            f.write(resultado_texto)
+    escrever_saida_json(origem, destino, custo, nos, tempo, [vertices[idx][0] for idx in caminho])
 
     return resultado_texto
 
@@ -284,9 +849,58 @@ def desenhar_legenda_caixa(tela, fonte):
         texto_y += espacamento_y
 
 
+def desenhar_camada_arestas(fonte_pesos):
+    """Superfície da área do grafo com as arestas visíveis (e os pesos), refeita só quando a vista muda."""
+    global camada_arestas
+    chave = (arquivo_poly, escala, offset_x, offset_y, tamanho_ponto, mostrar_pesos)
+    if camada_arestas is None or camada_arestas[0] != chave:
+        camada = pygame.Surface((LARGURA - LARGURA_MENU, ALTURA))
+        camada.fill(FUNDO)
+        _, arestas_visiveis = elementos_visiveis()
+        for k in arestas_visiveis:
+            o, d, dir_a = arestas[k]
+            # Coordenadas da tela deslocadas para a camada, que começa na borda do menu
+            trajeto = [(x - LARGURA_MENU, y) for x, y in trajeto_da_aresta(k)]
+            cor = COR_ARESTA_UNICA if dir_a == 1 else COR_ARESTA
+            pygame.draw.lines(camada, cor, False, trajeto, 2)
+            if mostrar_pesos:
+                (x1, y1), (x2, y2) = trajeto[0], trajeto[-1]
+                texto_peso = fonte_pesos.render(f"{peso_aresta[k]:.2f}", True, (0, 0, 0))
+                camada.blit(texto_peso, texto_peso.get_rect(center=((x1 + x2) // 2, (y1 + y2) // 2)))
+        camada_arestas = (chave, camada)
+    return camada_arestas[1]
+
+def desenhar_camada_vertices(fonte_numeros):
+    """Superfície transparente com os vértices visíveis, refeita quando a vista ou a seleção muda."""
+    global camada_vertices
+    chave = (arquivo_poly, escala, offset_x, offset_y, tamanho_ponto, mostrar_numeros, origem_selecionada,
+             destino_selecionada, componentes is not None)
+    if camada_vertices is None or camada_vertices[0] != chave:
+        camada = pygame.Surface((LARGURA - LARGURA_MENU, ALTURA), pygame.SRCALPHA)
+        vertices_visiveis, _ = elementos_visiveis()
+        for i in vertices_visiveis:
+            sx, sy = transformar(*vertices[i][1:])
+            sx -= LARGURA_MENU
+            if i == origem_selecionada:
+                # Círculo maior atrás para destaque da origem
+                pygame.draw.circle(camada, (178, 181, 9), (sx, sy), tamanho_ponto + 2)
+                pygame.draw.circle(camada, COR_ORIGEM, (sx, sy), tamanho_ponto)
+            elif i == destino_selecionada:
+                # Círculo maior atrás para destaque do destino
+                pygame.draw.circle(camada, (11, 176, 74), (sx, sy), tamanho_ponto + 2)
+                pygame.draw.circle(camada, COR_DESTINO, (sx, sy), tamanho_ponto)
+            else:
+                cor = COR_VERTICE if alcance_possivel(i) else COR_INALCANCAVEL
+                pygame.draw.circle(camada, cor, (sx, sy), tamanho_ponto)
+            if mostrar_numeros:
+                texto_num = fonte_numeros.render(str(vertices[i][0]), True, (0, 0, 0))
+                camada.blit(texto_num, (sx - 10, sy - 20))
+        camada_vertices = (chave, camada)
+    return camada_vertices[1]
+
 def desenhar_interface():
     global origem_selecionada, destino_selecionada, caminho, info_text, scroll_offset, tamanho_ponto
-    global mostrar_numeros, mostrar_pesos, offset_x, offset_y, escala
+    global mostrar_numeros, mostrar_pesos, offset_x, offset_y, escala, modo_busca
 
     pygame.init()
     tela = pygame.display.set_mode((LARGURA, ALTURA))
@@ -307,6 +921,7 @@ def desenhar_interface():
         "Traçar menor caminho",
         "Salvar imagem do grafo",
         "Alterar tamanho do ponto",
+        "Algoritmo",
     ]
 
     botoes = []
@@ -353,7 +968,8 @@ def desenhar_interface():
             hover = botao_rect.collidepoint(mouse_x, mouse_y)
             pygame.draw.rect(tela, COR_BOTAO_HOVER if hover else COR_BOTAO, botao_rect, border_radius=8)
             pygame.draw.rect(tela, COR_BORDA_BOTAO, botao_rect, 2, border_radius=8)
-            texto_render = fonte_botoes.render(txt, True, COR_TEXTO)
+            rotulo = f"Algoritmo: {MODOS_BUSCA[modo_busca][1]}" if txt == "Algoritmo" else txt
+            texto_render = fonte_botoes.render(rotulo, True, COR_TEXTO)
             texto_rect = texto_render.get_rect(center=botao_rect.center)
             tela.blit(texto_render, texto_rect)
 
@@ -438,42 +1054,16 @@ def desenhar_interface():
         area_grafo_rect = pygame.Rect(LARGURA_MENU, 0, LARGURA - LARGURA_MENU, ALTURA)
         tela.set_clip(area_grafo_rect)
 
-        # Desenha arestas
-        for o, d, dir_a in arestas:
-            x1, y1 = transformar(*vertices[o][1:])
-            x2, y2 = transformar(*vertices[d][1:])
-            cor = COR_ARESTA_UNICA if dir_a == 1 else COR_ARESTA
-            pygame.draw.line(tela, cor, (x1, y1), (x2, y2), 2)
-            if mostrar_pesos:
-                dist = matriz_adj[o][d]
-                mx, my = (x1 + x2) // 2, (y1 + y2) // 2
-                texto_peso = fonte_pesos.render(f"{dist:.2f}", True, (0, 0, 0))
-                texto_rect = texto_peso.get_rect(center=(mx, my))
-                tela.blit(texto_peso, texto_rect)
+        # Arestas e vértices são desenhados em camadas guardadas, refeitas só quando a vista ou a seleção
+        # muda; a cada quadro, só as camadas e o caminho vão para a tela
+        tela.blit(desenhar_camada_arestas(fonte_pesos), (LARGURA_MENU, 0))
 
         # Desenha caminho
         if caminho:
             for i in range(len(caminho) - 1):
-                x1, y1 = transformar(*vertices[caminho[i]][1:])
-                x2, y2 = transformar(*vertices[caminho[i + 1]][1:])
-                pygame.draw.line(tela, COR_CAMINHO, (x1, y1), (x2, y2), 5)
+                pygame.draw.lines(tela, COR_CAMINHO, False, trajeto_na_tela(caminho[i], caminho[i + 1]), 5)
 
-        # Desenha vértices
-        for i, (_, x, y) in enumerate(vertices):
-            sx, sy = transformar(x, y)
-            if i == origem_selecionada:
-                 # Círculo maior atrás para destaque da origem
-                pygame.draw.circle(tela, (178, 181, 9), (sx, sy), tamanho_ponto + 2)
-                pygame.draw.circle(tela, COR_ORIGEM, (sx, sy), tamanho_ponto)
-            elif i == destino_selecionada:
-                # Círculo maior atrás para destaque do destino
-                pygame.draw.circle(tela, (11, 176, 74), (sx, sy), tamanho_ponto + 2)
-                pygame.draw.circle(tela, COR_DESTINO, (sx, sy), tamanho_ponto)
-            else:
-                pygame.draw.circle(tela, COR_VERTICE, (sx, sy), tamanho_ponto)
-            if mostrar_numeros:
-                texto_num = fonte_numeros.render(str(i), True, (0, 0, 0))
-                tela.blit(texto_num, (sx - 10, sy - 20))
+        tela.blit(desenhar_camada_vertices(fonte_numeros), (LARGURA_MENU, 0))
 
         # Libera clipping para UI
         tela.set_clip(None)
@@ -573,6 +1163,9 @@ def desenhar_interface():
                                 except Exception as e:
                                     info_text = f"Imagem salva, mas falha ao copiar para clipboard: {str(e)}"
 
+                            elif txt == "Algoritmo":
+                                modo_busca = (modo_busca + 1) % len(MODOS_BUSCA)
+                                info_text = f"Algoritmo selecionado: {MODOS_BUSCA[modo_busca][1]}"
                             elif txt.startswith("+ Tamanho ponto"):
                                 tamanho_ponto = min(tamanho_ponto + 1, 15)
                             elif txt.startswith("- Tamanho ponto"):
@@ -597,6 +1190,7 @@ def desenhar_interface():
                                 if idx_vertice is not None:
                                     if origem_selecionada is None:
                                         origem_selecionada = idx_vertice
+                                        carregar_componentes()
                                         info_text = f"Origem selecionada: {idx_vertice}"
                                     elif destino_selecionada is None:
                                         destino_selecionada = idx_vertice
@@ -604,10 +1198,12 @@ def desenhar_interface():
                                     else:
                                         origem_selecionada = idx_vertice
                                         destino_selecionada = None
+                                        carregar_componentes()
                                         caminho.clear()
                                         info_text = f"Origem selecionada: {idx_vertice}. Selecione destino."
 
     pygame.quit()
+    encerrar_backend()
 
 # ----------------------------
 # EXECUTA A INTERFACE
@@ -0,0 +1,152 @@
+/*
+    Projeto Final - AED2 - INF/UFG 2025-1
+    Tema: Sistema de Navegao Primitivo
+    Teste dos pesos dinmicos com a Contraction Hierarchy (nav.h / nav.c)
+    Autores: Ana Luisa, Isadora, Lucas e Vernica
+    Professor: Andr Luiz Moura
+
+    Compilao: gcc -O2 teste_pesos.c nav.c -o teste_pesos -lm
+    Uso: teste_pesos [lado] [rodadas]     (padro: grade de 40 x 40, at 40 rodadas de PESOS)
+
+    Gera uma grade irregular, monta a hierarquia e cria um espao de busca por tipo de fila. Depois
+    aplica lotes de fatores sorteados com navAtualizarPesos at a hierarquia recustomizada ficar maior
+    que a do momento em que os espaos foram criados, e confere as rotas do modo ch feitas com esses
+    mesmos espaos contra as do Dijkstra. Termina com 0 se todas as rotas conferem e a hierarquia
+    cresceu, 1 se no (sem crescimento, o teste no exercitou espaos menores que a hierarquia).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "nav.h"
+
+#define CONSULTAS_POR_RODADA 200
+
+static unsigned long long proximoAleatorio(unsigned long long* estado) {
+    *estado = *estado * 6364136223846793005ULL + 1442695040888963407ULL;
+    return *estado >> 33;
+}
+
+// Grade lado x lado de mo dupla com as coordenadas deslocadas, para os pesos no empatarem
+static NavGrafo* gerarGrade(int lado, unsigned long long* estado) {
+    int n = lado * lado, m = 0;
+    NavId* ids = malloc(n * sizeof(NavId));
+    double* x = malloc(n * sizeof(double));
+    double* y = malloc(n * sizeof(double));
+    NavId* origens = malloc(2 * n * sizeof(NavId));
+    NavId* destinos = malloc(2 * n * sizeof(NavId));
+    int* direcoes = calloc(2 * n, sizeof(int));
+    NavGrafo* g = NULL;
+    if (ids && x && y && origens && destinos && direcoes) {
+        for (int v = 0; v < n; v++) {
+            ids[v] = v + 1;
+            x[v] = (v % lado) * 100.0 + (double)(proximoAleatorio(estado) % 4000) / 100.0;
+            y[v] = (v / lado) * 100.0 + (double)(proximoAleatorio(estado) % 4000) / 100.0;
+            if (v % lado + 1 < lado) { origens[m] = v + 1; destinos[m++] = v + 2; }
+            if (v / lado + 1 < lado) { origens[m] = v + 1; destinos[m++] = v + lado + 1; }
+        }
+        g = navCriarGrafo(n, ids, x, y, m, origens, destinos, direcoes, ORDEM_HILBERT);
+    }
+    free(ids); free(x); free(y);
+    free(origens); free(destinos); free(direcoes);
+    return g;
+}
+
+// Maior CSR que as filas do modo ch precisam comportar (veja capacidadeHeapConsultas em nav.c)
+static int maiorCSR(const NavGrafo* g) {
+    NavInfo info;
+    navInfo(g, &info);
+    int maior = info.totalArestasDirigidas;
+    if (info.arestasSubida > maior) maior = info.arestasSubida;
+    if (info.arestasDescida > maior) maior = info.arestasDescida;
+    return maior;
+}
+
+// Confere rotas sorteadas do modo ch, em cada espao, contra o Dijkstra. Retorna as divergncias
+static int conferirRotas(const NavGrafo* g, NavEspaco** espacos, int totalEspacos, int n, unsigned long long* estado) {
+    int divergencias = 0;
+    for (int i = 0; i < CONSULTAS_POR_RODADA; i++) {
+        NavId origem = 1 + (NavId)(proximoAleatorio(estado) % n);
+        NavId destino = 1 + (NavId)(proximoAleatorio(estado) % n);
+        NavResultado ref, r;
+        if (navRota(g, espacos[0], origem, destino, BUSCA_DIJKSTRA, &ref) != NAV_OK) return -1;
+        for (int t = 0; t < totalEspacos; t++) {
+            int status = navRota(g, espacos[t], origem, destino, BUSCA_CH, &r);
+            if (status != NAV_OK) {
+                printf("divergncia (%s): %lld -> %lld, ch falhou com status %d, dijkstra %.6lf\n",
+                       navNomeTipoFila(t), (long long)origem, (long long)destino, status, ref.custo);
+                divergencias++;
+            } else if (fabs(r.custo - ref.custo) > 1e-6 * (ref.custo > 1 ? ref.custo : 1)) {
+                printf("divergncia (%s): %lld -> %lld, ch %.6lf, dijkstra %.6lf\n", navNomeTipoFila(t),
+                       (long long)origem, (long long)destino, r.custo, ref.custo);
+                divergencias++;
+            }
+        }
+    }
+    return divergencias;
+}
+
+int main(int argc, char* argv[]) {
+    int lado = argc >= 2 ? atoi(argv[1]) : 40;
+    int rodadas = argc >= 3 ? atoi(argv[2]) : 40;
+    if (lado < 2 || rodadas < 1) {
+        printf("Uso: teste_pesos [lado >= 2] [rodadas >= 1]\n");
+        return 1;
+    }
+    unsigned long long estado = 42;
+    NavGrafo* g = gerarGrade(lado, &estado);
+    if (!g || navGerarHierarquia(g) < 0) {
+        printf("Erro: memria insuficiente para montar a grade e a hierarquia\n");
+        navLiberarGrafo(g);
+        return 1;
+    }
+    NavInfo info;
+    navInfo(g, &info);
+
+    // Os espaos so criados com a hierarquia original e usados em todas as rodadas
+    NavEspaco* espacos[TOTAL_TIPOS_FILA] = { NULL };
+    for (int t = 0; t < TOTAL_TIPOS_FILA; t++) {
+        espacos[t] = navCriarEspaco(g);
+        if (!espacos[t] || navDefinirFila(espacos[t], t) != NAV_OK) {
+            printf("Erro: memria insuficiente para os espaos de busca\n");
+            return 1;
+        }
+    }
+    int capacidadeInicial = maiorCSR(g);
+    int divergencias = conferirRotas(g, espacos, TOTAL_TIPOS_FILA, info.totalVertices, &estado);
+
+    // A primeira recustomizao troca os atalhos da contrao pelos da topologia fixa, que so mais
+    // numerosos em qualquer grade que no seja mnima
+    NavId* arestas = malloc(info.totalArestas * sizeof(NavId));
+    double* fatores = malloc(info.totalArestas * sizeof(double));
+    int rodada = 0, cresceu = 0;
+    for (; arestas && fatores && divergencias == 0 && rodada < rodadas; rodada++) {
+        int total = 0;
+        for (int a = 0; a < info.totalArestas; a++) {
+            if (proximoAleatorio(&estado) % 3 != 0) continue;
+            arestas[total] = a;
+            fatores[total++] = 1.0 + (double)(proximoAleatorio(&estado) % 5000) / 100.0;
+        }
+        if (navAtualizarPesos(g, arestas, fatores, total) != NAV_OK) {
+            printf("Erro: navAtualizarPesos falhou na rodada %d\n", rodada + 1);
+            divergencias = -1;
+            break;
+        }
+        if (maiorCSR(g) > capacidadeInicial) cresceu = 1;
+        divergencias = conferirRotas(g, espacos, TOTAL_TIPOS_FILA, info.totalVertices, &estado);
+        if (cresceu) {
+            rodada++;
+            break;
+        }
+    }
+    navInfo(g, &info);
+    printf("%d rodadas | hierarquia %d/%d arestas (maior CSR %d, era %d) | %s\n", rodada, info.arestasSubida,
+           info.arestasDescida, maiorCSR(g), capacidadeInicial,
+           divergencias != 0 ? "FALHOU" : cresceu ? "ok" : "FALHOU: a hierarquia no cresceu");
+
+    free(arestas);
+    free(fatores);
+    for (int t = 0; t < TOTAL_TIPOS_FILA; t++) navLiberarEspaco(espacos[t]);
+    navLiberarGrafo(g);
+    return divergencias != 0 || !cresceu;
+}